@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#endif
+#include "proj2.h"
+
+/******************************************************************/
+/* bench measures the throughput of the simulator on a suite of   */
+/* workloads, such as those in bench/, each in each of the output */
+/* modes verbose (with the dump going to /dev/null), quiet and    */
+/* functional. Every run executes in a child process of its own,  */
+/* so its peak memory is its own, and repeats the simulation for */
+/* at least MINSECONDS to even out timer noise. Loading the       */
+/* program is not timed; simCreate, simRun and simDestroy are.    */
+/*   bench [-m modes] [-n runs] [-x file] [-c baseline [-t pct]]  */
+/*         workload.s ...                                         */
+/*   -m LIST   comma separated modes (default: all three)         */
+/*   -n N      runs per workload and mode, keeping the fastest    */
+/*   -x FILE   write the results to FILE, as CSV if it ends in    */
+/*             .csv and as JSON otherwise (default: JSON to       */
+/*             stdout)                                            */
+/*   -c FILE   compare with a CSV written by an earlier bench and */
+/*             exit with status 2 if any workload and mode got    */
+/*             more than -t percent (default 10) slower           */
+/* A workload may start with a "# words: I D" line giving its     */
+/* instruction and data memory sizes (default 16 and 16).         */
+/* Simulated units are cycles, or instructions for functional     */
+/* runs. Host instructions come from the hardware counters where  */
+/* the kernel allows it and are reported as -1 otherwise.         */
+/******************************************************************/
+
+#define MODE_VERBOSE 0
+#define MODE_QUIET 1
+#define MODE_FUNCTIONAL 2
+#define NUMMODES 3
+
+#define MINSECONDS 0.25    /* Shortest measured time of a run */
+
+static const char *modeNames[NUMMODES] = {"verbose", "quiet", "functional"};
+
+/* The outcome of one run, sent from the child to the parent */
+typedef struct measureStruct {
+  long long simulated;                    /* Cycles, or instructions when functional, */
+                                          /* summed over the repetitions */
+  double seconds;                         /* Wall time of all repetitions */
+  long long hostInstructions;             /* User-mode instructions executed, -1 if unknown */
+  long peakKilobytes;                     /* Peak resident set of the child */
+  char error[ERRORLENGTH];                /* Empty unless the run failed */
+} measureType;
+
+/* A line of a baseline CSV */
+typedef struct baselineStruct {
+  char workload[256];
+  char mode[16];
+  double perSecond;
+} baselineType;
+
+/* Starts counting this process's user-mode instructions; returns the counter or -1 */
+int hostCounterOpen(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/* Reads the instruction memory and data memory sizes from a "# words: I D" first line */
+void readWords(FILE *file, optionsType *options)
+{
+    char line[256];
+
+    if(fgets(line, sizeof(line), file) != NULL)
+        sscanf(line, "# words: %d %d", &options->instrSize, &options->dataSize);
+    rewind(file);
+}
+
+double now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/******************************************************************/
+/* The runChild function performs one run in the child process    */
+/* and writes its measureType to fd.                              */
+/******************************************************************/
+void runChild(char *name, int mode, int fd)
+{
+    measureType measure;
+    optionsType options;
+    programType program;
+    resultsType results;
+    simulatorType *sim;
+    FILE *file;
+    long long count;
+    double start;
+    int counter;
+
+    memset(&measure, 0, sizeof(measure));
+    measure.hostInstructions = -1;
+    defaultOptions(&options);
+    options.outputMode = mode == MODE_VERBOSE ? VERBOSE : QUIET;
+    options.functional = mode == MODE_FUNCTIONAL;
+
+    file = fopen(name, "r");
+    if(file == NULL)
+        snprintf(measure.error, ERRORLENGTH, "cannot open %s", name);
+    else{
+        readWords(file, &options);
+        if(loadProgram(&program, &options, file, measure.error) == 0){
+            /* The dump is measured as main.c produces it, into a large buffer */
+            if(mode == MODE_VERBOSE && freopen("/dev/null", "w", stdout) != NULL)
+                setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+            counter = hostCounterOpen();
+            start = now();
+            do{
+                sim = simCreate(&options, &program);
+                if(sim == NULL){
+                    snprintf(measure.error, ERRORLENGTH, "out of memory");
+                    break;
+                }
+                if(simRun(sim) == SIM_ERROR){
+                    snprintf(measure.error, ERRORLENGTH, "%s", simGetError(sim));
+                    simDestroy(sim);
+                    break;
+                }
+                simGetResults(sim, &results);
+                measure.simulated += results.functional ? results.instructions : results.cycles;
+                simDestroy(sim);
+                fflush(stdout);
+                measure.seconds = now() - start;
+            }while(measure.seconds < MINSECONDS);
+            if(counter >= 0 && read(counter, &count, sizeof(count)) == sizeof(count))
+                measure.hostInstructions = count;
+        }
+    }
+    if(write(fd, &measure, sizeof(measure)) != sizeof(measure))
+        _exit(1);
+    _exit(0);
+}
+
+/******************************************************************/
+/* The measure function forks a child for one run, waits for it   */
+/* and fills in the result with the child's peak memory.          */
+/******************************************************************/
+void measure(char *name, int mode, measureType *result)
+{
+    struct rusage usage;
+    int fds[2];
+    int status;
+    pid_t pid;
+
+    if(pipe(fds) != 0){
+        fprintf(stderr, "error: cannot create a pipe\n");
+        exit(1);
+    }
+    fflush(stdout);
+    pid = fork();
+    if(pid < 0){
+        fprintf(stderr, "error: cannot fork\n");
+        exit(1);
+    }
+    if(pid == 0){
+        close(fds[0]);
+        runChild(name, mode, fds[1]);
+    }
+    close(fds[1]);
+    memset(result, 0, sizeof(measureType));
+    if(read(fds[0], result, sizeof(measureType)) != sizeof(measureType))
+        snprintf(result->error, ERRORLENGTH, "the run crashed");
+    close(fds[0]);
+    if(wait4(pid, &status, 0, &usage) == pid)
+        result->peakKilobytes = usage.ru_maxrss;
+}
+
+/* Simulated units per host second */
+double perSecond(measureType *measure)
+{
+    return measure->seconds > 0 ? measure->simulated / measure->seconds : 0.0;
+}
+
+/* Host instructions per simulated unit, or -1 if unknown */
+double hostPerUnit(measureType *measure)
+{
+    return measure->hostInstructions >= 0 && measure->simulated ?
+           (double)measure->hostInstructions / measure->simulated : -1.0;
+}
+
+/******************************************************************/
+/* The readBaseline function reads the CSV of an earlier bench    */
+/* run, returning the number of lines read into baseline.         */
+/******************************************************************/
+int readBaseline(char *name, baselineType **baseline)
+{
+    char line[1024];
+    FILE *file = fopen(name, "r");
+    int count = 0, capacity = 16;
+
+    if(file == NULL){
+        fprintf(stderr, "error: cannot open baseline %s\n", name);
+        exit(1);
+    }
+    *baseline = malloc(sizeof(baselineType) * capacity);
+    while(*baseline != NULL && fgets(line, sizeof(line), file) != NULL){
+        if(count == capacity){
+            capacity *= 2;
+            *baseline = realloc(*baseline, sizeof(baselineType) * capacity);
+            if(*baseline == NULL)
+                break;
+        }
+        if(sscanf(line, "%255[^,],%15[^,],%*[^,],%*[^,],%lf", (*baseline)[count].workload,
+                  (*baseline)[count].mode, &(*baseline)[count].perSecond) == 3)
+            count++;
+    }
+    if(*baseline == NULL){
+        fprintf(stderr, "error: out of memory\n");
+        exit(1);
+    }
+    fclose(file);
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    baselineType *baseline = NULL;
+    measureType *results, run;
+    char *outputName = NULL, *baselineName = NULL;
+    int modes[NUMMODES] = {MODE_VERBOSE, MODE_QUIET, MODE_FUNCTIONAL};
+    int modeCount = NUMMODES, runs = 1, threshold = 10, baselineCount = 0;
+    int workloads, csv = 0, regressed = 0;
+    int arg, w, m, r, i;
+    char *token;
+    FILE *output = stdout;
+
+    for(arg = 1; arg < argc && argv[arg][0] == '-'; arg++){
+        if(strcmp(argv[arg], "-m") == 0 && arg + 1 < argc){
+            modeCount = 0;
+            for(token = strtok(argv[++arg], ","); token != NULL; token = strtok(NULL, ",")){
+                for(i = 0; i < NUMMODES && strcmp(token, modeNames[i]) != 0; i++)
+                    ;
+                if(i == NUMMODES || modeCount == NUMMODES){
+                    fprintf(stderr, "error: unknown mode '%s'\n", token);
+                    exit(1);
+                }
+                modes[modeCount++] = i;
+            }
+        }
+        else if(strcmp(argv[arg], "-n") == 0 && arg + 1 < argc){
+            runs = atoi(argv[++arg]);
+            if(runs < 1){
+                fprintf(stderr, "error: -n expects a positive number of runs\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[arg], "-x") == 0 && arg + 1 < argc)
+            outputName = argv[++arg];
+        else if(strcmp(argv[arg], "-c") == 0 && arg + 1 < argc)
+            baselineName = argv[++arg];
+        else if(strcmp(argv[arg], "-t") == 0 && arg + 1 < argc)
+            threshold = atoi(argv[++arg]);
+        else
+            break;
+    }
+    if(arg >= argc || modeCount == 0){
+        fprintf(stderr, "usage: %s [-m verbose,quiet,functional] [-n runs] [-x file] [-c baseline.csv [-t percent]]\n"
+                        "\tworkload.s ...\n", argv[0]);
+        exit(1);
+    }
+    if(baselineName != NULL)
+        baselineCount = readBaseline(baselineName, &baseline);
+
+    workloads = argc - arg;
+    results = malloc(sizeof(measureType) * workloads * modeCount);
+    if(results == NULL){
+        fprintf(stderr, "error: out of memory\n");
+        exit(1);
+    }
+    for(w = 0; w < workloads; w++)
+        for(m = 0; m < modeCount; m++){
+            measureType *best = &results[w * modeCount + m];
+            for(r = 0; r < runs; r++){
+                measure(argv[arg + w], modes[m], &run);
+                if(run.error[0] != '\0'){
+                    fprintf(stderr, "error: %s, %s: %s\n", argv[arg + w], modeNames[modes[m]], run.error);
+                    exit(1);
+                }
+                if(r == 0 || run.seconds < best->seconds)
+                    *best = run;
+            }
+        }
+
+    if(outputName != NULL){
+        size_t length = strlen(outputName);
+        csv = length > 4 && strcmp(outputName + length - 4, ".csv") == 0;
+        output = fopen(outputName, "w");
+        if(output == NULL){
+            fprintf(stderr, "error: cannot create %s\n", outputName);
+            exit(1);
+        }
+    }
+    if(csv)
+        fprintf(output, "workload,mode,simulated,seconds,per_second,host_instructions_per_unit,peak_kb\n");
+    else
+        fprintf(output, "[\n");
+    for(w = 0; w < workloads; w++)
+        for(m = 0; m < modeCount; m++){
+            measureType *result = &results[w * modeCount + m];
+            if(csv)
+                fprintf(output, "%s,%s,%lld,%.6f,%.0f,%.1f,%ld\n", argv[arg + w], modeNames[modes[m]],
+                        result->simulated, result->seconds, perSecond(result), hostPerUnit(result),
+                        result->peakKilobytes);
+            else
+                fprintf(output, "  {\"workload\": \"%s\", \"mode\": \"%s\", \"simulated\": %lld, \"seconds\": %.6f, "
+                                "\"per_second\": %.0f, \"host_instructions_per_unit\": %.1f, \"peak_kb\": %ld}%s\n",
+                        argv[arg + w], modeNames[modes[m]], result->simulated, result->seconds,
+                        perSecond(result), hostPerUnit(result), result->peakKilobytes,
+                        w == workloads - 1 && m == modeCount - 1 ? "" : ",");
+
+            for(i = 0; i < baselineCount; i++)
+                if(strcmp(baseline[i].workload, argv[arg + w]) == 0 && strcmp(baseline[i].mode, modeNames[modes[m]]) == 0 &&
+                   perSecond(result) < baseline[i].perSecond * (100 - threshold) / 100){
+                    fprintf(stderr, "regression: %s, %s: %.0f per second, down from %.0f\n", argv[arg + w],
+                            modeNames[modes[m]], perSecond(result), baseline[i].perSecond);
+                    regressed = 1;
+                }
+        }
+    if(!csv)
+        fprintf(output, "]\n");
+    if(output != stdout && fclose(output) != 0){
+        fprintf(stderr, "error: cannot write %s\n", outputName);
+        exit(1);
+    }
+    free(results);
+    free(baseline);
+    return regressed ? 2 : 0;
+}
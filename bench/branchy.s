@@ -0,0 +1,19 @@
+# words: 32 16
+# Branch-heavy loops: 20000 iterations of an outer loop around an inner
+# loop of 4 iterations and a branch that alternates between taken and
+# not taken, which defeats a single shared counter.
+        lw      $1,one($0)
+        lw      $2,outer($0)
+        add     $5,$0,$0
+loop:   lw      $3,inner($0)
+in:     sub     $3,$3,$1
+        bne     $3,$0,in
+        sub     $5,$1,$5        # flips between 1 and 0
+        bne     $5,$0,skip
+        add     $6,$6,$1
+skip:   sub     $2,$2,$1
+        bne     $2,$0,loop
+        halt
+one:    .fill 1
+outer:  .fill 20000
+inner:  .fill 4
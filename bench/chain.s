@@ -0,0 +1,16 @@
+# words: 32 32
+# Dependent load chains: 50000 steps around a circular linked list,
+# each loading the next pointer, then the value through it, then adding
+# the value, so every instruction waits for the load before it.
+        lw      $1,one($0)
+        lw      $2,count($0)
+        add     $4,$0,$0        # the list starts at address 0
+loop:   lw      $4,0($4)
+        lw      $5,4($4)
+        add     $6,$6,$5
+        sub     $2,$2,$1
+        bne     $2,$0,loop
+        halt
+list:   .fill 8,1,16,2,24,3,32,4,40,5,48,6,56,7,0,8
+one:    .fill 1
+count:  .fill 50000
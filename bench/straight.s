@@ -0,0 +1,1037 @@
+# words: 1040 16
+# Large straight-line code: 300 passes over a body of 1024 instructions
+# without branches, a mix of ALU operations, loads and stores on
+# registers $3 to $7 and a 12-word scratch area.
+        lw      $1,one($0)
+        lw      $2,reps($0)
+loop:
+        lw      $7,4($0)
+        sub     $5,$7,$5
+        sub     $3,$5,$6
+        sub     $3,$5,$5
+        add     $3,$4,$3
+        sub     $3,$3,$6
+        sub     $6,$6,$5
+        add     $6,$4,$7
+        add     $4,$6,$4
+        sub     $3,$7,$6
+        sub     $6,$7,$3
+        sub     $5,$6,$7
+        sw      $3,12($0)
+        sub     $6,$6,$3
+        lw      $5,8($0)
+        sub     $6,$5,$4
+        sub     $5,$3,$3
+        sub     $3,$6,$3
+        sub     $3,$4,$6
+        lw      $3,4($0)
+        sub     $5,$6,$3
+        sub     $3,$6,$4
+        sub     $7,$5,$3
+        sub     $5,$4,$5
+        add     $3,$5,$4
+        sub     $7,$6,$7
+        sub     $7,$5,$7
+        sw      $5,40($0)
+        lw      $7,16($0)
+        lw      $7,24($0)
+        sw      $3,12($0)
+        sub     $3,$7,$7
+        sw      $5,44($0)
+        sub     $5,$5,$5
+        sub     $3,$7,$6
+        add     $5,$3,$5
+        sub     $7,$5,$3
+        sub     $3,$4,$6
+        add     $4,$6,$7
+        add     $3,$7,$6
+        add     $7,$5,$4
+        add     $5,$4,$4
+        add     $7,$6,$4
+        sub     $5,$7,$6
+        sub     $3,$4,$5
+        sub     $7,$4,$7
+        sub     $3,$7,$6
+        add     $7,$3,$6
+        sub     $6,$5,$6
+        sub     $3,$7,$4
+        lw      $7,12($0)
+        sub     $6,$4,$7
+        sub     $4,$7,$6
+        sub     $6,$7,$3
+        add     $4,$3,$5
+        add     $7,$6,$5
+        sw      $6,0($0)
+        add     $6,$3,$5
+        lw      $6,36($0)
+        sw      $4,16($0)
+        add     $7,$5,$3
+        add     $3,$7,$6
+        add     $3,$6,$6
+        sub     $5,$4,$3
+        sw      $3,0($0)
+        add     $3,$5,$6
+        sub     $3,$7,$7
+        add     $5,$7,$6
+        add     $7,$6,$3
+        sub     $4,$7,$4
+        sub     $4,$7,$3
+        lw      $4,16($0)
+        sub     $7,$7,$6
+        add     $7,$7,$6
+        add     $5,$7,$4
+        lw      $7,12($0)
+        sw      $3,44($0)
+        sub     $6,$6,$4
+        lw      $7,4($0)
+        lw      $6,32($0)
+        sw      $7,36($0)
+        lw      $6,36($0)
+        sub     $6,$6,$7
+        sub     $4,$7,$7
+        sw      $4,0($0)
+        lw      $6,36($0)
+        add     $3,$5,$4
+        sub     $3,$7,$7
+        sw      $6,0($0)
+        add     $6,$4,$5
+        sub     $4,$5,$4
+        lw      $5,16($0)
+        sub     $5,$7,$6
+        sw      $3,12($0)
+        add     $5,$4,$4
+        add     $7,$3,$5
+        sw      $5,32($0)
+        lw      $6,40($0)
+        sub     $6,$6,$6
+        lw      $3,4($0)
+        lw      $7,20($0)
+        lw      $4,12($0)
+        sub     $5,$7,$6
+        add     $5,$5,$7
+        sub     $6,$5,$7
+        sw      $3,28($0)
+        sw      $5,28($0)
+        add     $7,$7,$4
+        sub     $6,$5,$5
+        add     $6,$3,$4
+        sw      $6,36($0)
+        sub     $5,$7,$5
+        sub     $4,$5,$7
+        sw      $4,40($0)
+        add     $6,$3,$5
+        sub     $5,$5,$4
+        sub     $7,$7,$5
+        sw      $6,16($0)
+        lw      $6,8($0)
+        add     $5,$6,$5
+        add     $5,$3,$5
+        add     $4,$6,$6
+        sw      $7,8($0)
+        sw      $5,44($0)
+        sw      $6,40($0)
+        lw      $6,36($0)
+        add     $3,$5,$3
+        sub     $7,$4,$4
+        lw      $6,32($0)
+        sub     $4,$4,$6
+        add     $7,$3,$7
+        sw      $4,24($0)
+        sw      $6,32($0)
+        sw      $7,40($0)
+        sw      $7,4($0)
+        sub     $7,$7,$5
+        lw      $7,20($0)
+        sw      $6,12($0)
+        add     $6,$7,$6
+        sub     $6,$3,$6
+        add     $6,$3,$3
+        add     $5,$5,$5
+        sub     $4,$6,$7
+        sw      $6,44($0)
+        sub     $3,$4,$6
+        sub     $5,$5,$5
+        add     $7,$6,$4
+        add     $4,$7,$4
+        sw      $6,24($0)
+        sub     $4,$3,$3
+        add     $7,$6,$6
+        add     $5,$4,$5
+        add     $6,$5,$5
+        sub     $5,$4,$3
+        add     $5,$3,$7
+        sub     $5,$7,$7
+        sw      $3,32($0)
+        sub     $3,$3,$7
+        add     $7,$5,$6
+        sw      $6,44($0)
+        add     $3,$4,$7
+        sub     $5,$6,$5
+        lw      $5,20($0)
+        add     $6,$6,$6
+        lw      $3,12($0)
+        lw      $4,28($0)
+        sub     $3,$6,$6
+        add     $7,$5,$4
+        sub     $4,$7,$5
+        lw      $4,8($0)
+        sw      $4,24($0)
+        sw      $6,20($0)
+        sub     $5,$5,$4
+        lw      $4,40($0)
+        lw      $4,40($0)
+        add     $5,$5,$5
+        sub     $4,$7,$3
+        lw      $5,8($0)
+        sub     $5,$4,$4
+        add     $4,$7,$6
+        lw      $6,36($0)
+        sub     $3,$7,$3
+        lw      $5,32($0)
+        sw      $7,20($0)
+        add     $6,$4,$4
+        sub     $4,$5,$4
+        sub     $6,$5,$7
+        sub     $6,$5,$3
+        sub     $7,$7,$3
+        add     $4,$3,$7
+        sub     $6,$4,$4
+        add     $4,$5,$6
+        lw      $3,20($0)
+        sw      $3,12($0)
+        lw      $3,0($0)
+        sub     $7,$4,$6
+        sw      $4,28($0)
+        add     $7,$6,$7
+        add     $6,$6,$4
+        add     $4,$5,$6
+        add     $6,$5,$3
+        lw      $5,44($0)
+        sub     $6,$7,$4
+        add     $4,$7,$7
+        lw      $7,24($0)
+        add     $4,$4,$5
+        lw      $4,16($0)
+        sub     $3,$7,$5
+        add     $4,$7,$5
+        lw      $3,24($0)
+        add     $7,$4,$7
+        lw      $3,0($0)
+        add     $5,$6,$5
+        sub     $6,$3,$4
+        lw      $6,20($0)
+        lw      $5,32($0)
+        sub     $5,$4,$5
+        sub     $6,$6,$6
+        add     $4,$3,$7
+        sw      $7,16($0)
+        sub     $3,$3,$6
+        sw      $6,28($0)
+        add     $5,$7,$4
+        lw      $3,28($0)
+        sw      $3,20($0)
+        add     $5,$4,$7
+        lw      $4,12($0)
+        sw      $5,44($0)
+        sw      $4,44($0)
+        add     $6,$6,$5
+        sub     $7,$4,$4
+        sub     $7,$5,$7
+        sub     $7,$7,$5
+        sub     $4,$4,$6
+        sub     $3,$7,$3
+        sw      $5,0($0)
+        add     $5,$3,$3
+        sub     $6,$5,$4
+        sub     $7,$5,$4
+        add     $6,$3,$5
+        add     $3,$5,$7
+        sw      $3,24($0)
+        sw      $3,16($0)
+        sub     $5,$4,$4
+        add     $5,$5,$7
+        sw      $3,32($0)
+        add     $6,$6,$3
+        add     $3,$5,$3
+        sw      $3,24($0)
+        add     $7,$6,$3
+        lw      $7,44($0)
+        lw      $4,16($0)
+        add     $7,$4,$4
+        add     $5,$6,$4
+        add     $7,$6,$6
+        add     $4,$4,$5
+        add     $4,$6,$5
+        lw      $4,32($0)
+        sub     $7,$6,$5
+        sub     $7,$4,$6
+        sw      $7,20($0)
+        sub     $3,$6,$3
+        sw      $7,4($0)
+        add     $5,$4,$7
+        sub     $3,$3,$6
+        sub     $4,$6,$7
+        add     $5,$5,$5
+        sub     $3,$6,$4
+        add     $7,$5,$5
+        sub     $4,$7,$5
+        sub     $5,$7,$6
+        add     $3,$7,$3
+        add     $5,$3,$6
+        add     $4,$7,$3
+        lw      $7,16($0)
+        sw      $4,8($0)
+        lw      $5,24($0)
+        add     $7,$6,$5
+        add     $5,$6,$7
+        sw      $5,24($0)
+        add     $6,$5,$3
+        lw      $7,28($0)
+        add     $6,$7,$7
+        sub     $6,$4,$7
+        sub     $7,$7,$7
+        sw      $5,0($0)
+        sub     $4,$4,$4
+        sw      $7,40($0)
+        lw      $6,0($0)
+        sw      $7,16($0)
+        sw      $4,0($0)
+        sub     $5,$4,$4
+        sub     $7,$6,$7
+        sub     $4,$3,$3
+        sw      $7,40($0)
+        sub     $6,$4,$4
+        add     $3,$6,$4
+        add     $3,$6,$6
+        lw      $4,40($0)
+        add     $6,$7,$4
+        add     $7,$5,$4
+        sub     $7,$7,$7
+        lw      $4,24($0)
+        lw      $6,40($0)
+        lw      $4,12($0)
+        sub     $6,$6,$5
+        sub     $7,$7,$7
+        add     $4,$3,$7
+        sw      $7,32($0)
+        sub     $5,$5,$3
+        add     $5,$6,$7
+        lw      $4,12($0)
+        sw      $3,8($0)
+        lw      $5,0($0)
+        sub     $7,$7,$4
+        sub     $7,$3,$4
+        sub     $3,$4,$5
+        sub     $5,$3,$4
+        sub     $3,$7,$3
+        sw      $5,8($0)
+        lw      $6,40($0)
+        sub     $5,$4,$7
+        sub     $6,$3,$5
+        add     $5,$4,$6
+        sub     $4,$7,$7
+        sw      $7,0($0)
+        add     $6,$4,$5
+        sw      $7,8($0)
+        sw      $7,24($0)
+        lw      $6,28($0)
+        sub     $6,$7,$6
+        lw      $6,24($0)
+        sub     $6,$5,$4
+        sub     $7,$3,$6
+        sw      $7,0($0)
+        lw      $7,8($0)
+        sw      $3,20($0)
+        sub     $6,$3,$5
+        lw      $5,28($0)
+        sub     $6,$3,$4
+        add     $3,$3,$7
+        sub     $4,$7,$3
+        lw      $5,40($0)
+        add     $3,$6,$3
+        sub     $6,$3,$6
+        sub     $6,$6,$3
+        lw      $6,24($0)
+        lw      $4,8($0)
+        sw      $3,16($0)
+        sw      $6,4($0)
+        lw      $4,28($0)
+        sub     $6,$6,$3
+        sub     $4,$7,$7
+        lw      $4,28($0)
+        add     $6,$4,$5
+        add     $6,$6,$7
+        sub     $3,$7,$5
+        lw      $4,16($0)
+        lw      $3,16($0)
+        sub     $7,$3,$4
+        sub     $4,$6,$6
+        sw      $5,0($0)
+        sub     $4,$6,$6
+        add     $4,$7,$7
+        lw      $6,44($0)
+        sub     $3,$7,$3
+        add     $3,$7,$6
+        add     $7,$3,$6
+        add     $4,$4,$3
+        add     $7,$3,$3
+        sw      $4,36($0)
+        sub     $4,$4,$4
+        sub     $5,$4,$7
+        add     $4,$3,$4
+        add     $6,$3,$6
+        add     $5,$7,$6
+        add     $6,$3,$7
+        lw      $4,32($0)
+        sub     $6,$5,$7
+        sw      $3,44($0)
+        sub     $7,$6,$7
+        add     $6,$6,$5
+        sw      $6,40($0)
+        add     $6,$7,$7
+        add     $3,$4,$4
+        lw      $6,4($0)
+        add     $7,$5,$5
+        sub     $6,$6,$4
+        sw      $3,4($0)
+        sub     $5,$3,$4
+        lw      $7,44($0)
+        add     $7,$4,$4
+        add     $7,$5,$4
+        add     $5,$3,$4
+        sub     $3,$3,$4
+        sub     $6,$6,$6
+        sub     $7,$5,$7
+        sw      $5,8($0)
+        sub     $3,$5,$3
+        lw      $7,12($0)
+        sub     $5,$4,$5
+        add     $7,$6,$5
+        sw      $7,12($0)
+        lw      $4,44($0)
+        sub     $4,$4,$7
+        sub     $5,$6,$4
+        sub     $6,$4,$6
+        sw      $4,12($0)
+        add     $6,$4,$4
+        sub     $3,$5,$4
+        sub     $3,$5,$4
+        sub     $5,$5,$5
+        sub     $4,$7,$4
+        sw      $7,40($0)
+        sub     $7,$5,$4
+        add     $7,$4,$7
+        add     $5,$5,$3
+        lw      $4,0($0)
+        sub     $7,$3,$3
+        lw      $4,8($0)
+        sw      $7,8($0)
+        sub     $5,$4,$5
+        sub     $4,$7,$6
+        add     $4,$5,$5
+        add     $5,$5,$7
+        add     $3,$7,$7
+        sw      $7,8($0)
+        add     $4,$7,$3
+        add     $6,$4,$5
+        lw      $5,32($0)
+        add     $3,$4,$5
+        lw      $4,16($0)
+        sub     $7,$5,$5
+        lw      $3,8($0)
+        sw      $4,12($0)
+        sub     $7,$3,$4
+        sw      $5,44($0)
+        lw      $6,16($0)
+        sub     $5,$5,$6
+        sub     $4,$4,$4
+        sub     $4,$4,$5
+        sw      $6,36($0)
+        sub     $5,$5,$4
+        sub     $7,$7,$6
+        add     $5,$3,$6
+        add     $3,$3,$6
+        sub     $7,$5,$6
+        add     $7,$3,$4
+        sub     $3,$7,$7
+        sub     $3,$5,$5
+        sw      $6,44($0)
+        lw      $7,12($0)
+        sub     $4,$4,$4
+        add     $5,$5,$6
+        add     $5,$6,$4
+        sw      $5,28($0)
+        lw      $3,32($0)
+        sub     $6,$4,$7
+        sub     $5,$7,$3
+        add     $4,$3,$6
+        lw      $5,4($0)
+        add     $6,$3,$6
+        sw      $4,44($0)
+        sub     $5,$6,$6
+        add     $4,$7,$4
+        sub     $7,$7,$7
+        add     $3,$6,$6
+        sw      $6,16($0)
+        lw      $7,32($0)
+        add     $7,$6,$5
+        sub     $4,$3,$3
+        lw      $6,0($0)
+        add     $3,$5,$5
+        add     $6,$3,$4
+        add     $3,$4,$4
+        lw      $3,4($0)
+        add     $7,$6,$6
+        sub     $4,$3,$5
+        add     $7,$5,$7
+        sw      $6,0($0)
+        lw      $7,4($0)
+        sub     $5,$6,$3
+        lw      $6,20($0)
+        add     $6,$5,$3
+        sw      $6,8($0)
+        sw      $7,32($0)
+        lw      $5,12($0)
+        lw      $4,8($0)
+        sub     $3,$5,$4
+        sub     $5,$3,$3
+        add     $7,$3,$5
+        sw      $5,24($0)
+        lw      $5,8($0)
+        lw      $7,44($0)
+        add     $5,$6,$5
+        sw      $5,32($0)
+        sub     $7,$3,$5
+        add     $3,$3,$4
+        sub     $7,$4,$4
+        sub     $4,$3,$4
+        sub     $7,$6,$5
+        add     $5,$5,$3
+        sw      $3,40($0)
+        sw      $7,8($0)
+        add     $7,$6,$5
+        sub     $5,$4,$5
+        sw      $7,8($0)
+        sub     $4,$4,$4
+        add     $4,$4,$5
+        sub     $7,$6,$3
+        sw      $7,44($0)
+        add     $5,$5,$3
+        add     $7,$7,$6
+        sw      $5,8($0)
+        sub     $4,$4,$3
+        add     $5,$4,$5
+        lw      $7,28($0)
+        add     $5,$7,$5
+        sub     $5,$3,$4
+        sw      $5,4($0)
+        sw      $6,8($0)
+        lw      $3,32($0)
+        sub     $4,$3,$3
+        add     $4,$7,$4
+        lw      $6,20($0)
+        sw      $5,12($0)
+        sub     $4,$3,$5
+        lw      $7,12($0)
+        sub     $3,$4,$7
+        sub     $7,$7,$3
+        lw      $5,24($0)
+        add     $6,$5,$3
+        sub     $4,$6,$4
+        add     $4,$4,$7
+        add     $6,$3,$3
+        add     $7,$7,$3
+        sub     $6,$6,$6
+        add     $3,$4,$7
+        lw      $5,4($0)
+        add     $7,$3,$7
+        add     $4,$6,$4
+        sw      $4,28($0)
+        sub     $7,$7,$4
+        add     $5,$6,$5
+        lw      $6,40($0)
+        sub     $3,$3,$7
+        add     $3,$6,$5
+        add     $4,$4,$3
+        add     $7,$5,$5
+        lw      $4,8($0)
+        sub     $4,$4,$6
+        add     $6,$7,$6
+        lw      $3,12($0)
+        sw      $7,20($0)
+        lw      $3,16($0)
+        add     $5,$3,$5
+        sub     $5,$5,$3
+        sub     $5,$6,$6
+        add     $6,$3,$6
+        add     $7,$3,$6
+        add     $3,$4,$4
+        sw      $7,4($0)
+        sub     $5,$3,$3
+        sub     $6,$4,$5
+        sub     $3,$5,$4
+        sub     $4,$7,$6
+        add     $3,$3,$3
+        add     $7,$5,$7
+        lw      $3,0($0)
+        sub     $7,$7,$7
+        add     $7,$7,$6
+        sub     $3,$3,$4
+        sub     $3,$3,$5
+        add     $5,$5,$7
+        sub     $3,$5,$5
+        sub     $6,$5,$7
+        add     $6,$5,$3
+        lw      $3,0($0)
+        lw      $5,28($0)
+        add     $4,$4,$3
+        add     $3,$7,$3
+        add     $4,$4,$4
+        sub     $3,$6,$3
+        add     $5,$6,$5
+        sub     $4,$5,$4
+        add     $3,$6,$3
+        lw      $5,4($0)
+        lw      $5,28($0)
+        lw      $3,8($0)
+        sub     $7,$5,$5
+        sw      $5,32($0)
+        sub     $7,$4,$6
+        sub     $7,$4,$4
+        add     $4,$7,$3
+        lw      $7,0($0)
+        sub     $7,$3,$4
+        sub     $3,$5,$7
+        lw      $4,32($0)
+        sub     $3,$6,$7
+        add     $5,$5,$5
+        sub     $4,$5,$3
+        sub     $5,$5,$5
+        lw      $5,36($0)
+        sub     $7,$7,$4
+        sub     $7,$7,$7
+        add     $6,$5,$3
+        add     $5,$4,$3
+        add     $6,$4,$4
+        sub     $3,$7,$3
+        add     $6,$6,$4
+        lw      $6,4($0)
+        sub     $7,$4,$5
+        sub     $4,$4,$5
+        sub     $3,$3,$5
+        add     $7,$7,$5
+        lw      $6,24($0)
+        sw      $6,44($0)
+        sw      $3,4($0)
+        add     $4,$7,$4
+        sub     $5,$6,$5
+        sw      $6,16($0)
+        sub     $5,$7,$6
+        lw      $7,20($0)
+        add     $5,$5,$6
+        sw      $3,20($0)
+        lw      $5,4($0)
+        lw      $7,40($0)
+        sub     $5,$6,$5
+        sw      $7,4($0)
+        sub     $7,$5,$7
+        add     $6,$7,$4
+        sw      $6,12($0)
+        sub     $7,$6,$6
+        add     $6,$4,$6
+        add     $3,$4,$4
+        sub     $3,$4,$3
+        sw      $3,12($0)
+        sw      $4,12($0)
+        lw      $6,0($0)
+        sub     $7,$3,$5
+        sub     $4,$5,$5
+        add     $4,$4,$7
+        lw      $7,20($0)
+        sub     $6,$3,$7
+        sw      $6,16($0)
+        lw      $5,4($0)
+        lw      $3,36($0)
+        sub     $5,$5,$7
+        sw      $5,16($0)
+        add     $3,$6,$6
+        sub     $6,$7,$4
+        lw      $7,36($0)
+        lw      $7,40($0)
+        sw      $4,24($0)
+        sub     $6,$7,$5
+        sub     $7,$7,$7
+        add     $6,$6,$5
+        sw      $4,44($0)
+        add     $5,$4,$3
+        lw      $5,8($0)
+        sw      $7,20($0)
+        add     $5,$6,$6
+        add     $4,$6,$4
+        add     $3,$7,$3
+        lw      $7,16($0)
+        sub     $3,$3,$3
+        lw      $5,4($0)
+        add     $7,$6,$5
+        lw      $5,28($0)
+        sub     $4,$7,$5
+        sw      $4,44($0)
+        lw      $5,28($0)
+        sw      $6,20($0)
+        sub     $3,$5,$3
+        add     $6,$7,$5
+        sw      $7,32($0)
+        add     $4,$4,$3
+        sw      $3,8($0)
+        add     $3,$4,$7
+        sub     $3,$6,$5
+        add     $3,$3,$6
+        add     $3,$4,$4
+        sub     $3,$3,$6
+        add     $6,$7,$5
+        add     $6,$4,$7
+        add     $3,$4,$5
+        sw      $5,0($0)
+        sub     $4,$7,$5
+        add     $3,$5,$4
+        sub     $4,$6,$5
+        add     $4,$5,$6
+        sub     $7,$5,$3
+        sw      $3,44($0)
+        add     $7,$7,$3
+        sub     $5,$3,$6
+        add     $7,$7,$3
+        lw      $5,0($0)
+        sw      $3,44($0)
+        sub     $4,$3,$3
+        sub     $5,$5,$6
+        lw      $4,8($0)
+        add     $3,$4,$7
+        sub     $7,$4,$5
+        sub     $3,$5,$7
+        sw      $4,8($0)
+        sw      $3,20($0)
+        lw      $5,4($0)
+        add     $5,$3,$6
+        lw      $5,32($0)
+        sub     $7,$7,$4
+        sw      $6,16($0)
+        lw      $4,28($0)
+        lw      $7,24($0)
+        lw      $3,16($0)
+        sw      $5,8($0)
+        add     $7,$3,$4
+        sub     $6,$7,$3
+        add     $7,$5,$3
+        sub     $6,$6,$4
+        add     $7,$5,$3
+        lw      $6,40($0)
+        lw      $4,8($0)
+        add     $6,$4,$4
+        lw      $6,4($0)
+        add     $3,$3,$5
+        sw      $3,24($0)
+        add     $3,$6,$6
+        sw      $3,0($0)
+        add     $6,$7,$4
+        add     $6,$3,$7
+        sub     $3,$3,$6
+        add     $4,$7,$4
+        sub     $4,$4,$4
+        sub     $6,$4,$3
+        sub     $7,$4,$6
+        add     $6,$5,$4
+        sub     $4,$5,$5
+        add     $5,$6,$7
+        sw      $4,8($0)
+        add     $3,$4,$6
+        lw      $6,4($0)
+        sub     $4,$6,$3
+        add     $4,$3,$6
+        sw      $5,16($0)
+        sw      $3,36($0)
+        add     $5,$4,$5
+        lw      $7,4($0)
+        sub     $5,$7,$6
+        sub     $6,$3,$5
+        sub     $4,$6,$7
+        add     $6,$4,$4
+        add     $3,$3,$4
+        add     $7,$5,$4
+        add     $5,$4,$4
+        add     $4,$4,$5
+        sw      $5,4($0)
+        sw      $3,36($0)
+        sw      $5,0($0)
+        add     $6,$5,$3
+        sub     $6,$3,$6
+        sw      $4,24($0)
+        sub     $4,$3,$4
+        add     $5,$5,$6
+        sub     $7,$5,$4
+        sub     $5,$3,$3
+        sub     $3,$6,$3
+        sub     $5,$4,$6
+        add     $5,$4,$5
+        add     $5,$6,$4
+        sw      $6,32($0)
+        add     $6,$6,$5
+        sw      $4,44($0)
+        sub     $3,$6,$6
+        sub     $6,$5,$7
+        sub     $5,$3,$6
+        add     $5,$3,$5
+        add     $7,$6,$3
+        lw      $3,4($0)
+        add     $3,$5,$5
+        sw      $3,28($0)
+        add     $4,$4,$6
+        lw      $5,8($0)
+        sw      $6,32($0)
+        add     $3,$7,$3
+        sub     $7,$4,$4
+        sub     $5,$4,$7
+        add     $4,$7,$7
+        lw      $4,4($0)
+        add     $5,$3,$7
+        sub     $3,$5,$3
+        sub     $3,$7,$4
+        add     $6,$7,$3
+        sw      $4,24($0)
+        add     $5,$5,$6
+        add     $5,$7,$6
+        sub     $6,$5,$7
+        lw      $6,28($0)
+        sub     $3,$4,$5
+        sub     $4,$3,$4
+        sub     $3,$3,$4
+        add     $4,$3,$7
+        add     $7,$6,$5
+        sub     $6,$4,$3
+        sub     $3,$7,$3
+        sub     $4,$4,$4
+        add     $4,$5,$3
+        sw      $6,0($0)
+        sub     $4,$3,$6
+        sub     $4,$3,$5
+        sub     $7,$5,$3
+        add     $3,$7,$5
+        sw      $4,0($0)
+        lw      $7,16($0)
+        add     $7,$3,$7
+        sub     $5,$3,$5
+        sub     $4,$4,$4
+        sub     $7,$6,$3
+        sw      $5,32($0)
+        sub     $6,$4,$4
+        add     $6,$3,$3
+        sw      $7,8($0)
+        sub     $7,$3,$7
+        lw      $7,36($0)
+        add     $7,$4,$3
+        lw      $3,12($0)
+        sub     $4,$3,$7
+        add     $7,$4,$5
+        sw      $6,0($0)
+        lw      $4,16($0)
+        lw      $3,44($0)
+        add     $3,$5,$6
+        sub     $7,$5,$5
+        sw      $3,32($0)
+        sub     $6,$6,$5
+        lw      $6,40($0)
+        lw      $5,4($0)
+        sw      $5,32($0)
+        sw      $3,28($0)
+        sub     $7,$5,$4
+        add     $7,$6,$5
+        lw      $4,32($0)
+        lw      $7,28($0)
+        sub     $6,$6,$6
+        sub     $3,$4,$3
+        sub     $5,$6,$5
+        sub     $7,$6,$4
+        add     $7,$7,$4
+        add     $3,$3,$6
+        add     $6,$6,$7
+        add     $3,$4,$6
+        lw      $3,12($0)
+        add     $3,$3,$7
+        sw      $4,8($0)
+        add     $4,$5,$4
+        sw      $3,12($0)
+        lw      $4,20($0)
+        sub     $4,$6,$6
+        lw      $5,12($0)
+        sub     $4,$6,$4
+        lw      $7,32($0)
+        lw      $6,32($0)
+        sub     $3,$4,$5
+        sub     $3,$6,$5
+        sub     $5,$4,$3
+        sw      $7,4($0)
+        add     $3,$3,$7
+        sub     $5,$3,$5
+        sub     $5,$7,$4
+        add     $5,$6,$7
+        add     $5,$7,$4
+        lw      $3,4($0)
+        lw      $6,8($0)
+        lw      $3,16($0)
+        sw      $4,24($0)
+        sw      $5,8($0)
+        sw      $7,16($0)
+        sub     $6,$5,$3
+        lw      $5,4($0)
+        sw      $4,12($0)
+        lw      $7,44($0)
+        add     $6,$4,$6
+        add     $7,$7,$6
+        add     $4,$5,$3
+        add     $5,$7,$5
+        sub     $5,$5,$3
+        add     $7,$6,$7
+        sw      $4,40($0)
+        sw      $5,12($0)
+        sw      $3,4($0)
+        sub     $5,$7,$4
+        sw      $5,44($0)
+        add     $4,$6,$4
+        lw      $5,4($0)
+        sw      $4,8($0)
+        sub     $7,$6,$7
+        add     $3,$4,$3
+        sub     $4,$6,$6
+        sub     $7,$6,$3
+        add     $4,$3,$3
+        sub     $4,$4,$3
+        sw      $4,16($0)
+        sub     $7,$3,$6
+        add     $4,$5,$4
+        sub     $7,$5,$5
+        sw      $3,4($0)
+        add     $6,$5,$6
+        sub     $6,$6,$4
+        sub     $7,$6,$4
+        sub     $4,$5,$4
+        sw      $3,16($0)
+        add     $7,$6,$3
+        sub     $4,$5,$7
+        sw      $5,0($0)
+        sub     $6,$3,$6
+        add     $7,$3,$5
+        lw      $7,8($0)
+        add     $5,$7,$7
+        sub     $6,$4,$5
+        add     $6,$7,$6
+        sw      $4,16($0)
+        sw      $4,36($0)
+        lw      $4,44($0)
+        sub     $7,$3,$5
+        lw      $7,36($0)
+        sub     $5,$6,$6
+        add     $3,$6,$6
+        add     $7,$6,$3
+        lw      $4,12($0)
+        add     $3,$7,$3
+        add     $6,$4,$6
+        lw      $4,8($0)
+        sub     $6,$3,$5
+        add     $6,$6,$5
+        add     $3,$7,$6
+        lw      $4,12($0)
+        sub     $6,$4,$7
+        lw      $3,4($0)
+        lw      $4,16($0)
+        lw      $3,16($0)
+        sw      $7,12($0)
+        sub     $3,$5,$7
+        lw      $4,8($0)
+        lw      $6,36($0)
+        sub     $4,$5,$4
+        add     $3,$3,$7
+        add     $5,$5,$6
+        lw      $5,32($0)
+        sub     $7,$7,$5
+        sub     $5,$4,$4
+        sw      $6,36($0)
+        sub     $5,$4,$4
+        lw      $3,12($0)
+        sw      $4,32($0)
+        add     $5,$3,$6
+        lw      $5,24($0)
+        sw      $7,24($0)
+        sub     $6,$5,$5
+        sub     $4,$7,$4
+        lw      $6,0($0)
+        add     $4,$7,$7
+        add     $7,$7,$4
+        sub     $4,$3,$7
+        sub     $5,$5,$3
+        sub     $5,$5,$6
+        sw      $7,44($0)
+        add     $7,$3,$5
+        sw      $6,12($0)
+        sub     $4,$3,$6
+        sub     $7,$3,$4
+        add     $5,$5,$7
+        lw      $7,4($0)
+        sw      $3,28($0)
+        add     $5,$4,$7
+        lw      $4,12($0)
+        add     $5,$5,$6
+        sub     $5,$5,$3
+        sw      $4,4($0)
+        sw      $5,4($0)
+        sub     $4,$5,$3
+        sub     $3,$4,$5
+        add     $4,$3,$5
+        sub     $5,$6,$4
+        add     $3,$6,$6
+        sub     $3,$3,$4
+        sw      $3,40($0)
+        lw      $6,32($0)
+        add     $4,$7,$5
+        lw      $6,8($0)
+        sw      $7,8($0)
+        sub     $4,$3,$6
+        sw      $3,0($0)
+        lw      $5,20($0)
+        lw      $7,4($0)
+        sw      $3,0($0)
+        sub     $7,$5,$3
+        sw      $6,4($0)
+        add     $4,$5,$3
+        add     $6,$6,$4
+        lw      $5,16($0)
+        sw      $4,4($0)
+        add     $4,$4,$3
+        lw      $6,32($0)
+        sub     $7,$3,$6
+        sw      $7,40($0)
+        add     $7,$7,$5
+        sub     $3,$5,$5
+        add     $7,$7,$4
+        add     $7,$3,$4
+        lw      $6,4($0)
+        sw      $5,8($0)
+        add     $7,$5,$3
+        add     $6,$7,$7
+        sub     $7,$4,$6
+        lw      $7,16($0)
+        lw      $4,28($0)
+        lw      $6,8($0)
+        sub     $6,$6,$6
+        sub     $7,$5,$3
+        add     $4,$4,$6
+        add     $7,$5,$4
+        add     $6,$6,$6
+        sub     $7,$6,$7
+        sub     $6,$6,$5
+        lw      $6,32($0)
+        sub     $2,$2,$1
+        bne     $2,$0,loop
+        halt
+scratch: .fill 0,1,2,3,4,5,6,7,8,9,10,11
+one:    .fill 1
+reps:   .fill 300
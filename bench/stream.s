@@ -0,0 +1,25 @@
+# words: 32 80
+# Store/load streams: 2000 passes over a 32-word array, loading each
+# element, incrementing it and storing it to a second array.
+        lw      $1,one($0)
+        lw      $7,four($0)
+        lw      $2,reps($0)
+outer:  add     $3,$0,$0        # byte offset into the arrays
+        lw      $4,size($0)
+inner:  lw      $5,a($3)
+        add     $5,$5,$1
+        sw      $5,b($3)
+        add     $3,$3,$7
+        sub     $4,$4,$1
+        bne     $4,$0,inner
+        sub     $2,$2,$1
+        bne     $2,$0,outer
+        halt
+one:    .fill 1
+four:   .fill 4
+reps:   .fill 2000
+size:   .fill 32
+a:      .fill 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15
+        .fill 16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31
+b:      .fill 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+        .fill 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
@@ -0,0 +1,128 @@
+#!/bin/sh
+# Differential check of the pipelines against the functional simulator.
+#
+#   ./check.sh [-n programs] [-s seed] [simulator]
+#
+# First every bench/*.s workload runs under -K in each configuration
+# below, so the reference interpreter checks every retirement. Then
+# random programs, whose branches and jumps only go forward so they
+# always halt, run in each configuration with the state dumped when
+# the HALT reaches MEM/WB, which must match the final state of -f.
+# Prints each failure and exits with status 1 if there was any.
+
+programs=200
+seed=1
+while getopts n:s: flag; do
+    case $flag in
+    n) programs=$OPTARG ;;
+    s) seed=$OPTARG ;;
+    *) echo "usage: $0 [-n programs] [-s seed] [simulator]" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+sim=${1:-./proj2}
+dir=$(dirname "$0")
+tmp=${TMPDIR:-/tmp}/check.$$
+trap 'rm -f $tmp.*' EXIT
+
+configs='
+-p global
+-p local
+-p btb
+-p gshare -I 256,2 -D 256,4
+-p tournament -D 256,2 -R plru -W through
+-s 2
+-s 4 -p btb -P 4,2,1
+-o
+-o -p tournament -B 8,4,4 -D 256,2
+-G 3,2,2,2 -p local
+-G 1,1,1,1 -M 1,1
+'
+
+# Runs one configuration ($1, split into words) on file $2 with sizes $3
+run() {
+    # shellcheck disable=SC2086
+    timeout 60 "$sim" $1 $3 < "$2"
+}
+
+echo "$configs" | while read -r config; do
+    [ -n "$config" ] || continue
+    for file in "$dir"/bench/*.s; do
+        sizes=$(sed -n 's/^# words: *\([0-9]*\) *\([0-9]*\).*/-i \1 -d \2/p' "$file")
+        if ! run "-q -K $config" "$file" "$sizes" > /dev/null 2> $tmp.err; then
+            echo "FAIL -K $config $file: $(cat $tmp.err)"
+            touch $tmp.failed
+        fi
+    done
+done
+
+# Writes random program number $1 to stdout
+generate() {
+    awk -v seed="$seed" -v number="$1" 'BEGIN {
+        srand(seed * 100000 + number)
+        split("add sub and or xor nor slt mul div sllv srlv srav", r3, " ")
+        n = 3 + int(rand() * 37)
+        for (i = 0; i < n; i++) {
+            k = rand()
+            label = "L" i ":"
+            if (k < 0.25)
+                s = sprintf("%s $%d,$%d,$%d", r3[1 + int(rand() * 12)], w(), r(), r())
+            else if (k < 0.35)
+                s = sprintf("%s $%d,$%d,%d", pick3("sll", "srl", "sra"), w(), r(), int(rand() * 32))
+            else if (k < 0.45)
+                s = sprintf("%s $%d,$%d,%d", rand() < 0.5 ? "addi" : "slti", w(), r(), int(rand() * 80) - 40)
+            else if (k < 0.5)
+                s = sprintf("%s $%d,$%d,%d", pick3("andi", "ori", "xori"), w(), r(), int(rand() * 65536))
+            else if (k < 0.6)
+                s = sprintf("lw $%d,%d($0)", w(), 4 * int(rand() * 16))
+            else if (k < 0.68)
+                s = sprintf("sw $%d,%d($0)", r(), 4 * int(rand() * 16))
+            else if (k < 0.76 && i < n - 1)
+                s = sprintf("%s $%d,$%d,L%d", rand() < 0.5 ? "bne" : "beq", r(), r(), ahead(i + 1))
+            else if (k < 0.8 && i < n - 1)
+                s = sprintf("%s L%d", rand() < 0.5 ? "j" : "jal", ahead(i + 1))
+            else if (k < 0.84 && i < n - 2) {
+                printf "%s\taddi $6,$0,L%d\n", label, ahead(i + 2)
+                label = ""
+                s = "jr $6"
+            }
+            else if (k < 0.9)
+                s = sprintf("mul $%d,$%d,$%d", w(), r(), r())
+            else
+                s = "noop"
+            printf "%s\t%s\n", label, s
+        }
+        printf "L%d:\thalt\n\t.fill %d", n, int(rand() * 25) - 5
+        for (i = 1; i < 16; i++)
+            printf ",%d", int(rand() * 25) - 5
+        printf "\n"
+    }
+    function r() { return int(rand() * 8) }
+    function w() { return 1 + int(rand() * 7) }
+    function ahead(from) { return from + int(rand() * (n + 1 - from)) }
+    function pick3(a, b, c,    x) { x = rand(); return x < 1 / 3 ? a : x < 2 / 3 ? b : c }'
+}
+
+number=0
+while [ $number -lt "$programs" ]; do
+    generate $number > $tmp.s
+    if ! run "-f" $tmp.s "-i 128" | grep -E 'dataMem|regFile' > $tmp.ref; then
+        echo "FAIL -f on random program $number (seed $seed)"
+        touch $tmp.failed
+    fi
+    echo "$configs" | while read -r config; do
+        [ -n "$config" ] || continue
+        run "-e halt $config" $tmp.s "-i 128" 2>&1 | grep -E 'dataMem|regFile|error' > $tmp.out
+        if ! cmp -s $tmp.ref $tmp.out; then
+            echo "FAIL $config on random program $number (seed $seed):"
+            cat $tmp.s
+            touch $tmp.failed
+        fi
+    done
+    number=$((number + 1))
+done
+
+if [ -e $tmp.failed ]; then
+    exit 1
+fi
+echo "all checks passed"
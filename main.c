@@ -0,0 +1,1218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <math.h>
+#include "proj2.h"
+
+void printResults(resultsType*);
+void cpiStack(resultsType*, double*);
+void exportCounters(char*, resultsType*);
+void runSweep(optionsType*, programType*);
+void parseOptions(int, char**, optionsType*);
+int parseArgs(int, char**, optionsType*);
+int parseEvents(char*);
+void debugProgram(optionsType*, programType*);
+
+/******************************************************************/
+/* main is the command line front end of the simulator library:   */
+/* it reads the program from stdin, runs it with the options from */
+/* the command line and prints the statistics.                    */
+/******************************************************************/
+int main(int argc, char *argv[]){
+    optionsType options;
+    programType program;
+    resultsType results;
+    simulatorType *sim;
+    FILE *input;
+    char error[ERRORLENGTH];
+
+    parseOptions(argc, argv, &options);
+    memset(&program, 0, sizeof(program));
+    if(options.debugFile != NULL){
+        input = fopen(options.debugFile, "rb");
+        if(input == NULL){
+            fprintf(stderr, "error: cannot open %s\n", options.debugFile);
+            exit(1);
+        }
+        if(loadProgram(&program, &options, input, error) != 0){
+            fprintf(stderr, "error: %s\n", error);
+            exit(1);
+        }
+        fclose(input);
+        debugProgram(&options, &program);
+        freeProgram(&program);
+        return(0);
+    }
+    if(options.restoreFile == NULL && loadProgram(&program, &options, stdin, error) != 0){
+        fprintf(stderr, "error: %s\n", error);
+        exit(1);
+    }
+
+    if(options.imageFile != NULL){
+        if(writeImage(&program, options.imageFile, 0, error) != 0){
+            fprintf(stderr, "error: %s\n", error);
+            exit(1);
+        }
+        if(options.outputMode != QUIET)
+            printf("Program image written to %s: %d instruction words, %d data words, %d labels\n",
+                   options.imageFile, program.instrSize, program.dataSize, program.symbolCount);
+        freeProgram(&program);
+        return(0);
+    }
+
+    if(options.sweepFile != NULL){
+        runSweep(&options, &program);
+        freeProgram(&program);
+        return(0);
+    }
+
+    sim = simCreate(&options, &program);
+    if(sim == NULL){
+        fprintf(stderr, "error: cannot allocate the simulator\n");
+        exit(1);
+    }
+    simGetResults(sim, &results);
+    if(simGetStatus(sim) != SIM_ERROR && options.outputMode != QUIET){
+        if(results.functional){
+            printf("\n********************\nState after %lld instructions:\n", results.instructions);
+            printf("\tPC = %d\n", simGetState(sim)->PC);
+            printMemories(simGetState(sim));
+        }
+        else if(options.fastForward >= 0 || options.marker >= 0)
+            printf("Fast-forwarded %lld instructions to PC %d\n", results.instructions, simGetState(sim)->PC);
+    }
+
+    if(simRun(sim) == SIM_ERROR){
+        fflush(stdout);
+        fprintf(stderr, "error: %s\n", simGetError(sim));
+        exit(1);
+    }
+    simGetResults(sim, &results);
+    if(results.checkpointed && options.outputMode != QUIET)
+        printf("Checkpoint written to %s at the beginning of cycle %lld\n",
+               options.checkpointFile, simGetState(sim)->cycles + 1);
+    printResults(&results);
+    if(options.countersFile != NULL && !results.checkpointed)
+        exportCounters(options.countersFile, &results);
+    simDestroy(sim);
+    freeProgram(&program);
+    return(0);
+}
+
+/******************************************************************/
+/* The parseOptions function reads the command line and selects   */
+/* the output mode. With no arguments every cycle is printed.     */
+/*   -q            print only the final statistics                */
+/*   -n N          print the state every N cycles                 */
+/*   -e LIST       print the state only after the listed events,  */
+/*                 a comma separated list of stall, mispredict    */
+/*                 and halt                                       */
+/*   -v            print every cycle (the default)                */
+/*   -i N, -d N    words of instruction and data memory           */
+/*   -p KIND       branch predictor: global, local, btb, gshare   */
+/*                 or tournament                                  */
+/*   -t N          entries per predictor table                    */
+/*   -g N          global history bits for gshare and tournament  */
+/*   -f            execute the program functionally, no pipeline  */
+/*   -F N          execute N instructions functionally, then      */
+/*                 switch to the pipeline                         */
+/*   -m ADDR       execute functionally until the instruction at  */
+/*                 ADDR, then switch to the pipeline              */
+/*   -w FILE       write a checkpoint and stop, at the beginning  */
+/*                 of cycle -C N + 1 (default: the first pipeline */
+/*                 cycle, after any fast-forward)                 */
+/*   -r FILE       resume from a checkpoint instead of stdin      */
+/*   -S FILE       run every configuration in FILE, one line of   */
+/*                 flags each, and print a table of the results   */
+/*   -j N          number of sweep simulations run in parallel    */
+/*   -I B[,W[,L]]  instruction cache of B bytes, W ways and L     */
+/*                 byte lines (default 1 way of 16 byte lines)    */
+/*   -D B[,W[,L]]  data cache, likewise                           */
+/*   -l N          cycles the pipeline freezes on a cache miss    */
+/*   -R POLICY     cache replacement: lru or plru                 */
+/*   -W POLICY     data cache writes: back or through             */
+/*   -T FILE       record a binary trace of every cycle, which    */
+/*                 the replay tool renders                        */
+/*   -x FILE       export the performance counters and CPI stack, */
+/*                 as CSV if FILE ends in .csv, else as JSON      */
+/*   -s N          superscalar pipeline of N instructions per     */
+/*                 stage, in order                                */
+/*   -P R[,W[,M]]  register file read and write ports and memory  */
+/*                 ports of a superscalar pipeline                */
+/*   -o            out-of-order core, -s N instructions wide      */
+/*   -B R[,S[,L]]  its reorder buffer, reservation station and    */
+/*                 load/store queue sizes                         */
+/*   -G F,D,E,M[,B]                                               */
+/*                 pipeline of F fetch, D decode, E execute and M */
+/*                 memory stages, resolving branches in stage B   */
+/*                 (default: the first execute stage)             */
+/*   -M M[,D]      cycles of the pipelined multiplier and of the  */
+/*                 divider, which takes one divide at a time      */
+/*   -K            check every retirement against a reference     */
+/*                 interpreter and stop at the first divergence   */
+/*   -N C[,T]      C scalar cores sharing the data memory, the    */
+/*                 data caches kept coherent, stepped by T host   */
+/*                 threads (default 1: cycle by cycle)            */
+/*   -Q N          cycles host threads run cores between meeting  */
+/*   -H PROTOCOL   coherence protocol: msi or mesi                */
+/*   -u U,P[,W]    sample: measure U instructions out of every P  */
+/*                 in detail, after W of detailed warm-up, and    */
+/*                 run the rest functionally                      */
+/*   -y FILE       debug the program in FILE, reading debugger    */
+/*                 commands from stdin                            */
+/*   -A FILE       assemble the program into an image and stop    */
+/*   -c DIR        cache program images in DIR by source hash     */
+/******************************************************************/
+void parseOptions(int argc, char *argv[], optionsType *options)
+{
+    int bad;
+
+    defaultOptions(options);
+    bad = parseArgs(argc - 1, argv + 1, options);
+    if(bad >= 0){
+        fprintf(stderr, "usage: %s [-v | -q | -n cycles | -e stall,mispredict,halt] [-i words] [-d words]\n"
+                        "\t[-p global|local|btb|gshare|tournament] [-t entries] [-g bits]\n"
+                        "\t[-f | -F instructions | -m address] [-w file [-C cycles]] [-r file]\n"
+                        "\t[-S file [-j threads]] [-I bytes[,ways[,line]]] [-D bytes[,ways[,line]]]\n"
+                        "\t[-l cycles] [-R lru|plru] [-W back|through] [-x file] [-T file]\n"
+                        "\t[-s width [-P reads[,writes[,memory]]]] [-o [-B rob[,stations[,lsq]]]]\n"
+                        "\t[-G fetch,decode,alu,memory[,resolve]] [-M mul[,div]] [-K]\n"
+                        "\t[-N cores[,threads] [-Q cycles] [-H msi|mesi]] [-u unit,period[,warmup]]\n"
+                        "\t[-A image | -c directory] < program | -y program\n", argv[0]);
+        exit(1);
+    }
+
+    if(options->restoreFile != NULL && (options->functional || options->fastForward >= 0 || options->marker >= 0)){
+        fprintf(stderr, "error: a restored pipeline cannot be fast-forwarded\n");
+        exit(1);
+    }
+    if(options->restoreFile != NULL && options->check){
+        fprintf(stderr, "error: the checker starts with the program, not from a checkpoint\n");
+        exit(1);
+    }
+    if(options->restoreFile != NULL && options->imageFile != NULL){
+        fprintf(stderr, "error: a restored pipeline has no program to write as an image\n");
+        exit(1);
+    }
+    if(deepPipeline(options) && (options->width > 1 || options->outOfOrder)){
+        fprintf(stderr, "error: superscalar pipelines and the out-of-order core have the classic 5 stages\n");
+        exit(1);
+    }
+    if((options->width > 1 || options->outOfOrder || deepPipeline(options)) &&
+       (options->checkpointFile != NULL || options->restoreFile != NULL || options->traceFile != NULL)){
+        fprintf(stderr, "error: checkpoints and traces hold only scalar 5-stage pipelines\n");
+        exit(1);
+    }
+    if(options->sweepFile != NULL && (options->countersFile != NULL || options->traceFile != NULL)){
+        fprintf(stderr, "error: a sweep cannot export counters or traces\n");
+        exit(1);
+    }
+    if(options->debugFile != NULL && (options->restoreFile != NULL || options->sweepFile != NULL ||
+                                      options->imageFile != NULL)){
+        fprintf(stderr, "error: -y debugs a program source and cannot restore, sweep or write images\n");
+        exit(1);
+    }
+    if(options->sweepFile != NULL && options->checkpointFile != NULL){
+        fprintf(stderr, "error: a sweep cannot write checkpoints\n");
+        exit(1);
+    }
+
+    /* The dump is the bulk of the output, so buffer it in large blocks */
+    if(options->outputMode != QUIET)
+        setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+}
+
+/******************************************************************/
+/* The parseArgs function applies the flags in argv to options.   */
+/* It returns -1, or the index of the first argument it does not  */
+/* understand.                                                    */
+/******************************************************************/
+int parseArgs(int argc, char *argv[], optionsType *options)
+{
+    int predictor = 0;                    /* 1 once -p, -t or -g is given */
+    int i;
+
+    for(i = 0; i < argc; i++){
+        if(strcmp(argv[i], "-v") == 0){
+            options->outputMode = VERBOSE;
+        }
+        else if(strcmp(argv[i], "-q") == 0){
+            options->outputMode = QUIET;
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            options->outputMode = INTERVAL;
+            options->dumpInterval = atoi(argv[++i]);
+            if(options->dumpInterval < 1){
+                fprintf(stderr, "error: -n expects a positive cycle count\n");
+                exit(1);
+            }
+        }
+        else if((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "-d") == 0) && i + 1 < argc){
+            int words = atoi(argv[i + 1]);
+            if(words < 1){
+                fprintf(stderr, "error: %s expects a positive number of words\n", argv[i]);
+                exit(1);
+            }
+            if(argv[i][1] == 'i')
+                options->instrSize = words;
+            else
+                options->dataSize = words;
+            i++;
+        }
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc){
+            predictor = 1;
+            i++;
+            if(strcmp(argv[i], "global") == 0)
+                options->predictorKind = PRED_GLOBAL;
+            else if(strcmp(argv[i], "local") == 0)
+                options->predictorKind = PRED_LOCAL;
+            else if(strcmp(argv[i], "btb") == 0)
+                options->predictorKind = PRED_BTB;
+            else if(strcmp(argv[i], "gshare") == 0)
+                options->predictorKind = PRED_GSHARE;
+            else if(strcmp(argv[i], "tournament") == 0)
+                options->predictorKind = PRED_TOURNAMENT;
+            else{
+                fprintf(stderr, "error: unknown predictor '%s'\n", argv[i]);
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc){
+            predictor = 1;
+            options->predictorSize = atoi(argv[++i]);
+            if(options->predictorSize < 1 || (options->predictorSize & (options->predictorSize - 1))){
+                fprintf(stderr, "error: -t expects a power of two\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc){
+            predictor = 1;
+            options->historyBits = atoi(argv[++i]);
+            if(options->historyBits < 1 || options->historyBits > 30){
+                fprintf(stderr, "error: -g expects 1 to 30 history bits\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-f") == 0){
+            options->functional = 1;
+        }
+        else if(strcmp(argv[i], "-F") == 0 && i + 1 < argc){
+            options->fastForward = atoll(argv[++i]);
+            if(options->fastForward < 0){
+                fprintf(stderr, "error: -F expects an instruction count\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc){
+            options->marker = atoi(argv[++i]);
+            if(options->marker < 0 || options->marker % 4 != 0){
+                fprintf(stderr, "error: -m expects a word-aligned instruction address\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc){
+            options->checkpointFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "-C") == 0 && i + 1 < argc){
+            options->checkpointCycle = atoll(argv[++i]);
+            if(options->checkpointCycle < 0){
+                fprintf(stderr, "error: -C expects a cycle count\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc){
+            options->restoreFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "-S") == 0 && i + 1 < argc){
+            options->sweepFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+            options->threads = atoi(argv[++i]);
+            if(options->threads < 1){
+                fprintf(stderr, "error: -j expects a positive thread count\n");
+                exit(1);
+            }
+        }
+        else if((strcmp(argv[i], "-I") == 0 || strcmp(argv[i], "-D") == 0) && i + 1 < argc){
+            int size, ways = 1, line = 16;
+            if(sscanf(argv[i + 1], "%d,%d,%d", &size, &ways, &line) < 1 || size < 0){
+                fprintf(stderr, "error: %s expects bytes[,ways[,line bytes]]\n", argv[i]);
+                exit(1);
+            }
+            if(argv[i][1] == 'I'){
+                options->icacheSize = size;
+                options->icacheWays = ways;
+                options->icacheLine = line;
+            }
+            else{
+                options->dcacheSize = size;
+                options->dcacheWays = ways;
+                options->dcacheLine = line;
+            }
+            i++;
+        }
+        else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc){
+            options->missLatency = atoi(argv[++i]);
+            if(options->missLatency < 0){
+                fprintf(stderr, "error: -l expects a cycle count\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-R") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "lru") == 0)
+                options->replacement = CACHE_LRU;
+            else if(strcmp(argv[i], "plru") == 0)
+                options->replacement = CACHE_PLRU;
+            else{
+                fprintf(stderr, "error: unknown replacement policy '%s'\n", argv[i]);
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-W") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "back") == 0)
+                options->writePolicy = WRITEBACK;
+            else if(strcmp(argv[i], "through") == 0)
+                options->writePolicy = WRITETHROUGH;
+            else{
+                fprintf(stderr, "error: unknown write policy '%s'\n", argv[i]);
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-T") == 0 && i + 1 < argc){
+            options->traceFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "-x") == 0 && i + 1 < argc){
+            options->countersFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            options->width = atoi(argv[++i]);
+            if(options->width < 1 || options->width > MAXWIDTH){
+                fprintf(stderr, "error: -s expects a width of 1 to %d\n", MAXWIDTH);
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-P") == 0 && i + 1 < argc){
+            int reads, writes = 0, memory = 0;
+            if(sscanf(argv[i + 1], "%d,%d,%d", &reads, &writes, &memory) < 1 || reads < 2 || writes < 0 || memory < 0){
+                fprintf(stderr, "error: -P expects reads[,writes[,memory]], with at least 2 reads\n");
+                exit(1);
+            }
+            options->readPorts = reads;
+            options->writePorts = writes;
+            options->memoryPorts = memory;
+            i++;
+        }
+        else if(strcmp(argv[i], "-o") == 0){
+            options->outOfOrder = 1;
+        }
+        else if(strcmp(argv[i], "-B") == 0 && i + 1 < argc){
+            int rob, stations = RSSIZE, lsq = LSQSIZE;
+            if(sscanf(argv[i + 1], "%d,%d,%d", &rob, &stations, &lsq) < 1 || rob < 1 || stations < 1 || lsq < 1){
+                fprintf(stderr, "error: -B expects rob[,stations[,lsq]] entries\n");
+                exit(1);
+            }
+            options->robSize = rob;
+            options->rsSize = stations;
+            options->lsqSize = lsq;
+            i++;
+        }
+        else if(strcmp(argv[i], "-G") == 0 && i + 1 < argc){
+            int fetch, decode, alu, memory, resolve = 0;
+            if(sscanf(argv[i + 1], "%d,%d,%d,%d,%d", &fetch, &decode, &alu, &memory, &resolve) < 4 ||
+               fetch < 1 || decode < 1 || alu < 1 || memory < 1 || fetch + decode + alu + memory + 1 > MAXDEPTH){
+                fprintf(stderr, "error: -G expects fetch,decode,alu,memory[,resolve] stages, at most %d in all\n", MAXDEPTH);
+                exit(1);
+            }
+            if(resolve && (resolve <= fetch + decode || resolve > fetch + decode + alu + memory)){
+                fprintf(stderr, "error: -G resolves branches in an EX or MEM stage, %d to %d\n",
+                        fetch + decode + 1, fetch + decode + alu + memory);
+                exit(1);
+            }
+            options->fetchStages = fetch;
+            options->decodeStages = decode;
+            options->aluLatency = alu;
+            options->memoryLatency = memory;
+            options->resolveStage = resolve;
+            i++;
+        }
+        else if(strcmp(argv[i], "-M") == 0 && i + 1 < argc){
+            int mul, div = DIVLATENCY;
+            if(sscanf(argv[i + 1], "%d,%d", &mul, &div) < 1 || mul < 1 || div < 1){
+                fprintf(stderr, "error: -M expects mul[,div] cycles, at least 1 each\n");
+                exit(1);
+            }
+            options->mulLatency = mul;
+            options->divLatency = div;
+            i++;
+        }
+        else if(strcmp(argv[i], "-K") == 0){
+            options->check = 1;
+        }
+        else if(strcmp(argv[i], "-N") == 0 && i + 1 < argc){
+            int cores, threads = 1;
+            if(sscanf(argv[i + 1], "%d,%d", &cores, &threads) < 1 || cores < 1 || cores > MAXCORES || threads < 1){
+                fprintf(stderr, "error: -N expects 1 to %d cores[,host threads]\n", MAXCORES);
+                exit(1);
+            }
+            options->cores = cores;
+            options->coreThreads = threads;
+            i++;
+        }
+        else if(strcmp(argv[i], "-Q") == 0 && i + 1 < argc){
+            options->quantum = atoi(argv[++i]);
+            if(options->quantum < 1){
+                fprintf(stderr, "error: -Q expects a positive cycle count\n");
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-H") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "msi") == 0)
+                options->coherence = COHERENCE_MSI;
+            else if(strcmp(argv[i], "mesi") == 0)
+                options->coherence = COHERENCE_MESI;
+            else{
+                fprintf(stderr, "error: unknown coherence protocol '%s'\n", argv[i]);
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "-u") == 0 && i + 1 < argc){
+            long long unit, period, warmup = SAMPLEWARMUP;
+            if(sscanf(argv[i + 1], "%lld,%lld,%lld", &unit, &period, &warmup) < 2 || unit < 1 || warmup < 0 ||
+               period < unit + warmup){
+                fprintf(stderr, "error: -u expects unit,period[,warmup] instructions, the period at least unit + warmup\n");
+                exit(1);
+            }
+            options->sampleUnit = unit;
+            options->samplePeriod = period;
+            options->sampleWarmup = warmup;
+            i++;
+        }
+        else if(strcmp(argv[i], "-y") == 0 && i + 1 < argc){
+            options->debugFile = argv[++i];
+            options->snapshotInterval = SNAPSHOTINTERVAL;
+        }
+        else if(strcmp(argv[i], "-A") == 0 && i + 1 < argc){
+            options->imageFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc){
+            options->imageCache = argv[++i];
+        }
+        else if(strcmp(argv[i], "-e") == 0 && i + 1 < argc){
+            options->outputMode = EVENTS;
+            options->dumpEvents = parseEvents(argv[++i]);
+        }
+        else{
+            return i;
+        }
+    }
+    if(predictor && options->restoreFile != NULL){
+        fprintf(stderr, "error: a restored pipeline keeps the predictor of its checkpoint\n");
+        exit(1);
+    }
+    return -1;
+}
+
+/******************************************************************/
+/* The parseEvents function converts a comma separated list of    */
+/* event names into EVENT_* bits.                                 */
+/******************************************************************/
+int parseEvents(char *list)
+{
+    int events = 0;
+    char *name = strtok(list, ",");
+
+    while(name != NULL){
+        if(strcmp(name, "stall") == 0)
+            events |= EVENT_STALL;
+        else if(strcmp(name, "mispredict") == 0)
+            events |= EVENT_MISPREDICT;
+        else if(strcmp(name, "halt") == 0)
+            events |= EVENT_HALT;
+        else{
+            fprintf(stderr, "error: unknown event '%s'\n", name);
+            exit(1);
+        }
+        name = strtok(NULL, ",");
+    }
+    return events;
+}
+
+/******************************************************************/
+/* The printResults function prints the statistics of a finished  */
+/* run.                                                           */
+/******************************************************************/
+void printResults(resultsType *results)
+{
+    static const char *names[] = {"global", "local", "btb", "gshare", "tournament"};
+    static const char *protocols[] = {"MSI", "MESI"};
+    long long *c = results->counters;
+    double cpi[5];
+    int i;
+
+    if(results->functional){
+        printf("Total number of instructions executed: %lld\n", results->instructions);
+    }
+    else if(!results->checkpointed){
+        printf("Total number of cycles executed: %lld\n", results->cycles);
+        printf("Instructions per cycle: %.3f (%lld retired, %d-wide%s",
+               results->cycles ? (double)results->counters[CTR_RETIRED] / results->cycles : 0.0,
+               results->counters[CTR_RETIRED], results->width, results->outOfOrder ? ", out of order" : "");
+        if(results->depth != 5)
+            printf(", %d stages", results->depth);
+        if(results->cores > 1)
+            printf(", %d cores", results->cores);
+        printf(")\n");
+        printf("Total number of stalls: %lld\n", results->stalls);
+        printf("Total number of branches %lld\n", results->branches);
+        printf("Total number of mispredicted branches: %lld\n", results->mispredictions);
+        printf("Branch predictor: %s, %d entries, accuracy %.2f%%\n", names[results->predictorKind],
+               results->predictorSize, results->branches ?
+               100.0 * (results->branches - results->mispredictions) / results->branches : 100.0);
+        if(results->icache.accesses || results->dcache.accesses)
+            printf("Total number of cache stall cycles: %lld\n", results->memoryStalls);
+        if(results->counters[CTR_RETIRED]){
+            cpiStack(results, cpi);
+            printf("CPI: %.3f (base %.3f, data %.3f, control %.3f, memory %.3f",
+                   cpi[0] + cpi[1] + cpi[2] + cpi[3] + cpi[4], cpi[0], cpi[1], cpi[2], cpi[3]);
+            if(results->width > 1 || results->outOfOrder || cpi[4] > 0)
+                printf(", structural %.3f", cpi[4]);
+            printf(")\n");
+        }
+    }
+    if(results->sampling.unit){
+        samplingType *s = &results->sampling;
+        printf("Sampled %d windows of %lld instructions, one every %lld, %lld instructions run functionally\n",
+               s->windows, s->unit, s->period, results->instructions);
+    }
+    if(results->sampling.windows){
+        samplingType *s = &results->sampling;
+        printf("Estimated CPI: %.3f", s->cpi);
+        if(s->cpiError >= 0)
+            printf(" +- %.3f", s->cpiError);
+        printf(", stalls per instruction: %.3f", s->stallRate);
+        if(s->stallError >= 0)
+            printf(" +- %.3f", s->stallError);
+        printf(", mispredictions per branch: %.2f%%", 100 * s->mispredictRate);
+        if(s->mispredictError >= 0)
+            printf(" +- %.2f%%", 100 * s->mispredictError);
+        if(s->cpiError >= 0)
+            printf(" (%.1f%% confidence)", 100 * erf(CONFIDENCE / sqrt(2)));
+        printf("\n");
+    }
+    if(results->icache.accesses && !results->checkpointed)
+        printf("I-cache: %lld accesses, %lld hits, %lld misses, %lld evictions\n", results->icache.accesses,
+               results->icache.hits, results->icache.misses, results->icache.evictions);
+    if(results->dcache.accesses && !results->checkpointed)
+        printf("D-cache: %lld accesses, %lld hits, %lld misses, %lld evictions, %lld writebacks\n", results->dcache.accesses,
+               results->dcache.hits, results->dcache.misses, results->dcache.evictions, results->dcache.writebacks);
+    if(results->cores > 1){
+        for(i = 0; i < results->cores; i++)
+            printf("Core %d: %lld cycles, %lld retired\n", i, results->coreCycles[i], results->coreRetired[i]);
+        if(results->dcache.accesses)
+            printf("Coherence (%s): %lld bus reads, %lld read-exclusives, %lld upgrades, %lld invalidations, "
+                   "%lld interventions, %lld sharing misses\n", protocols[results->coherence], c[CTR_BUSREAD],
+                   c[CTR_BUSREADX], c[CTR_UPGRADES], c[CTR_INVALIDATIONS], c[CTR_INTERVENTIONS], c[CTR_SHARINGMISSES]);
+    }
+    fflush(stdout);
+}
+
+/******************************************************************/
+/* The cpiStack function splits the cycles per retired            */
+/* instruction into base, data hazard (load-use stalls, stalls    */
+/* for multi-cycle ALU results and, when superscalar,             */
+/* dependencies within a bundle), control hazard (squashed        */
+/* fetches), memory (cache miss) and structural (ports, and EX    */
+/* held by a multiply or divide) components, the latter including */
+/* a full ROB, reservation stations or LSQ in the out-of-order    */
+/* core. Its divides waiting for the divider are left out, since  */
+/* other instructions issue meanwhile. Hazards of a wide pipeline */
+/* are counted in issue slots, so they are divided by the width.  */
+/* Base is what remains, including filling and draining the pipe  */
+/* and fetch running dry. The cores of a multicore run are added  */
+/* up, each counting the cycles until its own HALT.               */
+/******************************************************************/
+void cpiStack(resultsType *results, double *cpi)
+{
+    long long *c = results->counters;
+    double retired = c[CTR_RETIRED] ? c[CTR_RETIRED] : 1;
+    double slots = retired * results->width;
+    double cycles = results->cycles;
+    int i;
+
+    if(results->cores > 1)
+        for(cycles = 0, i = 0; i < results->cores; i++)
+            cycles += results->coreCycles[i];
+
+    cpi[1] = (c[CTR_LOADUSE] + c[CTR_DEPENDENCY]) / slots;
+    cpi[2] = (c[CTR_TAKENBUBBLES] + c[CTR_FLUSHBUBBLES]) / slots;
+    cpi[3] = c[CTR_MEMORY] / retired;
+    cpi[4] = (c[CTR_STRUCTURAL] + c[CTR_ROBFULL] + c[CTR_RSFULL] + c[CTR_LSQFULL] +
+              (results->outOfOrder ? 0 : c[CTR_UNITBUSY])) / slots;
+    cpi[0] = cycles / retired - cpi[1] - cpi[2] - cpi[3] - cpi[4];
+}
+
+/******************************************************************/
+/* The exportCounters function writes every named counter and the */
+/* CPI stack to a file, or to stdout for "-". Names ending in     */
+/* .csv get one "name,value" row per counter, anything else gets  */
+/* a JSON object.                                                 */
+/******************************************************************/
+void exportCounters(char *name, resultsType *results)
+{
+    static const char *parts[5] = {"cpi.base", "cpi.data", "cpi.control", "cpi.memory", "cpi.structural"};
+    size_t length = strlen(name);
+    int csv = length > 4 && strcmp(name + length - 4, ".csv") == 0;
+    FILE *file = strcmp(name, "-") == 0 ? stdout : fopen(name, "w");
+    const char *separator = "";
+    double cpi[5];
+    int i;
+
+    if(file == NULL){
+        fprintf(stderr, "error: cannot create %s\n", name);
+        exit(1);
+    }
+    cpiStack(results, cpi);
+    if(csv){
+        fprintf(file, "counter,value\ncycles,%lld\n", results->cycles);
+        for(i = 0; i < NUMCOUNTERS; i++)
+            if(counterName(i) != NULL)
+                fprintf(file, "%s,%lld\n", counterName(i), results->counters[i]);
+        for(i = 0; i < 5; i++)
+            fprintf(file, "%s,%.6f\n", parts[i], cpi[i]);
+    }
+    else{
+        fprintf(file, "{\n  \"cycles\": %lld", results->cycles);
+        separator = ",\n";
+        for(i = 0; i < NUMCOUNTERS; i++)
+            if(counterName(i) != NULL)
+                fprintf(file, "%s  \"%s\": %lld", separator, counterName(i), results->counters[i]);
+        for(i = 0; i < 5; i++)
+            fprintf(file, "%s  \"%s\": %.6f", separator, parts[i], cpi[i]);
+        fprintf(file, "\n}\n");
+    }
+    if(file == stdout)
+        fflush(file);
+    else if(fclose(file) != 0){
+        fprintf(stderr, "error: cannot write %s\n", name);
+        exit(1);
+    }
+}
+
+/******************************************************************/
+/* A sweep runs the shared program once for every configuration   */
+/* line of the sweep file. Each line holds flags applied on top   */
+/* of the command line options, for example "-p gshare -t 256".   */
+/* Worker threads take the next configuration until none remain.  */
+/* Sweep runs never dump state, and the memory sizes come from    */
+/* the command line because the program is loaded only once.      */
+/******************************************************************/
+typedef struct sweepStruct {
+  optionsType *configs;                   /* One set of options per configuration */
+  char **labels;                          /* The configuration lines, for the table */
+  resultsType *results;                   /* One result per configuration */
+  programType *program;                   /* Shared by all runs */
+  int count;                              /* Number of configurations */
+  int next;                               /* Next configuration to hand out */
+  pthread_mutex_t lock;                   /* Protects next */
+} sweepType;
+
+void *sweepWorker(void *arg)
+{
+    sweepType *sweep = arg;
+    simulatorType *sim;
+    int index;
+
+    while(1){
+        pthread_mutex_lock(&sweep->lock);
+        index = sweep->next++;
+        pthread_mutex_unlock(&sweep->lock);
+        if(index >= sweep->count)
+            return NULL;
+        sim = simCreate(&sweep->configs[index], sweep->program);
+        if(sim == NULL){
+            fprintf(stderr, "error: cannot allocate the simulator\n");
+            exit(1);
+        }
+        if(simRun(sim) == SIM_ERROR)
+            fprintf(stderr, "error: %s: %s\n", sweep->labels[index], simGetError(sim));
+        simGetResults(sim, &sweep->results[index]);
+        simDestroy(sim);
+    }
+}
+
+void runSweep(optionsType *options, programType *program)
+{
+    sweepType sweep;
+    pthread_t *workers;
+    FILE *file = fopen(options->sweepFile, "r");
+    char line[1024];
+    char *args[64];
+    char *label;
+    int capacity = 16;
+    int argc, bad, i, threads;
+
+    if(file == NULL){
+        fprintf(stderr, "error: cannot open sweep file %s\n", options->sweepFile);
+        exit(1);
+    }
+    sweep.configs = malloc(sizeof(optionsType) * capacity);
+    sweep.labels = malloc(sizeof(char*) * capacity);
+    sweep.count = 0;
+    while(fgets(line, sizeof(line), file)){
+        line[strcspn(line, "\r\n")] = '\0';
+        label = strdup(line);
+        argc = 0;
+        for(args[argc] = strtok(line, " \t"); args[argc] != NULL && argc < 63; args[argc] = strtok(NULL, " \t"))
+            argc++;
+        if(argc == 0 || args[0][0] == '#'){
+            free(label);
+            continue;
+        }
+        if(sweep.count == capacity){
+            capacity *= 2;
+            sweep.configs = realloc(sweep.configs, sizeof(optionsType) * capacity);
+            sweep.labels = realloc(sweep.labels, sizeof(char*) * capacity);
+        }
+        sweep.configs[sweep.count] = *options;
+        bad = parseArgs(argc, args, &sweep.configs[sweep.count]);
+        if(bad >= 0){
+            fprintf(stderr, "error: %s: unknown flag '%s' in '%s'\n", options->sweepFile, args[bad], label);
+            exit(1);
+        }
+        sweep.configs[sweep.count].outputMode = QUIET;
+        sweep.configs[sweep.count].sweepFile = NULL;
+        sweep.configs[sweep.count].checkpointFile = NULL;
+        sweep.configs[sweep.count].debugFile = NULL;
+        sweep.configs[sweep.count].snapshotInterval = 0;
+        sweep.labels[sweep.count] = label;
+        sweep.count++;
+    }
+    fclose(file);
+
+    sweep.results = calloc(sweep.count ? sweep.count : 1, sizeof(resultsType));
+    sweep.program = program;
+    sweep.next = 0;
+    pthread_mutex_init(&sweep.lock, NULL);
+
+    threads = options->threads < sweep.count ? options->threads : sweep.count;
+    workers = malloc(sizeof(pthread_t) * (threads ? threads : 1));
+    for(i = 0; i < threads; i++){
+        if(pthread_create(&workers[i], NULL, sweepWorker, &sweep) != 0){
+            fprintf(stderr, "error: cannot start sweep thread\n");
+            exit(1);
+        }
+    }
+    for(i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+    pthread_mutex_destroy(&sweep.lock);
+
+    printf("%-40s %12s %6s %10s %10s %12s %9s\n", "Configuration", "Cycles", "IPC", "Stalls", "Branches",
+           "Mispredicted", "Accuracy");
+    for(i = 0; i < sweep.count; i++){
+        resultsType *r = &sweep.results[i];
+        if(r->functional)
+            printf("%-40s %12s %6s %10s %10s %12s %9s   %lld instructions\n", sweep.labels[i], "-", "-", "-", "-", "-", "-",
+                   r->instructions);
+        else
+            printf("%-40s %12lld %6.3f %10lld %10lld %12lld %8.2f%%\n", sweep.labels[i], r->cycles,
+                   r->cycles ? (double)r->counters[CTR_RETIRED] / r->cycles : 0.0, r->stalls, r->branches,
+                   r->mispredictions, r->branches ? 100.0 * (r->branches - r->mispredictions) / r->branches : 100.0);
+        free(sweep.labels[i]);
+    }
+    fflush(stdout);
+
+    free(workers);
+    free(sweep.results);
+    free(sweep.labels);
+    free(sweep.configs);
+}
+
+/******************************************************************/
+/* The debugger runs a program on the scalar pipeline under the   */
+/* control of commands read from stdin, one per line:             */
+/*   step [N]        run N cycles (default 1)                     */
+/*   stepi [N]       run until N more instructions retire         */
+/*   continue        run until a breakpoint or the HALT           */
+/*   rstep [N]       go back N cycles                             */
+/*   rstepi [N]      go back to before the Nth latest retirement  */
+/*   rcontinue       go back to the latest breakpoint hit         */
+/*   goto N          go to the beginning of cycle N               */
+/*   break pc A      stop when the PC becomes A                   */
+/*   break cycle N   stop at the beginning of cycle N             */
+/*   break stall     stop after a cycle that stalled              */
+/*   break mispredict  stop after a mispredicted branch resolves  */
+/*   watch reg R     stop after a write to regFile[R]             */
+/*   watch mem I     stop after a write to dataMem[I]             */
+/*   delete N        remove breakpoint N                          */
+/*   info            list the breakpoints                         */
+/*   print [WHAT]    print the state, or one of pc, ifid, idex,   */
+/*                   exmem, memwb, regs, mem, reg R, mem I, stats */
+/*   quit                                                         */
+/* Going back rewinds to a snapshot and simulates forward again,  */
+/* so it reaches exactly the state the run had.                   */
+/******************************************************************/
+#define BREAK_PC 0
+#define BREAK_CYCLE 1
+#define BREAK_STALL 2
+#define BREAK_MISPREDICT 3
+#define BREAK_REG 4
+#define BREAK_MEM 5
+
+#define MAXBREAKS 64
+
+typedef struct breakStruct {
+  int kind;                               /* BREAK_* */
+  int value;                              /* Address, cycle, register or dataMem index */
+  int active;                             /* 0 once deleted */
+} breakType;
+
+typedef struct debuggerStruct {
+  simulatorType *sim;
+  breakType breaks[MAXBREAKS];
+  int count;                              /* Breakpoints ever set, numbered from 1 */
+  int interval;                           /* Cycles between snapshots */
+} debuggerType;
+
+long long debugRetired(simulatorType *sim)
+{
+    resultsType results;
+
+    simGetResults(sim, &results);
+    return results.counters[CTR_RETIRED];
+}
+
+/* Returns the index of a breakpoint hit by the last cycle, or -1. */
+/* pc is the PC before that cycle.                                 */
+int debugHit(debuggerType *dbg, int pc)
+{
+    stateType *state = simGetState(dbg->sim);
+    writeType *writes;
+    int count = simGetWrites(dbg->sim, &writes);
+    int i, j;
+
+    for(i = 0; i < dbg->count; i++){
+        breakType *b = &dbg->breaks[i];
+        if(!b->active)
+            continue;
+        if((b->kind == BREAK_PC && state->PC == b->value && pc != b->value) ||
+           (b->kind == BREAK_CYCLE && state->cycles + 1 == b->value) ||
+           (b->kind == BREAK_STALL && (simGetEvents(dbg->sim) & EVENT_STALL)) ||
+           (b->kind == BREAK_MISPREDICT && (simGetEvents(dbg->sim) & EVENT_MISPREDICT)))
+            return i;
+        for(j = 0; j < count; j++)
+            if((b->kind == BREAK_REG && writes[j].kind == TRACE_REG && writes[j].index == b->value) ||
+               (b->kind == BREAK_MEM && writes[j].kind == TRACE_MEM && writes[j].index == b->value))
+                return i;
+    }
+    return -1;
+}
+
+void debugDescribe(breakType *b)
+{
+    static const char *names[] = {"pc", "cycle", "stall", "mispredict", "reg", "mem"};
+
+    if(b->kind == BREAK_REG || b->kind == BREAK_MEM)
+        printf("watch %s %d", names[b->kind], b->value);
+    else if(b->kind == BREAK_PC || b->kind == BREAK_CYCLE)
+        printf("break %s %d", names[b->kind], b->value);
+    else
+        printf("break %s", names[b->kind]);
+}
+
+/* Prints where the run stands, with the writes of the last cycle */
+void debugWhere(debuggerType *dbg, int hit)
+{
+    stateType *state = simGetState(dbg->sim);
+    writeType *writes;
+    int count = simGetWrites(dbg->sim, &writes);
+    int i;
+
+    if(hit >= 0){
+        printf("Breakpoint %d, ", hit + 1);
+        debugDescribe(&dbg->breaks[hit]);
+        printf("\n");
+    }
+    printf("Cycle %lld, PC %d, %lld retired", state->cycles + 1, state->PC, debugRetired(dbg->sim));
+    if(simGetStatus(dbg->sim) == SIM_HALTED)
+        printf(", halted");
+    printf("\n");
+    for(i = 0; i < count && state->cycles > simRewindStart(dbg->sim); i++)
+        printf("\t%s[%d] = %d, was %d\n", writes[i].kind == TRACE_REG ? "regFile" : "dataMem",
+               writes[i].index, writes[i].value, writes[i].oldValue);
+    if(simGetStatus(dbg->sim) == SIM_ERROR)
+        printf("error: %s\n", simGetError(dbg->sim));
+}
+
+/* Runs up to cycles cycles forward, or until retired instructions */
+/* reach retire (-1 for no limit), a breakpoint is hit if breaks   */
+/* is set, or the run stops. Returns the breakpoint hit, or -1.    */
+int debugForward(debuggerType *dbg, long long cycles, long long retire, int breaks)
+{
+    stateType *state = simGetState(dbg->sim);
+    int pc, hit;
+
+    for( ; cycles != 0 && simGetStatus(dbg->sim) == SIM_RUNNING; cycles--){
+        pc = state->PC;
+        simStep(dbg->sim, 1);
+        state = simGetState(dbg->sim);
+        if(breaks && (hit = debugHit(dbg, pc)) >= 0)
+            return hit;
+        if(retire >= 0 && debugRetired(dbg->sim) >= retire)
+            break;
+    }
+    return -1;
+}
+
+int debugRewind(debuggerType *dbg, long long cycles)
+{
+    char error[ERRORLENGTH];
+
+    if(simRewind(dbg->sim, cycles, error) != 0){
+        fprintf(stderr, "error: %s\n", error);
+        return -1;
+    }
+    return 0;
+}
+
+/* Goes back to the latest breakpoint hit, a snapshot interval at a */
+/* time, replaying each interval to find its last hit.              */
+int debugReverse(debuggerType *dbg)
+{
+    long long end = simGetState(dbg->sim)->cycles;
+    long long start, last, first;
+    int hit, which, pc;
+
+    while(end > (first = simRewindStart(dbg->sim))){
+        start = end - dbg->interval > first ? end - dbg->interval : first;
+        if(debugRewind(dbg, start) != 0)
+            return -1;
+        last = -1;
+        which = -1;
+        while(simGetState(dbg->sim)->cycles < end){
+            pc = simGetState(dbg->sim)->PC;
+            simStep(dbg->sim, 1);
+            if((hit = debugHit(dbg, pc)) >= 0 && simGetState(dbg->sim)->cycles < end){
+                last = simGetState(dbg->sim)->cycles;
+                which = hit;
+            }
+        }
+        if(last >= 0){
+            debugRewind(dbg, last);
+            return which;
+        }
+        end = start;
+    }
+    debugRewind(dbg, simRewindStart(dbg->sim));
+    return -1;
+}
+
+void debugPrintLatch(stateType *state, char *latch)
+{
+    if(strcmp(latch, "ifid") == 0){
+        printf("\tIF/ID:\n\t\tInstruction: ");
+        printInstruction(state->IFID.instr);
+        printf("\t\tPCPlus4: %d\n\t\tbpb: %d\n", state->IFID.PCPlus4, state->IFID.bpb);
+    }
+    else if(strcmp(latch, "idex") == 0){
+        printf("\tID/EX:\n\t\tInstruction: ");
+        printInstruction(state->IDEX.instr);
+        printf("\t\tPCPlus4: %d\n\t\tbranchTarget: %d\n\t\treadData1: %d\n\t\treadData2: %d\n"
+               "\t\timmed: %d\n\t\trs: %d\n\t\trt: %d\n\t\trd: %d\n\t\tbpb: %d\n\t\tbusy: %d\n",
+               state->IDEX.PCPlus4, state->IDEX.branchTarget, state->IDEX.readData1, state->IDEX.readData2,
+               state->IDEX.immed, state->IDEX.rsReg, state->IDEX.rtReg, state->IDEX.rdReg, state->IDEX.bpb,
+               state->IDEX.busy);
+    }
+    else if(strcmp(latch, "exmem") == 0){
+        printf("\tEX/MEM:\n\t\tInstruction: ");
+        printInstruction(state->EXMEM.instr);
+        printf("\t\taluResult: %d\n\t\twriteDataReg: %d\n\t\twriteReg: %d\n\t\tbpb: %d\n",
+               state->EXMEM.aluResult, state->EXMEM.writeDataReg, state->EXMEM.writeReg, state->EXMEM.bpb);
+    }
+    else{
+        printf("\tMEM/WB:\n\t\tInstruction: ");
+        printInstruction(state->MEMWB.instr);
+        printf("\t\twriteDataMem: %d\n\t\twriteDataALU: %d\n\t\twriteReg: %d\n",
+               state->MEMWB.writeDataMem, state->MEMWB.writeDataALU, state->MEMWB.writeReg);
+    }
+}
+
+void debugPrint(debuggerType *dbg, char *what, char *arg)
+{
+    stateType *state = simGetState(dbg->sim);
+    resultsType results;
+    int i, index;
+
+    if(what == NULL || strcmp(what, "state") == 0)
+        printState(state);
+    else if(strcmp(what, "pc") == 0)
+        printf("PC = %d\n", state->PC);
+    else if(strcmp(what, "ifid") == 0 || strcmp(what, "idex") == 0 || strcmp(what, "exmem") == 0 ||
+            strcmp(what, "memwb") == 0)
+        debugPrintLatch(state, what);
+    else if(strcmp(what, "regs") == 0)
+        for(i = 0; i < NUMREGS; i++)
+            printf("regFile[%d] = %d\n", i, state->regFile[i]);
+    else if(strcmp(what, "reg") == 0 && arg != NULL && sscanf(arg, "%d", &index) == 1 &&
+            index >= 0 && index < NUMREGS)
+        printf("regFile[%d] = %d\n", index, state->regFile[index]);
+    else if(strcmp(what, "mem") == 0 && arg == NULL)
+        for(i = 0; i < state->dataSize; i++)
+            printf("dataMem[%d] = %d\n", i, state->dataMem[i]);
+    else if(strcmp(what, "mem") == 0 && sscanf(arg, "%d", &index) == 1 && index >= 0 && index < state->dataSize)
+        printf("dataMem[%d] = %d\n", index, state->dataMem[index]);
+    else if(strcmp(what, "stats") == 0){
+        simGetResults(dbg->sim, &results);
+        printResults(&results);
+    }
+    else
+        fprintf(stderr, "error: print expects state, pc, ifid, idex, exmem, memwb, regs, reg R, mem [I] or stats\n");
+}
+
+/* Adds a breakpoint from the words after break or watch */
+void debugBreak(debuggerType *dbg, int watch, char *what, char *arg)
+{
+    stateType *state = simGetState(dbg->sim);
+    breakType b;
+
+    b.active = 1;
+    b.value = 0;
+    if(what != NULL && arg != NULL && sscanf(arg, "%d", &b.value) != 1)
+        what = NULL;
+    if(what == NULL)
+        b.kind = -1;
+    else if(!watch && strcmp(what, "pc") == 0 && arg != NULL)
+        b.kind = BREAK_PC;
+    else if(!watch && strcmp(what, "cycle") == 0 && arg != NULL)
+        b.kind = BREAK_CYCLE;
+    else if(!watch && strcmp(what, "stall") == 0 && arg == NULL)
+        b.kind = BREAK_STALL;
+    else if(!watch && strcmp(what, "mispredict") == 0 && arg == NULL)
+        b.kind = BREAK_MISPREDICT;
+    else if(watch && strcmp(what, "reg") == 0 && arg != NULL && b.value >= 0 && b.value < NUMREGS)
+        b.kind = BREAK_REG;
+    else if(watch && strcmp(what, "mem") == 0 && arg != NULL && b.value >= 0 && b.value < state->dataSize)
+        b.kind = BREAK_MEM;
+    else
+        b.kind = -1;
+    if(b.kind < 0){
+        fprintf(stderr, watch ? "error: watch expects reg R or mem I\n" :
+                                "error: break expects pc A, cycle N, stall or mispredict\n");
+        return;
+    }
+    if(dbg->count == MAXBREAKS){
+        fprintf(stderr, "error: at most %d breakpoints can be set\n", MAXBREAKS);
+        return;
+    }
+    dbg->breaks[dbg->count++] = b;
+    printf("Breakpoint %d, ", dbg->count);
+    debugDescribe(&b);
+    printf("\n");
+}
+
+void debugProgram(optionsType *options, programType *program)
+{
+    debuggerType dbg;
+    optionsType config = *options;
+    char line[1024], word[1026];
+    char *command, *arg, *arg2;
+    long long n, retired;
+    int i, hit;
+
+    config.outputMode = QUIET;
+    dbg.sim = simCreate(&config, program);
+    if(dbg.sim == NULL){
+        fprintf(stderr, "error: cannot allocate the simulator\n");
+        exit(1);
+    }
+    if(simGetStatus(dbg.sim) == SIM_ERROR){
+        fprintf(stderr, "error: %s\n", simGetError(dbg.sim));
+        exit(1);
+    }
+    dbg.count = 0;
+    dbg.interval = config.snapshotInterval;
+    debugWhere(&dbg, -1);
+
+    while(printf("(debug) "), fflush(stdout), fgets(line, sizeof(line), stdin) != NULL){
+        command = strtok(line, " \t\r\n");
+        arg = strtok(NULL, " \t\r\n");
+        arg2 = strtok(NULL, " \t\r\n");
+        if(command == NULL)
+            continue;
+        n = 1;
+        snprintf(word, sizeof(word), " %s ", command);
+        if(arg != NULL && strstr(" step s stepi si rstep rs rstepi rsi ", word) != NULL &&
+           (sscanf(arg, "%lld", &n) != 1 || n < 1)){
+            fprintf(stderr, "error: %s expects a positive count\n", command);
+            continue;
+        }
+
+        if(strcmp(command, "step") == 0 || strcmp(command, "s") == 0){
+            debugForward(&dbg, n, -1, 0);
+            debugWhere(&dbg, -1);
+        }
+        else if(strcmp(command, "stepi") == 0 || strcmp(command, "si") == 0){
+            debugForward(&dbg, -1, debugRetired(dbg.sim) + n, 0);
+            debugWhere(&dbg, -1);
+        }
+        else if(strcmp(command, "continue") == 0 || strcmp(command, "c") == 0){
+            hit = debugForward(&dbg, -1, -1, 1);
+            debugWhere(&dbg, hit);
+        }
+        else if(strcmp(command, "rstep") == 0 || strcmp(command, "rs") == 0){
+            n = simGetState(dbg.sim)->cycles - n;
+            debugRewind(&dbg, n > simRewindStart(dbg.sim) ? n : simRewindStart(dbg.sim));
+            debugWhere(&dbg, -1);
+        }
+        else if(strcmp(command, "rstepi") == 0 || strcmp(command, "rsi") == 0){
+            retired = debugRetired(dbg.sim) - n;
+            while(debugRetired(dbg.sim) > retired && simGetState(dbg.sim)->cycles > simRewindStart(dbg.sim) &&
+                  debugRewind(&dbg, simGetState(dbg.sim)->cycles - 1) == 0)
+                ;
+            debugWhere(&dbg, -1);
+        }
+        else if(strcmp(command, "rcontinue") == 0 || strcmp(command, "rc") == 0){
+            hit = debugReverse(&dbg);
+            debugWhere(&dbg, hit);
+        }
+        else if(strcmp(command, "goto") == 0 || strcmp(command, "g") == 0){
+            if(arg == NULL || sscanf(arg, "%lld", &n) != 1 || n < 1){
+                fprintf(stderr, "error: goto expects a cycle number\n");
+                continue;
+            }
+            if(n - 1 <= simGetState(dbg.sim)->cycles)
+                debugRewind(&dbg, n - 1);
+            else
+                debugForward(&dbg, n - 1 - simGetState(dbg.sim)->cycles, -1, 0);
+            debugWhere(&dbg, -1);
+        }
+        else if(strcmp(command, "break") == 0 || strcmp(command, "b") == 0)
+            debugBreak(&dbg, 0, arg, arg2);
+        else if(strcmp(command, "watch") == 0 || strcmp(command, "w") == 0)
+            debugBreak(&dbg, 1, arg, arg2);
+        else if(strcmp(command, "delete") == 0 || strcmp(command, "d") == 0){
+            if(arg == NULL || sscanf(arg, "%d", &i) != 1 || i < 1 || i > dbg.count || !dbg.breaks[i - 1].active)
+                fprintf(stderr, "error: no breakpoint %s\n", arg != NULL ? arg : "given");
+            else
+                dbg.breaks[i - 1].active = 0;
+        }
+        else if(strcmp(command, "info") == 0 || strcmp(command, "i") == 0){
+            for(i = 0; i < dbg.count; i++)
+                if(dbg.breaks[i].active){
+                    printf("%d: ", i + 1);
+                    debugDescribe(&dbg.breaks[i]);
+                    printf("\n");
+                }
+        }
+        else if(strcmp(command, "print") == 0 || strcmp(command, "p") == 0)
+            debugPrint(&dbg, arg, arg2);
+        else if(strcmp(command, "quit") == 0 || strcmp(command, "q") == 0)
+            break;
+        else
+            fprintf(stderr, "error: unknown command '%s'\n", command);
+    }
+    simDestroy(dbg.sim);
+}
@@ -1,548 +1,4965 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "proj2.h"
 
-#define NUMMEMORY 16 /* Maximum number of data words in memory */
-#define NUMREGS 8    /* Number of registers */
-
-/* Opcode values for instructions */
-#define R 0
-#define LW 35
-#define SW 43
-#define BNE 4
-#define HALT 63
-
-/* Funct values for R-type instructions */
-#define ADD 32
-#define SUB 34
-
-/* Branch Prediction Buffer Values */
-#define STRONGLYTAKEN 3
-#define WEAKLYTAKEN 2
-#define WEAKLYNOTTAKEN 1
-#define STRONGLYNOTTAKEN 0
-
-typedef struct IFIDStruct {
-  unsigned int instr;              /* Integer representation of instruction */
-  int PCPlus4;                     /* PC + 4 */
-  int bpb;
-} IFIDType;
-
-typedef struct IDEXStruct {
-  unsigned int instr;              /* Integer representation of instruction */
-  int PCPlus4;                     /* PC + 4 */
-  int readData1;                   /* Contents of rs register */
-  int readData2;                   /* Contents of rt register */
-  int immed;                       /* Immediate field */
-  int rsReg;                       /* Number of rs register */
-  int rtReg;                       /* Number of rt register */
-  int rdReg;                       /* Number of rd register */
-  int branchTarget;                /* Branch target, obtained from immediate field */
-  int bpb;
-} IDEXType;
-
-typedef struct EXMEMStruct {
-  unsigned int instr;              /* Integer representation of instruction */
-  int aluResult;                   /* Result of ALU operation */
-  int writeDataReg;                /* Contents of the rt register, used for store word */
-  int writeReg;                    /* The destination register */
-  int bpb;
-} EXMEMType;
-
-typedef struct MEMWBStruct {
-  unsigned int instr;              /* Integer representation of instruction */
-  int writeDataMem;                /* Data read from memory */
-  int writeDataALU;                /* Result from ALU operation */
-  int writeReg;                    /* The destination register */
-  int bpb;
-} MEMWBType;
-
-typedef struct stateStruct {
-  int PC;                                 /* Program Counter */
-  unsigned int instrMem[NUMMEMORY];       /* Instruction memory */
-  int dataMem[NUMMEMORY];                 /* Data memory */
-  int regFile[NUMREGS];                   /* Register file */
-  IFIDType IFID;                          /* Current IFID pipeline register */
-  IDEXType IDEX;                          /* Current IDEX pipeline register */
-  EXMEMType EXMEM;                        /* Current EXMEM pipeline register */
-  MEMWBType MEMWB;                        /* Current MEMWB pipeline register */
-  int cycles;                             /* Number of cycles executed so far */
-  //unsigned int bpb;
-} stateType;
-
-void run();
-void printState(stateType*);
-void initState(stateType*);
-unsigned int instrToInt(char*, char*);
+/* Checkpoint file identification */
+#define CHECKPOINTMAGIC "PIPECKPT"
+#define CHECKPOINTVERSION 8
+#define IMAGEMAGIC "PIPEIMG"
+#define IMAGEVERSION 2
+
+/* Every branch predictor is driven through predict and update. predict  */
+/* returns 1 for taken and, if hasTarget is set, stores the target. The  */
+/* tables a kind does not use are left NULL.                              */
+typedef struct predictorStruct {
+  int kind;                               /* PRED_* */
+  int hasTarget;                          /* 1 if predict supplies the target at fetch */
+  unsigned int mask;                      /* Table size - 1 */
+  unsigned int history;                   /* Global history register, newest outcome in bit 0 */
+  unsigned int historyMask;               /* (1 << historyBits) - 1 */
+  unsigned char *counters;                /* 2-bit counters: the global/local/gshare/BTB table, */
+                                          /* or the local table of a tournament predictor */
+  unsigned char *globalCounters;          /* Tournament: gshare counters */
+  unsigned char *chooser;                 /* Tournament: 2-bit counters, taken means use gshare */
+  int *tags;                              /* BTB: PC of the branch in each entry, -1 if empty */
+  int *targets;                           /* BTB: branch target of each entry */
+  long long branches;                     /* Branches resolved */
+  long long mispredictions;               /* Branches resolved against the prediction */
+  int (*predict)(struct predictorStruct*, int, int*);
+  void (*update)(struct predictorStruct*, int, int, int);
+} predictorType;
+
+/* A bump allocator holding the register file and memories, which */
+/* live outside the pipeline state so copying the state does not  */
+/* copy them.                                                     */
+typedef struct arenaStruct {
+  char *base;                             /* Start of the block */
+  size_t size;                            /* Size of the block in bytes */
+  size_t used;                            /* Bytes handed out so far */
+  void *mapped;                           /* Checkpoint mapping the memories point into, or NULL */
+  size_t mappedSize;                      /* Size of the mapping in bytes */
+} arenaType;
+
+/* Pipeline registers as seen by the hazard and forwarding unit */
+#define STAGE_NONE 0       /* The value is in the register file */
+#define STAGE_MEM 1        /* ALU result in EX/MEM */
+#define STAGE_WB 2         /* Result being written back from MEM/WB */
+#define STAGE_EX 3         /* Not computed yet: the instruction is in ID/EX */
+
+/* Register fields named by the instruction table */
+#define FIELD_NONE 0
+#define FIELD_RS 1
+#define FIELD_RT 2
+#define FIELD_RD 3
+#define FIELD_LINK 4       /* LINKREG, which no field names */
+
+/* The instruction table drives decode, hazard detection and       */
+/* forwarding: each row names the registers an instruction reads   */
+/* and writes, its ALU operation and its other datapath uses.      */
+/* Adding an instruction only takes a row here, up to MAXOPCODES,  */
+/* and an ALU_* operation in aluCompute if none fits. The ALU      */
+/* reads its first operand from rs and its second from rt, and a   */
+/* row names only those it uses. Encodings without a row, and the  */
+/* all-zero word, execute as NOOPs.                                */
+typedef struct opInfoStruct {
+  char *counter;                          /* Name of its retired-instruction counter */
+  int opcode;
+  int funct;                              /* Funct of R-type rows, -1 for the others */
+  int src1, src2, dest;                   /* FIELD_* */
+  int alu;                                /* ALU_* */
+  int flags;                              /* OP_* */
+} opInfoType;
+
+opInfoType opTable[] = {
+  {"retired.add",  R,    ADD, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_ADD,  0},
+  {"retired.sub",  R,    SUB, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_SUB,  0},
+  {"retired.lw",   LW,   -1,  FIELD_RS,   FIELD_NONE, FIELD_RT,   ALU_ADDI, OP_LOAD},
+  {"retired.sw",   SW,   -1,  FIELD_RS,   FIELD_RT,   FIELD_NONE, ALU_ADDI, OP_STORE},
+  {"retired.bne",  BNE,  -1,  FIELD_RS,   FIELD_RT,   FIELD_NONE, ALU_SUB,  OP_BRANCH},
+  {"retired.halt", HALT, -1,  FIELD_NONE, FIELD_NONE, FIELD_NONE, ALU_NONE, OP_HALT},
+  {"retired.beq",  BEQ,  -1,  FIELD_RS,   FIELD_RT,   FIELD_NONE, ALU_EQ,   OP_BRANCH},
+  {"retired.addi", ADDI, -1,  FIELD_RS,   FIELD_NONE, FIELD_RT,   ALU_ADDS, 0},
+  {"retired.slti", SLTI, -1,  FIELD_RS,   FIELD_NONE, FIELD_RT,   ALU_SLTI, 0},
+  {"retired.andi", ANDI, -1,  FIELD_RS,   FIELD_NONE, FIELD_RT,   ALU_ANDI, 0},
+  {"retired.ori",  ORI,  -1,  FIELD_RS,   FIELD_NONE, FIELD_RT,   ALU_ORI,  0},
+  {"retired.xori", XORI, -1,  FIELD_RS,   FIELD_NONE, FIELD_RT,   ALU_XORI, 0},
+  {"retired.and",  R,    AND, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_AND,  0},
+  {"retired.or",   R,    OR,  FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_OR,   0},
+  {"retired.xor",  R,    XOR, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_XOR,  0},
+  {"retired.nor",  R,    NOR, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_NOR,  0},
+  {"retired.slt",  R,    SLT, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_SLT,  0},
+  {"retired.sll",  R,    SLL, FIELD_NONE, FIELD_RT,   FIELD_RD,   ALU_SLL,  0},
+  {"retired.srl",  R,    SRL, FIELD_NONE, FIELD_RT,   FIELD_RD,   ALU_SRL,  0},
+  {"retired.sra",  R,    SRA, FIELD_NONE, FIELD_RT,   FIELD_RD,   ALU_SRA,  0},
+  {"retired.sllv", R,    SLLV, FIELD_RS,  FIELD_RT,   FIELD_RD,   ALU_SLLV, 0},
+  {"retired.srlv", R,    SRLV, FIELD_RS,  FIELD_RT,   FIELD_RD,   ALU_SRLV, 0},
+  {"retired.srav", R,    SRAV, FIELD_RS,  FIELD_RT,   FIELD_RD,   ALU_SRAV, 0},
+  {"retired.mul",  R,    MUL, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_MUL,  OP_LONG},
+  {"retired.div",  R,    DIV, FIELD_RS,   FIELD_RT,   FIELD_RD,   ALU_DIV,  OP_LONG},
+  {"retired.j",    J,    -1,  FIELD_NONE, FIELD_NONE, FIELD_NONE, ALU_NONE, OP_JUMP},
+  {"retired.jal",  JAL,  -1,  FIELD_NONE, FIELD_NONE, FIELD_LINK, ALU_LINK, OP_JUMP},
+  {"retired.jr",   R,    JR,  FIELD_RS,   FIELD_NONE, FIELD_NONE, ALU_PASS, OP_INDIRECT},
+};
+#define OPCOUNT (int)(sizeof(opTable) / sizeof(opTable[0]))  /* Rows of opTable */
+
+/* Flags kept in the low bits of a cache line entry, below the tag. */
+/* A coherent data cache keeps a valid line modified (dirty),       */
+/* exclusive or, with neither flag, shared.                         */
+#define LINEVALID 1
+#define LINEDIRTY 2
+#define LINEEXCLUSIVE 4    /* No other cache holds the line */
+#define LINESTOLEN 8       /* Invalid because another core wrote the line; the tag is kept */
+#define LINETAGSHIFT 4     /* Position of the tag */
+
+/* A cache only tracks tags; the data stays in the memories. All   */
+/* lines live in one flat array, set after set, so a lookup scans   */
+/* ways consecutive words. A cache with no sets is disabled.        */
+typedef struct cacheStruct {
+  int sets;                               /* Number of sets, a power of two, 0 if disabled */
+  int ways;                               /* Lines per set */
+  int lineShift;                          /* log2 of the line size in bytes */
+  int setShift;                           /* log2 of sets */
+  int replacement;                        /* CACHE_LRU or CACHE_PLRU */
+  int writePolicy;                        /* WRITEBACK or WRITETHROUGH */
+  int latency;                            /* Cycles to fetch or write back a line */
+  unsigned int *lines;                    /* sets * ways entries of (tag << LINETAGSHIFT) | LINE* flags */
+  unsigned char *age;                     /* LRU: rank of each line within its set, 0 is the newest */
+  unsigned int *plru;                     /* PLRU: tree bits of each set, node n in bit n */
+  cacheStatsType stats;
+} cacheType;
+
+/* A checkpoint file is this header followed by the register file,     */
+/* instrMem, dataMem, decodedMem and the predictor tables, each section */
+/* padded to 8 bytes. Latches are stored as they are in memory, so a    */
+/* checkpoint can only be restored by the same build of the simulator. */
+typedef struct checkpointStruct {
+  char magic[8];                          /* CHECKPOINTMAGIC */
+  int version;                            /* CHECKPOINTVERSION */
+  int stateBytes;                         /* sizeof(stateType) of the writer */
+  int numRegs;                            /* NUMREGS */
+  int instrSize;                          /* Words of instruction memory */
+  int dataSize;                           /* Words of data memory */
+  int PC;
+  long long cycles;
+  long long stalls;                       /* Stall count so far */
+  int predictorKind;                      /* PRED_* */
+  int predictorSize;                      /* Entries per predictor table */
+  int historyBits;                        /* Global history length */
+  unsigned int history;                   /* Global history register */
+  long long branches;                     /* Predictor statistics */
+  long long mispredictions;
+  long long counters[NUMCOUNTERS];        /* Performance counters */
+  IFIDType IFID;
+  IDEXType IDEX;
+  EXMEMType EXMEM;
+  MEMWBType MEMWB;
+} checkpointType;
+
+/* A program image is this header followed by instrMem, decodedMem,    */
+/* dataMem and the symbol table, each section padded to 8 bytes. It is  */
+/* mapped and used in place, so like a checkpoint it is only portable   */
+/* between identical builds.                                            */
+typedef struct imageStruct {
+  char magic[8];                          /* IMAGEMAGIC */
+  int version;                            /* IMAGEVERSION */
+  int decodedBytes;                       /* sizeof(decodedType) of the writer */
+  int instrSize;                          /* Words of instruction memory */
+  int dataSize;                           /* Words of data memory */
+  int symbolCount;
+  int reserved;
+  unsigned long long sourceHash;          /* Hash of the source and sizes, 0 if unknown */
+} imageType;
+
+/* The pipeline registers of a superscalar pipeline. Each holds up  */
+/* to width instructions, oldest first; unused slots are all zero.  */
+typedef struct wideStruct {
+  int ifidCount;                          /* Instructions in each pipeline register */
+  int idexCount;
+  int exmemCount;
+  int memwbCount;
+  IFIDType IFID[MAXWIDTH];
+  IDEXType IDEX[MAXWIDTH];
+  EXMEMType EXMEM[MAXWIDTH];
+  MEMWBType MEMWB[MAXWIDTH];
+} wideType;
+
+#define CHECKBATCH 4096    /* Retirements between full comparisons of the checker */
+#define CHECKSTORES 16     /* Stores that may have written memory but not retired */
+
+/* The reference model of the co-simulation checker */
+typedef struct checkerStruct {
+  stateType state;                        /* PC, register file and data memory of the reference */
+  arenaType arena;                        /* Holds its register file and data memory */
+  struct {
+    int address;
+    int data;
+  } stores[CHECKSTORES];                  /* Stores written by the pipeline, oldest first, */
+  int storeHead;                          /* waiting for their retirement */
+  int storeCount;
+  long long retired;                      /* Retirements checked */
+  long long nextBatch;                    /* Value of retired at the next full comparison */
+} checkerType;
+
+/* Phases of a sampled run, after functional warming */
+#define SAMPLE_WARMUP 0    /* Detailed, until the window starts */
+#define SAMPLE_MEASURE 1   /* Detailed and measured */
+#define SAMPLE_DRAIN 2     /* Detailed, fetching nothing until the pipeline is empty */
+
+/* A variant of runFunctional, fixed to one predictor kind and cache use */
+typedef long long (*functionalType)(stateType*, predictorType*, cacheType*, cacheType*, long long, int, char*);
+
+/* The sampling engine and the sums it estimates from. A window's */
+/* cycles c, stalls s, branches b and mispredictions m are added  */
+/* up, and so are their squares and m * b.                        */
+typedef struct samplerStruct {
+  int phase;                              /* SAMPLE_* */
+  long long next;                         /* Retired instructions ending the warm-up or the window */
+  long long windowEnd;                    /* Instructions, functional and retired, at which the next window should end */
+  long long cycles;                       /* Cycles, stalls, branches and mispredictions */
+  long long stalls;                       /* when the window started */
+  long long branches;
+  long long mispredictions;
+  int windows;                            /* Windows measured */
+  functionalType warm;                    /* runFunctional variant of the functional stretches */
+  double c, c2, s, s2, b, b2, m, m2, mb;  /* Sums over the windows */
+} samplerType;
+
+/* A debugged run keeps a snapshot of everything but the register */
+/* file and data memory every snapshotInterval cycles, and an undo */
+/* log of the writes to those since its oldest snapshot.          */
+typedef struct snapshotStruct {
+  stateType state;                        /* PC, latches and cycles */
+  int memoryStall;
+  long long stalls;
+  int events;
+  int status;
+  long long counters[NUMCOUNTERS];
+  unsigned int history;                   /* Predictor state outside its tables */
+  long long branches;
+  long long mispredictions;
+  cacheStatsType icache;
+  cacheStatsType dcache;
+  int writes;                             /* Undo log entries made before the snapshot */
+  unsigned char *tables;                  /* Copy of the predictor and cache tables */
+} snapshotType;
+
+typedef struct debugStruct {
+  snapshotType *snapshots;                /* Oldest first */
+  int count;
+  int capacity;
+  writeType *log;                         /* Undo log, oldest first */
+  int writes;
+  int logCapacity;
+  size_t tableBytes;                      /* Size of each snapshot's tables */
+  long long next;                         /* Cycle at whose beginning the next snapshot is taken */
+} debugType;
+
+/* An instruction in one stage of a configurable-depth pipeline */
+typedef struct stageStruct {
+  unsigned int instr;                     /* Integer representation of instruction */
+  int uop;                                /* Index into decodedMem */
+  int PCPlus4;                            /* PC + 4 */
+  int bpb;                                /* 1 if the branch was predicted taken */
+  int result;                             /* ALU result once past the first EX stage, */
+                                          /* loaded data once past the last MEM stage */
+  int storeData;                          /* Data of a store */
+  int taken;                              /* Outcome of a branch */
+  int busy;                               /* Cycles a multiply or divide has spent in the first EX stage */
+} stageType;
+
+/* The latches of a configurable-depth pipeline: stage[s] holds the */
+/* instruction performing stage s, counted from 0 for the first IF. */
+/* stage[0] is unused, since fetch starts from the PC.              */
+typedef struct deepStruct {
+  stageType stage[MAXDEPTH];
+} deepType;
+
+/* An instruction in the reorder buffer of the out-of-order core */
+typedef struct robEntryStruct {
+  unsigned int instr;                     /* Integer representation of instruction */
+  int uop;                                /* Index into decodedMem */
+  int PCPlus4;                            /* PC + 4 */
+  int bpb;                                /* 1 if the branch was predicted taken */
+  int taken;                              /* Outcome of a resolved branch */
+  int done;                               /* 1 once the instruction can commit */
+  int value;                              /* Result */
+  int address;                            /* Data address of a load or store */
+  int fault;                              /* 1 if that address is outside data memory */
+  long long finish;                       /* Cycle a multiply or divide broadcasts, 0 if none is due */
+} robEntryType;
+
+typedef struct stationStruct {
+  int rob;                                /* ROB entry of the instruction, -1 if the station is free */
+  int tag1;                               /* ROB entry producing the first operand, -1 once it is known */
+  int tag2;
+  int value1;
+  int value2;
+} stationType;
+
+typedef struct lsqEntryStruct {
+  int rob;                                /* ROB entry of the load or store */
+  int store;                              /* 1 for a store, 0 for a load */
+  int ready;                              /* 1 once the address, and for a store the data, are known */
+  int address;
+  int data;                               /* Store data */
+} lsqEntryType;
+
+/* The out-of-order core. The ROB and the LSQ are circular buffers in */
+/* program order; ROB entries are named by their index.               */
+typedef struct coreStruct {
+  robEntryType *rob;                      /* robSize entries */
+  int robHead;
+  int robCount;
+  stationType *stations;                  /* rsSize reservation stations */
+  int stationCount;                       /* Busy stations */
+  lsqEntryType *lsq;                      /* lsqSize entries */
+  int lsqHead;
+  int lsqCount;
+  int map[NUMREGS];                       /* ROB entry producing each register, -1 for regFile */
+  IFIDType fetch[MAXWIDTH];               /* Fetch buffer, oldest first */
+  int fetchCount;
+  int pending;                            /* Multiplies and divides still to broadcast */
+  long long divideFree;                   /* First cycle the divider can start a divide */
+} coreType;
+
+/* A multicore run: scalar pipelines sharing one data memory, their */
+/* data caches kept coherent by snooping a shared bus. Core i is    */
+/* stepped by host thread i % threadCount, thread 0 being the one   */
+/* calling simStep; the others wait for the next round, in which    */
+/* every core runs quantum cycles.                                  */
+typedef struct multicoreStruct {
+  simulatorType *cores[MAXCORES];         /* One scalar simulator per core */
+  int count;                              /* Number of cores */
+  int protocol;                           /* COHERENCE_MSI or COHERENCE_MESI */
+  pthread_mutex_t bus;                    /* Serializes bus transactions and the snooping of caches */
+  pthread_t threads[MAXCORES];            /* Host threads 1 to threadCount - 1 */
+  int threadCount;
+  int started;                            /* Threads that have taken their number */
+  pthread_mutex_t lock;                   /* Protects the fields below */
+  pthread_cond_t start;                   /* Signalled when a round begins or the run ends */
+  pthread_cond_t finish;                  /* Signalled when the last thread finishes a round */
+  long long round;                        /* Rounds begun so far */
+  int quantum;                            /* Cycles of the current round */
+  int active;                             /* Threads still stepping the current round */
+  int quit;                               /* 1 once the threads should exit */
+} multicoreType;
+
+long long runFunctional(stateType*, predictorType*, cacheType*, cacheType*, long long, int, char*);
+int initState(stateType*, arenaType*, programType*, char*);
+int arenaInit(arenaType*, size_t, char*);
+void *arenaAlloc(arenaType*, size_t);
+void arenaFree(arenaType*);
+int fetchUop(stateType*, int);
+int fetchFault(stateType*, char*);
+int dataIndex(stateType*, int, char*);
+int aluCompute(decodedType*, int, int, int);
+int unitLatency(optionsType*, decodedType*);
+int predictorInit(predictorType*, optionsType*, char*);
+int writeCheckpoint(char*, stateType*, predictorType*, long long, long long*, char*);
+int readCheckpoint(char*, stateType*, arenaType*, predictorType*, long long*, long long*, char*);
+void predictorFree(predictorType*);
+void predictorResolve(predictorType*, int, int, int, int);
+int globalPredict(predictorType*, int, int*);
+void globalUpdate(predictorType*, int, int, int);
+int localPredict(predictorType*, int, int*);
+void localUpdate(predictorType*, int, int, int);
+int btbPredict(predictorType*, int, int*);
+void btbUpdate(predictorType*, int, int, int);
+int gsharePredict(predictorType*, int, int*);
+void gshareUpdate(predictorType*, int, int, int);
+int tournamentPredict(predictorType*, int, int*);
+void tournamentUpdate(predictorType*, int, int, int);
+int cacheInit(cacheType*, int, int, int, optionsType*, char*);
+void cacheTouch(cacheType*, int, int);
+int cacheVictim(cacheType*, int);
+int cacheAccess(cacheType*, int, int);
+void cacheFree(cacheType*);
+void cacheStatsAdd(cacheStatsType*, cacheStatsType*);
+void decodeInstr(unsigned int, decodedType*);
+int decodeProgram(unsigned int*, decodedType*, int);
+int growArray(void**, int, size_t, char*);
+unsigned int symbolHash(const char*, int);
+int *symbolSlot(programType*, int*, int, const char*, int);
+int symbolGrow(programType*, int**, int*, char*);
+int assemble(programType*, optionsType*, const char*, size_t, char*);
+unsigned long long sourceHash(optionsType*, const char*, size_t);
+int loadImage(programType*, char*, size_t, int, unsigned long long, char*);
+int loadSource(programType*, optionsType*, const char*, size_t, char*);
+int checkpointWrite(FILE*, void*, size_t);
+size_t checkpointSection(size_t);
+typedef int (*stepType)(simulatorType*, long long);
+stepType scalarVariant(simulatorType*);
+functionalType functionalVariant(predictorType*, cacheType*, cacheType*);
+int simStepWide(simulatorType*, long long);
+void printWideState(stateType*, wideType*, int);
+int simStepCore(simulatorType*, long long);
+int simStepDeep(simulatorType*, long long);
+void printDeepState(stateType*, deepType*, optionsType*);
+int coreInit(coreType*, optionsType*);
+void coreFree(coreType*);
+int robAge(coreType*, int, int);
+void coreRename(coreType*, stateType*, int, int*, int*);
+void coreBroadcast(coreType*, int, int, int);
+int coreSquash(coreType*, stateType*, optionsType*, int);
+void printCoreState(stateType*, coreType*, optionsType*);
+int checkInit(simulatorType*);
+void checkFree(simulatorType*);
+void checkStore(simulatorType*, int, int);
+void checkRetire(simulatorType*, stateType*, long long, int, int);
+int checkHalt(simulatorType*, stateType*, long long);
+int multicoreCreate(simulatorType*, programType*);
+void multicoreFree(multicoreType*);
+void *multicoreThread(void*);
+void multicoreShare(multicoreType*, int, int);
+void multicoreResults(multicoreType*, resultsType*);
+int simStepMulti(simulatorType*, long long);
+int busAccess(simulatorType*, int, int, int, int*);
+int busSnoop(simulatorType*, unsigned int, int, int*);
+int sampleStart(simulatorType*);
+void sampleWarm(simulatorType*, stateType*);
+void sampleAdvance(simulatorType*, stateType*);
+void sampleResults(samplerType*, optionsType*, samplingType*);
+int debugStart(simulatorType*);
+void debugFree(simulatorType*);
+size_t debugTables(simulatorType*, unsigned char*, int);
+int debugSnapshot(simulatorType*, stateType*);
+void debugThin(debugType*);
+void debugWrite(simulatorType*, stateType*, int, int, int);
 int get_opcode(unsigned int);
-void printInstruction(unsigned int);
+int get_rs(unsigned int);
+int get_rt(unsigned int);
+int get_rd(unsigned int);
+int get_funct(unsigned int);
+int get_shamt(unsigned int);
+int get_immed(unsigned int);
+
+/******************************************************************/
+/* The simulator functions below are the library interface. A     */
+/* simulator owns all of its mutable state, so any number of them */
+/* may share one program and run at once in different threads.   */
+/******************************************************************/
+struct simulatorStruct {
+  optionsType options;       /* Private copy of the options */
+  stateType buffers[2];      /* The pipeline registers are double buffered */
+  stateType *state;          /* Contains the state of the entire pipeline before the next cycle */
+  stateType *newState;       /* Scratch buffer for the state after the cycle */
+  wideType wideBuffers[2];   /* Latches of a superscalar pipeline, double buffered */
+  wideType *wide;            /* Before the next cycle */
+  wideType *newWide;         /* Scratch buffer for after the cycle */
+  coreType core;             /* Out-of-order core, when enabled */
+  deepType deepBuffers[2];   /* Latches of a configurable-depth pipeline, double buffered */
+  deepType *deep;            /* Before the next cycle */
+  deepType *newDeep;         /* Scratch buffer for after the cycle */
+  arenaType arena;           /* Holds the register file and the data memory */
+  predictorType predictor;   /* Branch predictor shared by all branches */
+  cacheType icache;          /* Instruction cache, disabled unless configured */
+  cacheType dcache;          /* Data cache, disabled unless configured */
+  int memoryStall;           /* Cycles left in the current cache miss */
+  long long counters[NUMCOUNTERS];  /* Performance counters, CTR_* */
+  checkerType *checker;      /* Reference model checking every retirement, or NULL */
+  multicoreType *multicore;  /* The cores this simulator drives, or NULL */
+  multicoreType *bus;        /* The run this simulator is a core of, whose bus its data cache snoops, or NULL */
+  int coreId;                /* Number of this core */
+  samplerType *sampler;      /* Sampling engine, or NULL to simulate everything in detail */
+  stepType step;             /* Scalar pipeline variant chosen by the first simStep, or NULL */
+  debugType *debug;          /* Snapshots and undo log of a run that can be rewound, or NULL */
+  int draining;              /* 1 while fetch is stopped to empty the pipeline */
+  FILE *trace;               /* Binary trace being recorded, or NULL */
+  traceCycleType traceRecord;       /* Record of the cycle being executed */
+  traceWriteType traceWrites[2];    /* Its register and memory writes */
+  long long stalls;          /* Bubbles inserted so far */
+  int events;                /* EVENT_* bits raised during the previous cycle */
+  long long skipped;         /* Instructions executed functionally before the pipeline */
+  int functional;            /* 1 if the whole program ran functionally */
+  int status;                /* SIM_RUNNING, SIM_HALTED, SIM_CHECKPOINTED or SIM_ERROR */
+  char error[ERRORLENGTH];   /* Reason for SIM_ERROR */
+};
+
+/******************************************************************/
+/* The trace functions record the binary trace. traceOpen writes  */
+/* the header and the starting memories; traceCycle writes the    */
+/* record of one cycle, given the state at its beginning, with    */
+/* the events and writes collected while it executed. Output goes */
+/* through a large stdio buffer, and errors are caught by ferror  */
+/* when the simulation stops.                                     */
+/******************************************************************/
+int traceOpen(simulatorType *sim, char *name)
+{
+  traceHeaderType header;
+  stateType *state = sim->state;
+
+  sim->trace = fopen(name, "wb");
+  if(sim->trace == NULL){
+    snprintf(sim->error, ERRORLENGTH, "cannot create trace %s", name);
+    return -1;
+  }
+  setvbuf(sim->trace, NULL, _IOFBF, 1 << 20);
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TRACEMAGIC, 8);
+  header.version = TRACEVERSION;
+  header.cycleBytes = sizeof(traceCycleType);
+  header.numRegs = NUMREGS;
+  header.dataSize = state->dataSize;
+  fwrite(&header, sizeof(header), 1, sim->trace);
+  fwrite(state->regFile, sizeof(int), NUMREGS, sim->trace);
+  fwrite(state->dataMem, sizeof(int), state->dataSize, sim->trace);
+  memset(&sim->traceRecord, 0, sizeof(traceCycleType));
+  return 0;
+}
+
+void traceCycle(simulatorType *sim, stateType *state)
+{
+  traceCycleType *record = &sim->traceRecord;
+
+  record->cycles = state->cycles;
+  record->PC = state->PC;
+  record->IFID = state->IFID;
+  record->IDEX = state->IDEX;
+  record->EXMEM = state->EXMEM;
+  record->MEMWB = state->MEMWB;
+  fwrite(record, sizeof(traceCycleType), 1, sim->trace);
+  fwrite(sim->traceWrites, sizeof(traceWriteType), record->writes, sim->trace);
+  record->events = 0;
+  record->writes = 0;
+}
+
+void traceWrite(simulatorType *sim, int kind, int index, int value)
+{
+  traceWriteType *write = &sim->traceWrites[sim->traceRecord.writes++];
+
+  write->kind = kind;
+  write->index = index;
+  write->value = value;
+}
+
+/******************************************************************/
+/* The simCreate function builds a simulator for the program, or  */
+/* for the checkpoint named in the options, and performs any      */
+/* functional fast-forward the options ask for. Problems with the */
+/* checkpoint or during fast-forward leave the simulator in       */
+/* SIM_ERROR. It returns NULL only if memory runs out.            */
+/******************************************************************/
+simulatorType *simCreate(optionsType *options, programType *program)
+{
+  simulatorType *sim = calloc(1, sizeof(simulatorType));
+
+  if(sim == NULL)
+    return NULL;
+  sim->options = *options;
+  sim->state = &sim->buffers[0];
+  sim->newState = &sim->buffers[1];
+  sim->wide = &sim->wideBuffers[0];
+  sim->newWide = &sim->wideBuffers[1];
+  sim->deep = &sim->deepBuffers[0];
+  sim->newDeep = &sim->deepBuffers[1];
+  sim->status = SIM_RUNNING;
+
+  if(options->width < 1 || options->width > MAXWIDTH ||
+     (options->readPorts && options->readPorts < 2) || options->writePorts < 0 || options->memoryPorts < 0){
+    snprintf(sim->error, ERRORLENGTH, "a pipeline is 1 to %d instructions wide, with at least 2 read ports", MAXWIDTH);
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->outOfOrder && (options->robSize < 1 || options->rsSize < 1 || options->lsqSize < 1)){
+    snprintf(sim->error, ERRORLENGTH, "the reorder buffer, reservation stations and LSQ need at least one entry");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->fetchStages < 1 || options->decodeStages < 1 || options->aluLatency < 1 || options->memoryLatency < 1 ||
+     pipelineDepth(options) > MAXDEPTH){
+    snprintf(sim->error, ERRORLENGTH, "a pipeline has at least one stage of each kind and at most %d stages", MAXDEPTH);
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->resolveStage && (options->resolveStage <= options->fetchStages + options->decodeStages ||
+                               options->resolveStage >= pipelineDepth(options))){
+    snprintf(sim->error, ERRORLENGTH, "branches resolve in an EX or MEM stage, %d to %d",
+             options->fetchStages + options->decodeStages + 1, pipelineDepth(options) - 1);
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->mulLatency < 1 || options->divLatency < 1){
+    snprintf(sim->error, ERRORLENGTH, "the multiply and divide units take at least one cycle");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(deepPipeline(options) && (options->width > 1 || options->outOfOrder)){
+    snprintf(sim->error, ERRORLENGTH, "superscalar pipelines and the out-of-order core have the classic 5 stages");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if((options->width > 1 || options->outOfOrder || deepPipeline(options)) &&
+     (options->checkpointFile != NULL || options->restoreFile != NULL || options->traceFile != NULL)){
+    snprintf(sim->error, ERRORLENGTH, "checkpoints and traces hold only scalar 5-stage pipelines");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->check && options->restoreFile != NULL){
+    snprintf(sim->error, ERRORLENGTH, "the checker starts with the program, not from a checkpoint");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->cores < 1 || options->cores > MAXCORES || options->coreThreads < 1 || options->quantum < 1){
+    snprintf(sim->error, ERRORLENGTH, "a multicore run has 1 to %d cores, host threads and a quantum of at least one cycle",
+             MAXCORES);
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->cores > 1 && (options->width > 1 || options->outOfOrder || deepPipeline(options))){
+    snprintf(sim->error, ERRORLENGTH, "every core of a multicore run is a scalar 5-stage pipeline");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->cores > 1 && (options->functional || options->fastForward >= 0 || options->marker >= 0 || options->check ||
+                            options->checkpointFile != NULL || options->restoreFile != NULL || options->traceFile != NULL)){
+    snprintf(sim->error, ERRORLENGTH, "a multicore run cannot be fast-forwarded, checkpointed, traced or checked");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->cores > 1 && options->dcacheSize && options->writePolicy == WRITETHROUGH){
+    snprintf(sim->error, ERRORLENGTH, "coherent data caches are write-back");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->sampleUnit && (options->sampleUnit < 1 || options->sampleWarmup < 0 ||
+                             options->samplePeriod < options->sampleUnit + options->sampleWarmup)){
+    snprintf(sim->error, ERRORLENGTH, "a sampling period holds its window and the warm-up before it");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->sampleUnit && (options->width > 1 || options->outOfOrder || deepPipeline(options) || options->cores > 1)){
+    snprintf(sim->error, ERRORLENGTH, "only the scalar 5-stage pipeline can be sampled");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->sampleUnit && (options->functional || options->check || options->checkpointFile != NULL ||
+                             options->restoreFile != NULL || options->traceFile != NULL)){
+    snprintf(sim->error, ERRORLENGTH, "a sampled run cannot be functional, checked, checkpointed or traced");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->snapshotInterval && (options->width > 1 || options->outOfOrder || deepPipeline(options) ||
+                                    options->cores > 1)){
+    snprintf(sim->error, ERRORLENGTH, "only the scalar 5-stage pipeline can be debugged");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->snapshotInterval && (options->functional || options->sampleUnit || options->check ||
+                                   options->checkpointFile != NULL || options->restoreFile != NULL ||
+                                   options->traceFile != NULL)){
+    snprintf(sim->error, ERRORLENGTH, "a debugged run cannot be functional, sampled, checked, checkpointed or traced");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->cores > 1){
+    if(multicoreCreate(sim, program) != 0)
+      sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->outOfOrder && coreInit(&sim->core, options) != 0){
+    simDestroy(sim);
+    return NULL;
+  }
+
+  /* Caches start cold, also when resuming, because checkpoints do not hold them */
+  if(cacheInit(&sim->icache, options->icacheSize, options->icacheWays, options->icacheLine, options, sim->error) != 0 ||
+     cacheInit(&sim->dcache, options->dcacheSize, options->dcacheWays, options->dcacheLine, options, sim->error) != 0){
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+  if(options->checkpointFile != NULL && (sim->icache.sets || sim->dcache.sets)){
+    snprintf(sim->error, ERRORLENGTH, "checkpoints do not include cache contents");
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+
+  if(options->restoreFile != NULL){
+    if(readCheckpoint(options->restoreFile, sim->state, &sim->arena, &sim->predictor,
+                      &sim->stalls, sim->counters, sim->error) != 0)
+      sim->status = SIM_ERROR;
+    else if(options->traceFile != NULL && traceOpen(sim, options->traceFile) != 0)
+      sim->status = SIM_ERROR;
+    return sim;
+  }
+  /* Initialize the state of the pipeline */
+  if(initState(sim->state, &sim->arena, program, sim->error) != 0 ||
+     predictorInit(&sim->predictor, options, sim->error) != 0){
+    sim->status = SIM_ERROR;
+    return sim;
+  }
+
+  /* Fast-forward functionally, warming the predictor and caches. The   */
+  /* pipeline then starts empty from the PC, registers and memory left  */
+  /* behind, and counts cache activity from zero. A run that is wholly  */
+  /* functional has no pipeline to warm, so it only executes.           */
+  if(options->functional || options->fastForward >= 0 || options->marker >= 0){
+    if(options->functional)
+      sim->skipped = runFunctional(sim->state, NULL, NULL, NULL, -1, options->marker, sim->error);
+    else
+      sim->skipped = runFunctional(sim->state, &sim->predictor, &sim->icache, &sim->dcache,
+                                   options->fastForward, options->marker, sim->error);
+    if(sim->error[0] != '\0')
+      sim->status = SIM_ERROR;
+    else if(options->functional){
+      sim->functional = 1;
+      sim->status = SIM_HALTED;
+    }
+    else{
+      memset(&sim->icache.stats, 0, sizeof(cacheStatsType));
+      memset(&sim->dcache.stats, 0, sizeof(cacheStatsType));
+    }
+  }
+  /* The reference starts where the pipeline does, after any fast-forward */
+  if(sim->status == SIM_RUNNING && options->check && checkInit(sim) != 0)
+    sim->status = SIM_ERROR;
+  if(sim->status == SIM_RUNNING && options->traceFile != NULL && traceOpen(sim, options->traceFile) != 0)
+    sim->status = SIM_ERROR;
+  if(sim->status == SIM_RUNNING && options->sampleUnit && sampleStart(sim) != 0){
+    simDestroy(sim);
+    return NULL;
+  }
+  if(sim->status != SIM_ERROR && options->snapshotInterval > 0 && debugStart(sim) != 0){
+    simDestroy(sim);
+    return NULL;
+  }
+  return sim;
+}
+
+/******************************************************************/
+/* The simStep function executes up to the given number of cycles */
+/* (-1 for no limit) and returns the status. It stops early when  */
+/* a HALT reaches MEM/WB, a checkpoint is written or an error     */
+/* occurs; once stopped, further calls do nothing.                */
+/******************************************************************/
+int simStep(simulatorType *sim, long long cycles)
+{
+    if (sim->multicore != NULL)
+        return simStepMulti(sim, cycles);
+    if (sim->options.outOfOrder)
+        return simStepCore(sim, cycles);
+    if (sim->options.width > 1)
+        return simStepWide(sim, cycles);
+    if (deepPipeline(&sim->options))
+        return simStepDeep(sim, cycles);
+
+    if (sim->step == NULL)
+        sim->step = scalarVariant(sim);
+    return sim->step(sim, cycles);
+}
+
+/******************************************************************/
+/* The scalar pipeline is written once, as scalarPipeline, and    */
+/* compiled into variants that fix its last three parameters to   */
+/* constants, so each variant's loop keeps only the branches its  */
+/* configuration needs. kind is the PRED_* predictor, whose calls */
+/* then go straight to its functions, or PRED_ANY to call through */
+/* the predictor. caches is 0 if no cache is configured, dropping */
+/* the lookups and miss stalls. plain is 1 for a quiet run that   */
+/* is not traced, checked, checkpointed, sampled, debugged or a   */
+/* core of a multicore run, dropping the code serving those.      */
+/* scalarVariant picks the variant when the simulator first       */
+/* steps; the generic one, with every parameter left open, runs   */
+/* everything else.                                               */
+/******************************************************************/
+#ifdef __GNUC__
+#define SPECIALIZE static inline __attribute__((always_inline))
+#else
+#define SPECIALIZE static inline
+#endif
+#define PRED_ANY -1        /* The predictor kind is read at run time */
+#define PRED_NONE -2       /* No predictor is trained */
 
-int main(){
-    run();
-    return(0);
+SPECIALIZE int hasTargetAs(predictorType *pred, int kind)
+{
+    return kind == PRED_ANY ? pred->hasTarget : kind == PRED_BTB;
+}
+
+SPECIALIZE int predictAs(predictorType *pred, int kind, int pc, int *target)
+{
+    switch(kind){
+    case PRED_GLOBAL:
+        return globalPredict(pred, pc, target);
+    case PRED_LOCAL:
+        return localPredict(pred, pc, target);
+    case PRED_BTB:
+        return btbPredict(pred, pc, target);
+    case PRED_GSHARE:
+        return gsharePredict(pred, pc, target);
+    case PRED_TOURNAMENT:
+        return tournamentPredict(pred, pc, target);
+    }
+    return pred->predict(pred, pc, target);
+}
+
+/* The update function of a predictor of the given kind */
+SPECIALIZE void updateAs(predictorType *pred, int kind, int pc, int target, int taken)
+{
+    switch(kind){
+    case PRED_GLOBAL:
+        globalUpdate(pred, pc, target, taken);
+        break;
+    case PRED_LOCAL:
+        localUpdate(pred, pc, target, taken);
+        break;
+    case PRED_BTB:
+        btbUpdate(pred, pc, target, taken);
+        break;
+    case PRED_GSHARE:
+        gshareUpdate(pred, pc, target, taken);
+        break;
+    case PRED_TOURNAMENT:
+        tournamentUpdate(pred, pc, target, taken);
+        break;
+    case PRED_NONE:
+        break;
+    default:
+        pred->update(pred, pc, target, taken);
+    }
+}
+
+/* predictorResolve for a predictor of the given kind */
+SPECIALIZE void resolveAs(predictorType *pred, int kind, int pc, int target, int taken, int predicted)
+{
+    pred->branches++;
+    if(taken != predicted)
+        pred->mispredictions++;
+    updateAs(pred, kind, pc, target, taken);
 }
 
-void run(){
+SPECIALIZE int scalarPipeline(simulatorType *sim, long long cycles, int kind, int caches, int plain)
+{
+  stateType *state = sim->state;
+  stateType *newState = sim->newState;
+  stateType *swap;
+  int taken;                 /* Outcome of the branch resolved in EX */
+  int target;                /* Predicted branch target */
+  int operand1, operand2;    /* Forwarded source operands of the instruction in EX */
+  int squashed;              /* 1 if ID squashed the fetch behind a predicted-taken branch or jump */
+  int flush;                 /* 1 if EX flushed IF/ID and ID/EX */
+  int hold;                  /* 1 if a multiply or divide stays in EX for another cycle */
+  int word;                  /* dataMem index of a store */
+  int uop;                   /* decodedMem index of the fetched instruction */
+  unsigned char producer[NOREG + 1];  /* STAGE_* holding the newest value of each register */
+  int forward[STAGE_WB + 1];          /* Value each pipeline register can forward */
+  decodedType *ifid, *idex, *exmem, *memwb;
+
+    for ( ; cycles != 0 && sim->status == SIM_RUNNING; cycles--) {
+
+        /* Pre-decoded view of the instruction in each pipeline register */
+        ifid = &state->decodedMem[state->IFID.uop];
+        idex = &state->decodedMem[state->IDEX.uop];
+        exmem = &state->decodedMem[state->EXMEM.uop];
+        memwb = &state->decodedMem[state->MEMWB.uop];
+
+        if (!plain && sim->debug != NULL && state->cycles >= sim->debug->next && debugSnapshot(sim, state) != 0) {
+            sim->status = SIM_ERROR;
+            break;
+        }
+
+        if (memwb->opcode == HALT)
+            sim->events |= EVENT_HALT;
 
-  stateType state;           /* Contains the state of the entire pipeline before the cycle executes */
-  stateType newState;        /* Contains the state of the entire pipeline after the cycle executes */
-  initState(&state);         /* Initialize the state of the pipeline */
-  int stalled = 0; //bool check
-  int stalls = 0; //num of stalls
-  int mispredictions = 0;
-  int branches = 0;
-  unsigned bpb = WEAKLYTAKEN;
-    while (1) {
+        if (!plain && sim->options.checkpointFile != NULL && state->cycles == sim->options.checkpointCycle) {
+            if (writeCheckpoint(sim->options.checkpointFile, state, &sim->predictor, sim->stalls, sim->counters, sim->error) == 0)
+                sim->status = SIM_CHECKPOINTED;
+            else
+                sim->status = SIM_ERROR;
+            break;
+        }
 
-        printState(&state);
+        /* Only the verbose mode formats output on every cycle */
+        if (!plain && (sim->options.outputMode == VERBOSE ||
+                       (sim->options.outputMode == INTERVAL && state->cycles % sim->options.dumpInterval == 0) ||
+                       (sim->options.outputMode == EVENTS && (sim->events & sim->options.dumpEvents))))
+            printState(state);
+        sim->events = 0;
 
 
 	/* If a halt instruction is entering its WB stage, then all of the legitimate */
-	/* instruction have completed. Print the statistics and exit the program. */
-        if (get_opcode(state.MEMWB.instr) == HALT) {
-            printf("Total number of cycles executed: %d\n", state.cycles);
-            printf("Total number of stalls: %d\n", stalls);
-            printf("Total number of branches %d\n", branches);
-            printf("Total number of mispredicted branches: %d\n", mispredictions);
-            /* Remember to print the number of stalls, branches, and mispredictions! */
-            exit(0);
-        }
-
-        newState = state;     /* Start by making newState a copy of the state before the cycle */
-        newState.cycles++;
+	/* instruction have completed. */
+        if (memwb->opcode == HALT) {
+            sim->status = SIM_HALTED;
+            if (!plain && sim->checker != NULL && checkHalt(sim, state, state->cycles + 1) != 0)
+                sim->status = SIM_ERROR;
+            if (!plain && sim->trace != NULL) {
+                sim->traceRecord.events |= TRACE_HALT;
+                traceCycle(sim, state);
+            }
+            break;
+        }
+
+        /* Fetch has stopped outside instruction memory with nothing in flight */
+        if (state->MEMWB.uop == 0 && state->EXMEM.uop == 0 && state->IDEX.uop == 0 &&
+            state->IFID.uop == 0 && fetchFault(state, sim->error)) {
+            sim->status = SIM_ERROR;
+            break;
+        }
+
+        /* A cache miss freezes the whole pipeline until the line arrives */
+        if (caches && sim->memoryStall > 0) {
+            sim->memoryStall--;
+            sim->counters[CTR_MEMORY]++;
+            sim->events |= EVENT_STALL;
+            if (!plain && sim->trace != NULL) {
+                sim->traceRecord.events |= TRACE_MEMORY;
+                traceCycle(sim, state);
+            }
+            state->cycles++;
+            continue;
+        }
+
+        *newState = *state;   /* Start by making newState a copy of the state before the cycle. */
+                              /* Only the PC, the latches and pointers are copied; WB and MEM   */
+                              /* write the register file and data memory in place.             */
+        newState->cycles++;
 	/* Modify newState stage-by-stage below to reflect the state of the pipeline after the cycle has executed */
 
+        /* -------------- Hazard detection and forwarding -------------- */
+        /* The scoreboard maps each register to the pipeline register     */
+        /* that holds its newest in-flight value. It is filled oldest     */
+        /* first, so younger writes win, and NOREG never has a producer.  */
+        /* EX and ID then find every operand with a single lookup.        */
+        memset(producer, STAGE_NONE, sizeof(producer));
+        producer[memwb->dest] = STAGE_WB;
+        producer[exmem->dest] = STAGE_MEM;
+        producer[NOREG] = STAGE_NONE;
+        forward[STAGE_MEM] = state->EXMEM.aluResult;
+        forward[STAGE_WB] = (memwb->flags & OP_LOAD) ? state->MEMWB.writeDataMem : state->MEMWB.writeDataALU;
+
+        /* A multiply or divide takes its operands in its first EX cycle and */
+        /* holds EX, and everything behind it, until its unit is done        */
+        hold = state->IDEX.busy + 1 < unitLatency(&sim->options, idex);
+        operand1 = state->IDEX.readData1;
+        operand2 = state->IDEX.readData2;
+        if(producer[idex->src1] && !state->IDEX.busy){
+          operand1 = forward[producer[idex->src1]];
+          sim->counters[CTR_FWDEXMEM - STAGE_MEM + producer[idex->src1]]++;
+        }
+        if(producer[idex->src2] && !state->IDEX.busy){
+          operand2 = forward[producer[idex->src2]];
+          sim->counters[CTR_FWDEXMEM - STAGE_MEM + producer[idex->src2]]++;
+        }
+
+        /* The instruction entering EX is the newest producer seen by ID */
+        producer[idex->dest] = STAGE_EX;
+        producer[NOREG] = STAGE_NONE;
+
         /* --------------------- IF stage --------------------- */
+        squashed = 0;
+
+        /* A draining pipeline, or one whose PC is outside instruction */
+        /* memory, fetches nothing and keeps the PC, which branches    */
+        /* resolving meanwhile still redirect                          */
+        uop = fetchUop(state, state->PC + 4);
+        if((!plain && sim->draining) || uop == 0){
+          memset(&newState->IFID, 0, sizeof(IFIDType));
+        }
+        else{
+          newState->PC = state->PC + 4;
+          newState->IFID.PCPlus4 = state->PC + 4;
 
-        newState.PC = state.PC + 4;
-        newState.IFID.PCPlus4 = state.PC + 4;
+          newState->IFID.uop = uop;
+          newState->IFID.instr = state->instrMem[uop - 1];
+          newState->IFID.bpb = 0;
+          if(caches)
+            sim->memoryStall += cacheAccess(&sim->icache, state->PC, 0);
 
-        newState.IFID.instr = state.instrMem[(newState.PC/4) - 1];
+          /* A branch target buffer predicts and redirects at fetch, before decode */
+          if(hasTargetAs(&sim->predictor, kind) && predictAs(&sim->predictor, kind, state->PC, &target)){
+            newState->IFID.bpb = 1;
+            newState->PC = target;
+          }
+        }
 
         /* --------------------- ID stage --------------------- */
-        if(newState.cycles > 1){
+        if(newState->cycles > 1){
+          newState->IDEX.busy = 0;
+
+          if(hold){
+            sim->stalls++;
+            sim->counters[CTR_UNITBUSY]++;
+            if(!plain)
+              sim->traceRecord.events |= TRACE_UNITBUSY;
+            sim->events |= EVENT_STALL;
+            newState->PC = state->PC;
+            newState->IFID = state->IFID;
+            newState->IDEX.busy = state->IDEX.busy + 1;
+            newState->IDEX.readData1 = operand1;  /* what the unit took */
+            newState->IDEX.readData2 = operand2;
+          }
+          /*---stall if the instruction reads a register that the load
+          in ID/EX has not fetched from memory yet*/
+          else if((producer[ifid->src1] == STAGE_EX || producer[ifid->src2] == STAGE_EX) && (idex->flags & OP_LOAD)){
+            sim->stalls++;
+            sim->counters[CTR_LOADUSE]++;
+            if(!plain)
+              sim->traceRecord.events |= TRACE_LOADUSE;
+            sim->events |= EVENT_STALL;
+            newState->IDEX.instr = 0; //NOOP instr
+            newState->IDEX.uop = 0;
+            newState->PC = state->PC;
+            newState->IFID = state->IFID;  /* hold the stalled instruction in IF/ID */
+            newState->IDEX.PCPlus4 = 0;
+            newState->IDEX.immed = 0;
+            newState->IDEX.branchTarget = 0;
+            newState->IDEX.rsReg = 0;
+            newState->IDEX.rtReg = 0;
+            newState->IDEX.rdReg = 0;
+            newState->IDEX.readData1 = 0;
+            newState->IDEX.readData2 = 0;
+            newState->IDEX.bpb = 0;
+          }
+          else if(state->IFID.instr == 0){
+            newState->IDEX.instr = 0;
+            newState->IDEX.uop = 0;
+            newState->IDEX.PCPlus4 = 0;
+            newState->IDEX.immed = 0;
+            newState->IDEX.branchTarget = 0;
+            newState->IDEX.rsReg = 0;
+            newState->IDEX.rtReg = 0;
+            newState->IDEX.rdReg = 0;
+            newState->IDEX.readData1 = 0;
+            newState->IDEX.readData2 = 0;
+            newState->IDEX.bpb = 0;
+          }
+          else{
+            newState->IDEX.instr = state->IFID.instr;
+            newState->IDEX.uop = state->IFID.uop;
+            newState->IDEX.PCPlus4 = state->IFID.PCPlus4;
+            newState->IDEX.immed = ifid->immed;
+            newState->IDEX.branchTarget = ifid->immed; //branch target is in the immed field
+            newState->IDEX.rsReg = ifid->rs;
+            newState->IDEX.rtReg = ifid->rt;
+            newState->IDEX.rdReg = ifid->rd;
+            newState->IDEX.bpb = state->IFID.bpb;
+
+            /* WB writes the register file in the first half of the cycle */
+            sim->counters[CTR_FWDWB] += (producer[ifid->src1] == STAGE_WB) + (producer[ifid->src2] == STAGE_WB);
+            newState->IDEX.readData1 = producer[ifid->src1] == STAGE_WB ? forward[STAGE_WB] : state->regFile[ifid->rs];
+            newState->IDEX.readData2 = producer[ifid->src2] == STAGE_WB ? forward[STAGE_WB] : state->regFile[ifid->rt];
+            if(ifid->flags & OP_HALT){
+              newState->IDEX.readData1 = 0;
+              newState->IDEX.readData2 = 0;
+            }
+
+            /* A predictor with a target buffer already redirected the fetch in IF. */
+            /* Otherwise predict here, where the target is known, and squash the    */
+            /* sequential instruction fetched behind a predicted-taken branch, or   */
+            /* behind a jump, which always redirects here.                          */
+            if((ifid->flags & OP_BRANCH) && !hasTargetAs(&sim->predictor, kind))
+              newState->IDEX.bpb = predictAs(&sim->predictor, kind, state->IFID.PCPlus4 - 4, &target);
+            if(((ifid->flags & OP_BRANCH) && !hasTargetAs(&sim->predictor, kind) && newState->IDEX.bpb) ||
+               (ifid->flags & OP_JUMP)){
+              sim->stalls++;
+              sim->counters[CTR_TAKENBUBBLES]++;
+              if(!plain)
+                sim->traceRecord.events |= TRACE_SQUASH;
+              squashed = 1;
+              sim->events |= EVENT_STALL;
+              newState->PC = newState->IDEX.immed;
+              newState->IFID.instr = 0;
+              newState->IFID.uop = 0;
+              newState->IFID.PCPlus4 = 0;
+              newState->IFID.bpb = 0;
+            }
+          }
+        }
 
-          newState.IDEX.instr = state.IFID.instr;
-          newState.IDEX.PCPlus4 = state.IFID.PCPlus4;
-          newState.IDEX.immed = get_immed(state.IFID.instr);
-          newState.IDEX.branchTarget = get_immed(state.IFID.instr); //branch target is in the immed field
-          newState.IDEX.rsReg = get_rs(state.IFID.instr);
-          newState.IDEX.rtReg = get_rt(state.IFID.instr);
-          newState.IDEX.rdReg = get_rd(state.IFID.instr);
-          newState.IDEX.bpb = state.IFID.bpb;
 
-          if(get_opcode(state.IFID.instr) == LW){
-            newState.IDEX.readData1 = get_rs(newState.IDEX.rsReg);  // get content of rs reg
-            newState.IDEX.readData2 = get_rt(newState.IDEX.rtReg );  // get content of rt reg
+        /* --------------------- EX stage --------------------- */
+        if(newState->cycles > 2 && hold)
+          memset(&newState->EXMEM, 0, sizeof(EXMEMType));  /* a bubble leaves EX */
+        else if(newState->cycles > 2){
+          newState->EXMEM.instr = state->IDEX.instr;
+          newState->EXMEM.uop = state->IDEX.uop;
+          newState->EXMEM.bpb = state->IDEX.bpb;
+          newState->EXMEM.writeDataReg = operand2;  /* the store data, forwarded like any operand */
+          newState->EXMEM.writeReg = idex->dest != NOREG ? idex->dest :
+                                     idex->opcode == R ? state->IDEX.rdReg : state->IDEX.rtReg;
+          newState->EXMEM.aluResult = aluCompute(idex, operand1, operand2, state->IDEX.PCPlus4);
+          if(idex->alu == ALU_NONE){
+            newState->EXMEM.writeReg = 0;
+            newState->EXMEM.writeDataReg = 0;
+          }
+
+          flush = 0;
+          if(idex->flags & OP_BRANCH){
+            /* Resolve the branch, train the predictor and squash the */
+            /* two younger instructions if the prediction was wrong   */
+            taken = newState->EXMEM.aluResult != 0;
+            resolveAs(&sim->predictor, kind, state->IDEX.PCPlus4 - 4, state->IDEX.immed, taken, state->IDEX.bpb);
+            sim->counters[CTR_BRANCHES]++;
+            sim->counters[CTR_TAKEN] += taken;
+            if(taken != state->IDEX.bpb){
+              flush = 1;
+              sim->counters[CTR_MISPREDICTED]++;
+              sim->counters[CTR_MISSEDTAKEN] += taken;
+              sim->events |= EVENT_MISPREDICT;
+              newState->PC = taken ? state->IDEX.immed : state->IDEX.PCPlus4;
+            }
           }
-          else if(get_opcode(state.IFID.instr) == SW){
+          /* An indirect jump learns its target here, too late for the */
+          /* two instructions fetched behind it                       */
+          else if(idex->flags & OP_INDIRECT){
+            flush = 1;
+            newState->PC = newState->EXMEM.aluResult;
+          }
+          if(flush){
+            /* The flush covers any fetch ID already squashed this cycle */
+            sim->stalls += 2 - squashed;
+            sim->counters[CTR_TAKENBUBBLES] -= squashed;
+            sim->counters[CTR_FLUSHBUBBLES] += 2;
+            if(!plain)
+              sim->traceRecord.events |= TRACE_FLUSH;
+            sim->events |= EVENT_STALL;
+            newState->IFID.instr = 0;
+            newState->IFID.uop = 0;
+            newState->IFID.PCPlus4 = 0;
+            newState->IFID.bpb = 0;
+            newState->IDEX.instr = 0; //NOOP instr
+            newState->IDEX.uop = 0;
+            newState->IDEX.PCPlus4 = 0;
+            newState->IDEX.immed = 0;
+            newState->IDEX.branchTarget = 0;
+            newState->IDEX.rsReg = 0;
+            newState->IDEX.rtReg = 0;
+            newState->IDEX.rdReg = 0;
+            newState->IDEX.readData1 = 0;
+            newState->IDEX.readData2 = 0;
+            newState->IDEX.bpb = 0;
+          }
+        }
+
+        /* --------------------- MEM stage --------------------- */
+        if(newState->cycles > 3){
+
+          newState->MEMWB.instr = state->EXMEM.instr;
+          newState->MEMWB.uop = state->EXMEM.uop;
+          newState->MEMWB.writeDataALU = state->EXMEM.aluResult;
+          newState->MEMWB.writeReg = state->EXMEM.writeReg;
 
-            if((get_rt(state.IFID.instr) == get_rd(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == R){
-              newState.IDEX.readData2 = state.MEMWB.writeDataALU;
-              newState.IDEX.readData1 = state.regFile[get_rs(state.IFID.instr)];  // get content of rt reg
+          if(exmem->flags & OP_LOAD){
+            word = dataIndex(state, state->EXMEM.aluResult, sim->error);
+            if (!plain && sim->bus != NULL)
+              sim->memoryStall += busAccess(sim, state->EXMEM.aluResult, word, 0, &newState->MEMWB.writeDataMem);
+            else{
+              newState->MEMWB.writeDataMem = state->dataMem[word];
+              if (caches)
+                sim->memoryStall += cacheAccess(&sim->dcache, state->EXMEM.aluResult, 0);
             }
+          }
+          else if(exmem->flags & OP_STORE){
+            word = dataIndex(state, state->EXMEM.aluResult, sim->error);
+            if (!plain && sim->debug != NULL)
+              debugWrite(sim, state, TRACE_MEM, word, state->EXMEM.writeDataReg);
+            if (!plain && sim->bus != NULL)
+              sim->memoryStall += busAccess(sim, state->EXMEM.aluResult, word, 1, &state->EXMEM.writeDataReg);
             else{
-              newState.IDEX.readData1 = state.regFile[get_rs(state.IFID.instr)];
-              newState.IDEX.readData2 = state.regFile[get_rt(state.IFID.instr)];
+              newState->dataMem[word] = state->EXMEM.writeDataReg;
+              if (caches)
+                sim->memoryStall += cacheAccess(&sim->dcache, state->EXMEM.aluResult, 1);
             }
+            if (!plain && sim->checker != NULL)
+              checkStore(sim, state->EXMEM.aluResult, state->EXMEM.writeDataReg);
+            if (!plain && sim->trace != NULL)
+              traceWrite(sim, TRACE_MEM, word, state->EXMEM.writeDataReg);
           }
-          else if(newState.IDEX.instr == 0){
-            newState.IDEX.PCPlus4 = 0;
-            newState.IDEX.immed = 0;
-            newState.IDEX.branchTarget = 0;
-            newState.IDEX.rsReg = 0;
-            newState.IDEX.rtReg = 0;
-            newState.IDEX.rdReg = 0;
-            newState.IDEX.readData1 = 0;
-            newState.IDEX.readData2 = 0;
+          else if(exmem->dest == NOREG){
+            newState->MEMWB.writeDataALU = 0;
+            newState->MEMWB.writeReg = 0;
           }
-          else if(get_opcode(state.IFID.instr) == R){
-            newState.IDEX.readData1 = state.regFile[newState.IDEX.rsReg];
-            newState.IDEX.readData2 = state.regFile[newState.IDEX.rtReg];
 
-            if(get_rt(state.IFID.instr) == (get_rs(state.IFID.instr))){
-              newState.IDEX.readData1 = state.MEMWB.writeDataMem;
-              newState.IDEX.readData2 = state.MEMWB.writeDataMem;
-            }
-              else if((get_rs(state.IFID.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
-                newState.IDEX.readData1 = state.MEMWB.writeDataMem;
-                newState.IDEX.readData2 = state.regFile[newState.IDEX.rtReg];  // get content of rt reg
+        }
+
+        /* --------------------- WB stage --------------------- */
+        if(newState->cycles > 4 && memwb->op){
+          if(memwb->dest != NOREG){
+            if (!plain && sim->debug != NULL)
+              debugWrite(sim, state, TRACE_REG, memwb->dest, forward[STAGE_WB]);
+            newState->regFile[memwb->dest] = forward[STAGE_WB];
+            if (!plain && sim->trace != NULL)
+              traceWrite(sim, TRACE_REG, memwb->dest, forward[STAGE_WB]);
+          }
+          sim->counters[CTR_RETIRED]++;
+          sim->counters[CTR_OPCODE + memwb->op - 1]++;
+          if (!plain && sim->checker != NULL)
+            checkRetire(sim, newState, newState->cycles, state->MEMWB.uop, forward[STAGE_WB]);
+        }
 
-              }
-              else if((get_rt(state.IFID.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
-                newState.IDEX.readData2 = state.MEMWB.writeDataMem;
-                newState.IDEX.readData1 = state.regFile[newState.IDEX.rsReg];
 
-              }
-              //if RS & RT the same REG
+        if (!plain && sim->trace != NULL)
+            traceCycle(sim, state);
 
-              if(get_rt(state.IFID.instr) == (get_rs(state.IFID.instr))){
-                if((get_rt(state.IFID.instr) == get_rd(newState.MEMWB.instr)) && get_opcode(newState.MEMWB.instr) == R){
-                  newState.IDEX.readData2 = newState.MEMWB.writeDataALU;
-                  newState.IDEX.readData1 = newState.MEMWB.writeDataALU;  // get content of rt reg
+        swap = state;        /* The newState now becomes the old state before we execute the next cycle */
+        state = newState;
+        newState = swap;
 
-                }
-              }
-              else if((newState.IDEX.rtReg == get_rd(newState.MEMWB.instr)) && get_opcode(newState.MEMWB.instr) == R){
-                newState.IDEX.readData2 = newState.MEMWB.writeDataALU;
-                newState.IDEX.readData1 = state.regFile[newState.IDEX.rsReg];  // get content of rt reg
+        /* A bad data address stops the simulation after the cycle */
+        if (sim->error[0] != '\0') {
+            sim->status = SIM_ERROR;
+            break;
+        }
+
+        /* A sampled run changes phase between cycles */
+        if (!plain && sim->sampler != NULL && (sim->counters[CTR_RETIRED] >= sim->sampler->next || sim->draining))
+            sampleAdvance(sim, state);
+
+    }
+
+  sim->state = state;
+  sim->newState = newState;
+  if (!plain && sim->trace != NULL && sim->status != SIM_RUNNING && (fflush(sim->trace) != 0 || ferror(sim->trace))) {
+    snprintf(sim->error, ERRORLENGTH, "cannot write trace %s", sim->options.traceFile);
+    sim->status = SIM_ERROR;
+  }
+  return sim->status;
+}
+
+#define SCALARVARIANT(name, kind, caches, plain) \
+static int name(simulatorType *sim, long long cycles) \
+{ \
+    return scalarPipeline(sim, cycles, kind, caches, plain); \
+}
+
+SCALARVARIANT(scalarGeneric, PRED_ANY, 1, 0)
+SCALARVARIANT(scalarGlobal, PRED_GLOBAL, 0, 1)
+SCALARVARIANT(scalarGlobalCached, PRED_GLOBAL, 1, 1)
+SCALARVARIANT(scalarLocal, PRED_LOCAL, 0, 1)
+SCALARVARIANT(scalarLocalCached, PRED_LOCAL, 1, 1)
+SCALARVARIANT(scalarBtb, PRED_BTB, 0, 1)
+SCALARVARIANT(scalarBtbCached, PRED_BTB, 1, 1)
+SCALARVARIANT(scalarGshare, PRED_GSHARE, 0, 1)
+SCALARVARIANT(scalarGshareCached, PRED_GSHARE, 1, 1)
+SCALARVARIANT(scalarTournament, PRED_TOURNAMENT, 0, 1)
+SCALARVARIANT(scalarTournamentCached, PRED_TOURNAMENT, 1, 1)
+
+/* Plain variants by PRED_* kind, without and with caches */
+static const stepType scalarVariants[][2] = {
+  {scalarGlobal, scalarGlobalCached},
+  {scalarLocal, scalarLocalCached},
+  {scalarBtb, scalarBtbCached},
+  {scalarGshare, scalarGshareCached},
+  {scalarTournament, scalarTournamentCached}
+};
+
+stepType scalarVariant(simulatorType *sim)
+{
+    if(sim->options.outputMode != QUIET || sim->options.checkpointFile != NULL || sim->checker != NULL ||
+       sim->trace != NULL || sim->sampler != NULL || sim->bus != NULL || sim->debug != NULL)
+        return scalarGeneric;
+    return scalarVariants[sim->predictor.kind][sim->icache.sets || sim->dcache.sets];
+}
+
+/******************************************************************/
+/* The simStepWide function is simStep for a superscalar pipeline */
+/* of width instructions per stage, all moving in order. Bundles  */
+/* hold their instructions oldest first. ID issues from the front */
+/* of IF/ID until an instruction must wait: for a load in EX, for */
+/* an older instruction of its own bundle (EX cannot forward      */
+/* within a bundle), for register file or memory ports, or, for a */
+/* HALT, until it can issue alone. What is left moves to the      */
+/* front of IF/ID and fetch fills the rest. Lost issue slots are  */
+/* counted by the hazard that ended the bundle.                   */
+/******************************************************************/
+int simStepWide(simulatorType *sim, long long cycles)
+{
+  stateType *state = sim->state;
+  wideType *wide = sim->wide;
+  wideType *newWide = sim->newWide;
+  wideType *swap;
+  int width = sim->options.width;
+  int readPorts = sim->options.readPorts ? sim->options.readPorts : 2 * width;
+  int writePorts = sim->options.writePorts ? sim->options.writePorts : width;
+  int memoryPorts = sim->options.memoryPorts ? sim->options.memoryPorts : width;
+  int taken, target, operand1, operand2;
+  int flushed;               /* 1 if EX flushed IF/ID and ID/EX after a misprediction or jr */
+  int squashed;              /* 1 if ID squashed the rest of IF/ID behind a predicted-taken branch or jump */
+  int hold;                  /* 1 if ID/EX stays in EX for another cycle */
+  int lost;                  /* CTR_* charged with the issue slots ID left unused */
+  int reads, writes, memory, written, i, k;
+  unsigned char producer[NOREG + 1];  /* STAGE_* holding the newest value of each register */
+  unsigned char loading[NOREG + 1];   /* 1 if that value is a load still in ID/EX */
+  int value[NOREG + 1];               /* The newest forwardable value of each register */
+  int writeback[NOREG + 1];           /* The value being written back, if producer is STAGE_WB */
+  decodedType *d;
+  IFIDType *ifid;
+  IDEXType *idex;
+
+    for ( ; cycles != 0 && sim->status == SIM_RUNNING; cycles--) {
+
+        /* A HALT issues alone, so it is the only instruction of its bundle */
+        if (state->decodedMem[wide->MEMWB[0].uop].opcode == HALT)
+            sim->events |= EVENT_HALT;
+
+        if (sim->options.outputMode == VERBOSE ||
+            (sim->options.outputMode == INTERVAL && state->cycles % sim->options.dumpInterval == 0) ||
+            (sim->options.outputMode == EVENTS && (sim->events & sim->options.dumpEvents)))
+            printWideState(state, wide, width);
+        sim->events = 0;
+
+        if (state->decodedMem[wide->MEMWB[0].uop].opcode == HALT) {
+            sim->status = SIM_HALTED;
+            if (sim->checker != NULL && checkHalt(sim, state, state->cycles + 1) != 0)
+                sim->status = SIM_ERROR;
+            break;
+        }
+
+        if (wide->memwbCount == 0 && wide->exmemCount == 0 && wide->idexCount == 0 &&
+            wide->ifidCount == 0 && fetchFault(state, sim->error)) {
+            sim->status = SIM_ERROR;
+            break;
+        }
+
+        if (sim->memoryStall > 0) {
+            sim->memoryStall--;
+            sim->counters[CTR_MEMORY]++;
+            sim->events |= EVENT_STALL;
+            state->cycles++;
+            continue;
+        }
+
+        memset(newWide, 0, sizeof(wideType));
+        state->cycles++;
+
+        /* The scoreboard of simStep, with one value per register because */
+        /* several instructions of a bundle may forward at once           */
+        memset(producer, STAGE_NONE, sizeof(producer));
+        memset(loading, 0, sizeof(loading));
+        for(i = 0; i < wide->memwbCount; i++){
+          d = &state->decodedMem[wide->MEMWB[i].uop];
+          producer[d->dest] = STAGE_WB;
+          value[d->dest] = (d->flags & OP_LOAD) ? wide->MEMWB[i].writeDataMem : wide->MEMWB[i].writeDataALU;
+          writeback[d->dest] = value[d->dest];
+        }
+        for(i = 0; i < wide->exmemCount; i++){
+          d = &state->decodedMem[wide->EXMEM[i].uop];
+          producer[d->dest] = STAGE_MEM;
+          value[d->dest] = wide->EXMEM[i].aluResult;
+        }
+        producer[NOREG] = STAGE_NONE;
 
-              }
-              else if((newState.IDEX.rsReg == get_rd(newState.MEMWB.instr)) && get_opcode(newState.MEMWB.instr) == R){
-                newState.IDEX.readData1 = newState.MEMWB.writeDataALU;
-                newState.IDEX.readData2 = state.regFile[newState.IDEX.rtReg];  // get content of rt reg
+        /* --------------------- EX stage --------------------- */
+        /* A bundle holding a multiply or divide stays in EX until the */
+        /* slowest of them is done, keeping the operands they took in  */
+        /* their first cycle, and nothing issues behind it meanwhile   */
+        hold = 0;
+        for(i = 0; i < wide->idexCount; i++)
+          hold |= wide->IDEX[i].busy + 1 < unitLatency(&sim->options, &state->decodedMem[wide->IDEX[i].uop]);
+        flushed = 0;
+        for(i = 0; i < wide->idexCount && !flushed; i++){
+          idex = &wide->IDEX[i];
+          d = &state->decodedMem[idex->uop];
+          operand1 = idex->readData1;
+          operand2 = idex->readData2;
+          if(producer[d->src1] && !idex->busy){
+            operand1 = value[d->src1];
+            sim->counters[CTR_FWDEXMEM - STAGE_MEM + producer[d->src1]]++;
+          }
+          if(producer[d->src2] && !idex->busy){
+            operand2 = value[d->src2];
+            sim->counters[CTR_FWDEXMEM - STAGE_MEM + producer[d->src2]]++;
+          }
+          if(hold){
+            newWide->IDEX[newWide->idexCount] = *idex;
+            newWide->IDEX[newWide->idexCount].readData1 = operand1;
+            newWide->IDEX[newWide->idexCount].readData2 = operand2;
+            newWide->IDEX[newWide->idexCount++].busy++;
+            continue;
+          }
 
-              }
+          k = newWide->exmemCount++;
+          newWide->EXMEM[k].instr = idex->instr;
+          newWide->EXMEM[k].uop = idex->uop;
+          newWide->EXMEM[k].bpb = idex->bpb;
+          if(d->alu != ALU_NONE){
+            newWide->EXMEM[k].writeDataReg = operand2;
+            newWide->EXMEM[k].writeReg = d->dest != NOREG ? d->dest : d->opcode == R ? idex->rdReg : idex->rtReg;
+            newWide->EXMEM[k].aluResult = aluCompute(d, operand1, operand2, idex->PCPlus4);
+          }
 
+          if(d->flags & OP_BRANCH){
+            taken = newWide->EXMEM[k].aluResult != 0;
+            predictorResolve(&sim->predictor, idex->PCPlus4 - 4, idex->immed, taken, idex->bpb);
+            sim->counters[CTR_BRANCHES]++;
+            sim->counters[CTR_TAKEN] += taken;
+            if(taken != idex->bpb){
+              flushed = 1;
+              sim->counters[CTR_MISPREDICTED]++;
+              sim->counters[CTR_MISSEDTAKEN] += taken;
+              sim->events |= EVENT_MISPREDICT;
+              state->PC = taken ? idex->immed : idex->PCPlus4;
+            }
+          }
+          else if(d->flags & OP_INDIRECT){
+            flushed = 1;
+            state->PC = newWide->EXMEM[k].aluResult;
           }
-          else if(get_opcode(state.IFID.instr) == BNE){
-            if((get_rs(state.IFID.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
-              newState.IDEX.readData1 = state.MEMWB.writeDataMem;
-              newState.IDEX.readData2 = state.regFile[newState.IDEX.rtReg];  // get content of rt reg
+          if(flushed){
+            /* Two cycles of fetch are lost, and so are the younger */
+            /* instructions of the bundle                           */
+            sim->stalls += 2 * width + wide->idexCount - i - 1;
+            sim->counters[CTR_FLUSHBUBBLES] += 2 * width + wide->idexCount - i - 1;
+            sim->events |= EVENT_STALL;
+          }
+        }
+
+        /* Instructions entering EX are the newest producers seen by ID */
+        for(i = 0; i < newWide->exmemCount; i++){
+          d = &state->decodedMem[newWide->EXMEM[i].uop];
+          producer[d->dest] = STAGE_EX;
+          loading[d->dest] = (d->flags & OP_LOAD) != 0;
+        }
+        producer[NOREG] = STAGE_NONE;
+        loading[NOREG] = 0;
+
+        /* --------------------- ID stage --------------------- */
+        squashed = 0;
+        k = 0;
+        if(hold){
+          sim->stalls += width;
+          sim->counters[CTR_UNITBUSY] += width;
+          sim->events |= EVENT_STALL;
+          for(i = 0; i < wide->ifidCount; i++)
+            newWide->IFID[k++] = wide->IFID[i];
+        }
+        else if(!flushed){
+          lost = -1;
+          reads = writes = memory = written = 0;
+          for(i = 0; i < wide->ifidCount; i++){
+            ifid = &wide->IFID[i];
+            d = &state->decodedMem[ifid->uop];
+            if(loading[d->src1] || loading[d->src2]){
+              lost = CTR_LOADUSE;
+              break;
+            }
+            if(((written >> d->src1) & 1) || ((written >> d->src2) & 1)){
+              lost = CTR_DEPENDENCY;
+              break;
+            }
+            if(reads + (d->src1 != NOREG) + (d->src2 != NOREG) > readPorts ||
+               writes + (d->dest != NOREG) > writePorts ||
+               memory + ((d->flags & (OP_LOAD | OP_STORE)) != 0) > memoryPorts ||
+               ((d->flags & OP_HALT) && i > 0)){
+              lost = CTR_STRUCTURAL;
+              break;
+            }
+            reads += (d->src1 != NOREG) + (d->src2 != NOREG);
+            writes += d->dest != NOREG;
+            memory += (d->flags & (OP_LOAD | OP_STORE)) != 0;
+            if(d->dest != NOREG)
+              written |= 1 << d->dest;
 
+            idex = &newWide->IDEX[newWide->idexCount++];
+            idex->instr = ifid->instr;
+            idex->uop = ifid->uop;
+            idex->PCPlus4 = ifid->PCPlus4;
+            idex->immed = d->immed;
+            idex->branchTarget = d->immed;
+            idex->rsReg = d->rs;
+            idex->rtReg = d->rt;
+            idex->rdReg = d->rd;
+            idex->bpb = ifid->bpb;
+            if(!(d->flags & OP_HALT) && ifid->uop){
+              sim->counters[CTR_FWDWB] += (producer[d->src1] == STAGE_WB) + (producer[d->src2] == STAGE_WB);
+              idex->readData1 = producer[d->src1] == STAGE_WB ? writeback[d->src1] : state->regFile[d->rs];
+              idex->readData2 = producer[d->src2] == STAGE_WB ? writeback[d->src2] : state->regFile[d->rt];
             }
-            if((get_rt(state.IFID.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
-              newState.IDEX.readData2 = state.MEMWB.writeDataMem;
-              newState.IDEX.readData1 = state.regFile[newState.IDEX.rsReg];
 
+            if((d->flags & OP_BRANCH) && !sim->predictor.hasTarget)
+              idex->bpb = sim->predictor.predict(&sim->predictor, ifid->PCPlus4 - 4, &target);
+            if(((d->flags & OP_BRANCH) && !sim->predictor.hasTarget && idex->bpb) || (d->flags & OP_JUMP)){
+              /* A cycle of fetch is lost, and so is the rest of IF/ID */
+              squashed = 1;
+              sim->stalls += width + wide->ifidCount - i - 1;
+              sim->counters[CTR_TAKENBUBBLES] += width + wide->ifidCount - i - 1;
+              sim->events |= EVENT_STALL;
+              state->PC = idex->immed;
+              break;
             }
-            else{
+            if(d->flags & OP_HALT)
+              break;
+          }
+          if(lost >= 0){
+            sim->stalls += width - newWide->idexCount;
+            sim->counters[lost] += width - newWide->idexCount;
+            sim->events |= EVENT_STALL;
+          }
 
-              newState.IDEX.readData1 = state.regFile[get_rs(state.IFID.instr)];
-              newState.IDEX.readData2 = state.regFile[get_rt(state.IFID.instr)];
+          /* Instructions that did not issue wait at the front of IF/ID */
+          if(!squashed)
+            for(i = newWide->idexCount; i < wide->ifidCount; i++)
+              newWide->IFID[k++] = wide->IFID[i];
+        }
+        else
+          newWide->idexCount = 0;
 
+        /* --------------------- IF stage --------------------- */
+        if(!flushed && !squashed){
+          for( ; k < width && fetchUop(state, state->PC + 4); k++){
+            ifid = &newWide->IFID[k];
+            ifid->PCPlus4 = state->PC + 4;
+            ifid->uop = fetchUop(state, state->PC + 4);
+            ifid->instr = state->instrMem[ifid->uop - 1];
+            sim->memoryStall += cacheAccess(&sim->icache, state->PC, 0);
+            state->PC += 4;
+            if(sim->predictor.hasTarget && sim->predictor.predict(&sim->predictor, ifid->PCPlus4 - 4, &target)){
+              /* A fetch bundle ends at a branch predicted taken */
+              ifid->bpb = 1;
+              state->PC = target;
+              k++;
+              break;
             }
-            if(bpb > 2){
+          }
+        }
+        newWide->ifidCount = k;
 
-              stalls++;
-              stalled = 1;
-              branches++;
-              newState.PC = newState.IDEX.immed;
-              newState.IFID.instr = 0;
-              newState.IFID.PCPlus4 = 0;
+        /* --------------------- MEM stage --------------------- */
+        for(i = 0; i < wide->exmemCount; i++){
+          d = &state->decodedMem[wide->EXMEM[i].uop];
+          k = newWide->memwbCount++;
+          newWide->MEMWB[k].instr = wide->EXMEM[i].instr;
+          newWide->MEMWB[k].uop = wide->EXMEM[i].uop;
+          newWide->MEMWB[k].bpb = wide->EXMEM[i].bpb;
+          if(d->dest != NOREG){
+            newWide->MEMWB[k].writeDataALU = wide->EXMEM[i].aluResult;
+            newWide->MEMWB[k].writeReg = wide->EXMEM[i].writeReg;
+          }
+          if(d->flags & OP_LOAD){
+            newWide->MEMWB[k].writeDataMem = state->dataMem[dataIndex(state, wide->EXMEM[i].aluResult, sim->error)];
+            sim->memoryStall += cacheAccess(&sim->dcache, wide->EXMEM[i].aluResult, 0);
+          }
+          else if(d->flags & OP_STORE){
+            state->dataMem[dataIndex(state, wide->EXMEM[i].aluResult, sim->error)] = wide->EXMEM[i].writeDataReg;
+            if(sim->checker != NULL)
+              checkStore(sim, wide->EXMEM[i].aluResult, wide->EXMEM[i].writeDataReg);
+            sim->memoryStall += cacheAccess(&sim->dcache, wide->EXMEM[i].aluResult, 1);
+          }
+        }
+
+        /* --------------------- WB stage --------------------- */
+        for(i = 0; i < wide->memwbCount; i++){
+          d = &state->decodedMem[wide->MEMWB[i].uop];
+          if(!d->op)
+            continue;
+          if(d->dest != NOREG)
+            state->regFile[d->dest] = (d->flags & OP_LOAD) ? wide->MEMWB[i].writeDataMem : wide->MEMWB[i].writeDataALU;
+          sim->counters[CTR_RETIRED]++;
+          sim->counters[CTR_OPCODE + d->op - 1]++;
+          if(sim->checker != NULL)
+            checkRetire(sim, state, state->cycles, wide->MEMWB[i].uop, d->dest != NOREG ? state->regFile[d->dest] : 0);
+        }
+
+        swap = wide;
+        wide = newWide;
+        newWide = swap;
+
+        if (sim->error[0] != '\0') {
+            sim->status = SIM_ERROR;
+            break;
+        }
+    }
+
+  sim->wide = wide;
+  sim->newWide = newWide;
+  return sim->status;
+}
+
+/******************************************************************/
+/* The simStepDeep function is simStep for a pipeline whose depth */
+/* comes from the options: fetchStages IF, decodeStages ID,       */
+/* aluLatency EX and memoryLatency MEM stages, then WB. stage[s]  */
+/* holds the instruction performing stage s, counted from 0 for   */
+/* the first IF; stage[0] itself is the fetch of the cycle.       */
+/*   - Operands are taken in the first EX stage from the youngest */
+/*     older instruction writing them, or from the register file. */
+/*     An ALU result can be forwarded once it has left the last   */
+/*     EX stage, loaded data once it has left the last MEM stage, */
+/*     so the last ID stage holds an instruction until that will  */
+/*     be true in time. The load-use stall of the 5-stage         */
+/*     pipeline is the 1-cycle case of this rule.                 */
+/*   - A multiply or divide holds the first EX stage for the      */
+/*     latency of its unit, stalling the stages before it.        */
+/*   - Branches are predicted when they leave the first ID stage, */
+/*     squashing the fetches behind them, and resolved in         */
+/*     resolveStage, flushing every younger stage. Jumps redirect */
+/*     where branches are predicted, and jr where they resolve.   */
+/*   - Memory is read and written in the last MEM stage.          */
+/* With one stage of each kind it behaves like simStep.           */
+/******************************************************************/
+int simStepDeep(simulatorType *sim, long long cycles)
+{
+  stateType *state = sim->state;
+  deepType *deep = sim->deep;
+  deepType *newDeep = sim->newDeep;
+  deepType *swap;
+  int decode = sim->options.fetchStages;            /* First ID stage */
+  int issue = decode + sim->options.decodeStages - 1;  /* Last ID stage */
+  int execute = issue + 1;                          /* First EX stage */
+  int lastExecute = execute + sim->options.aluLatency - 1;
+  int lastMemory = lastExecute + sim->options.memoryLatency;
+  int writeback = lastMemory + 1;
+  int resolve = sim->options.resolveStage ? sim->options.resolveStage - 1 : execute;
+  int operand[2], reg[2];
+  int target, squashed, stalled, hold, flush, word, i, s;
+  stageType *stage, *producer;
+  decodedType *d, *p;
+
+    for ( ; cycles != 0 && sim->status == SIM_RUNNING; cycles--) {
+
+        d = &state->decodedMem[deep->stage[writeback].uop];
+        if (d->opcode == HALT)
+            sim->events |= EVENT_HALT;
+
+        if (sim->options.outputMode == VERBOSE ||
+            (sim->options.outputMode == INTERVAL && state->cycles % sim->options.dumpInterval == 0) ||
+            (sim->options.outputMode == EVENTS && (sim->events & sim->options.dumpEvents)))
+            printDeepState(state, deep, &sim->options);
+        sim->events = 0;
+
+        if (d->opcode == HALT) {
+            sim->status = SIM_HALTED;
+            if (sim->checker != NULL && checkHalt(sim, state, state->cycles + 1) != 0)
+                sim->status = SIM_ERROR;
+            break;
+        }
+
+        for (s = 1; s <= writeback && deep->stage[s].uop == 0; s++)
+            ;
+        if (s > writeback && fetchFault(state, sim->error)) {
+            sim->status = SIM_ERROR;
+            break;
+        }
+
+        if (sim->memoryStall > 0) {
+            sim->memoryStall--;
+            sim->counters[CTR_MEMORY]++;
+            sim->events |= EVENT_STALL;
+            state->cycles++;
+            continue;
+        }
+
+        memset(newDeep, 0, sizeof(deepType));
+        state->cycles++;
+
+        /* --------------------- WB stage --------------------- */
+        stage = &deep->stage[writeback];
+        if(d->op){
+          if(d->dest != NOREG)
+            state->regFile[d->dest] = stage->result;
+          sim->counters[CTR_RETIRED]++;
+          sim->counters[CTR_OPCODE + d->op - 1]++;
+          if(sim->checker != NULL)
+            checkRetire(sim, state, state->cycles, stage->uop, stage->result);
+        }
+
+        /* --------------- EX and MEM stages, which never stall --------------- */
+        /* except that a multiply or divide holds the first EX stage for the  */
+        /* latency of its unit, sending bubbles on                            */
+        stage = &deep->stage[execute];
+        hold = stage->busy + 1 < unitLatency(&sim->options, &state->decodedMem[stage->uop]);
+        for(s = lastMemory; s >= execute; s--){
+          if(s == execute && hold){
+            newDeep->stage[execute] = deep->stage[execute];
+            newDeep->stage[execute].busy++;
+            continue;
+          }
+          stage = &newDeep->stage[s + 1];
+          *stage = deep->stage[s];
+          d = &state->decodedMem[stage->uop];
+
+          if(s == execute && d->alu != ALU_NONE){
+            /* Forward from the youngest older writer of each operand */
+            reg[0] = d->src1;
+            reg[1] = d->src2;
+            for(i = 0; i < 2; i++){
+              operand[i] = reg[i] == NOREG ? 0 : state->regFile[reg[i]];
+              for(producer = &deep->stage[execute + 1]; reg[i] != NOREG && producer <= &deep->stage[writeback]; producer++)
+                if(state->decodedMem[producer->uop].dest == reg[i]){
+                  operand[i] = producer->result;
+                  sim->counters[producer == &deep->stage[writeback] ? CTR_FWDMEMWB : CTR_FWDEXMEM]++;
+                  break;
+                }
             }
+            stage->result = aluCompute(d, operand[0], operand[1], stage->PCPlus4);
+            stage->storeData = operand[1];
+            stage->taken = stage->result != 0;
+          }
+
+          if(s == lastMemory && (d->flags & OP_LOAD)){
+            sim->memoryStall += cacheAccess(&sim->dcache, stage->result, 0);
+            stage->result = state->dataMem[dataIndex(state, stage->result, sim->error)];
           }
-          else if(get_opcode(state.IFID.instr) == HALT){
-            newState.IDEX.readData1 = 0;
-            newState.IDEX.readData2 = 0;
+          else if(s == lastMemory && (d->flags & OP_STORE)){
+            word = dataIndex(state, stage->result, sim->error);
+            state->dataMem[word] = stage->storeData;
+            if(sim->checker != NULL)
+              checkStore(sim, stage->result, stage->storeData);
+            sim->memoryStall += cacheAccess(&sim->dcache, stage->result, 1);
           }
+        }
+
+        /* --------------------- issue --------------------- */
+        /* The instruction in the last ID stage waits unless each of its operands */
+        /* will have left the stage that produces it when it reaches EX          */
+        d = &state->decodedMem[deep->stage[issue].uop];
+        stalled = hold;
+        if(hold){
+          sim->stalls++;
+          sim->counters[CTR_UNITBUSY]++;
+          sim->events |= EVENT_STALL;
+        }
+        reg[0] = d->src1;
+        reg[1] = d->src2;
+        for(i = 0; i < 2 && !stalled; i++)
+          for(s = execute; reg[i] != NOREG && s < writeback; s++){
+            p = &state->decodedMem[deep->stage[s].uop];
+            if(p->dest != reg[i])
+              continue;
+            if(s < ((p->flags & OP_LOAD) ? lastMemory : lastExecute)){
+              stalled = 1;
+              sim->stalls++;
+              sim->counters[(p->flags & OP_LOAD) ? CTR_LOADUSE : CTR_DEPENDENCY]++;
+              sim->events |= EVENT_STALL;
+            }
+            break;
+          }
+
+        /* --------------------- IF and ID stages --------------------- */
+        squashed = 0;
+        if(stalled){
+          /* IF repeats the fetch of the held PC, like simStep */
+          for(s = 1; s <= issue; s++)
+            newDeep->stage[s] = deep->stage[s];
+          if(fetchUop(state, state->PC + 4))
+            sim->memoryStall += cacheAccess(&sim->icache, state->PC, 0);
+        }
+        else{
+          for(s = issue; s >= 1; s--)
+            newDeep->stage[s + 1] = deep->stage[s];
 
-          /*---stall next stage if RS or RT from this stage are
-          dependent on data from RD from previous instructions*/
+          stage = &newDeep->stage[1];
+          stage->uop = fetchUop(state, state->PC + 4);
+          if(stage->uop){
+            stage->PCPlus4 = state->PC + 4;
+            stage->instr = state->instrMem[stage->uop - 1];
+            sim->memoryStall += cacheAccess(&sim->icache, state->PC, 0);
+            state->PC += 4;
+            if(sim->predictor.hasTarget && sim->predictor.predict(&sim->predictor, stage->PCPlus4 - 4, &target)){
+              stage->bpb = 1;
+              state->PC = target;
+            }
+          }
 
+          /* A branch or jump leaving the first ID stage knows its target */
+          stage = &newDeep->stage[decode + 1];
+          d = &state->decodedMem[stage->uop];
+          if((d->flags & OP_BRANCH) && !sim->predictor.hasTarget)
+            stage->bpb = sim->predictor.predict(&sim->predictor, stage->PCPlus4 - 4, &target);
+          if(((d->flags & OP_BRANCH) && !sim->predictor.hasTarget && stage->bpb) || (d->flags & OP_JUMP)){
+            squashed = decode;
+            sim->stalls += squashed;
+            sim->counters[CTR_TAKENBUBBLES] += squashed;
+            sim->events |= EVENT_STALL;
+            memset(&newDeep->stage[1], 0, sizeof(stageType) * decode);
+            state->PC = d->immed;
+          }
+        }
 
-          if(((get_rt(state.IFID.instr) == state.IDEX.rtReg) || (get_rs(state.IFID.instr) == state.IDEX.rtReg)) && state.IDEX.instr!= 0 && get_opcode(state.IDEX.instr) != HALT && get_opcode(state.IDEX.instr) != R && get_opcode(state.IDEX.instr) != BNE){
-            stalls++;
-            stalled = 1;
-            newState.IDEX.instr = 0; //NOOP instr
-            newState.PC = state.PC;
-            newState.IFID.PCPlus4 = state.PC;
-            newState.IFID.instr = state.instrMem[(state.PC/4) - 1];;
-            newState.IDEX.PCPlus4 = 0;
-            newState.IDEX.immed = 0;
-            newState.IDEX.branchTarget = 0;
-            newState.IDEX.rsReg = 0;
-            newState.IDEX.rtReg = 0;
-            newState.IDEX.rdReg = 0;
-            newState.IDEX.readData1 = 0;
-            newState.IDEX.readData2 = 0;
+        /* --------------------- branch resolution --------------------- */
+        stage = &newDeep->stage[resolve + 1];
+        d = &state->decodedMem[stage->uop];
+        flush = 0;
+        if(d->flags & OP_BRANCH){
+          predictorResolve(&sim->predictor, stage->PCPlus4 - 4, d->immed, stage->taken, stage->bpb);
+          sim->counters[CTR_BRANCHES]++;
+          sim->counters[CTR_TAKEN] += stage->taken;
+          if(stage->taken != stage->bpb){
+            flush = 1;
+            sim->counters[CTR_MISPREDICTED]++;
+            sim->counters[CTR_MISSEDTAKEN] += stage->taken;
+            sim->events |= EVENT_MISPREDICT;
+            state->PC = stage->taken ? d->immed : stage->PCPlus4;
           }
+        }
+        /* An indirect jump resolves like a branch, always mispredicted */
+        else if(d->flags & OP_INDIRECT){
+          flush = 1;
+          state->PC = stage->result;
+        }
+        if(flush){
+          /* The flush covers any fetches squashed by a prediction this cycle */
+          sim->stalls += resolve - squashed;
+          sim->counters[CTR_TAKENBUBBLES] -= squashed;
+          sim->counters[CTR_FLUSHBUBBLES] += resolve;
+          sim->events |= EVENT_STALL;
+          memset(&newDeep->stage[1], 0, sizeof(stageType) * resolve);
+        }
 
+        swap = deep;
+        deep = newDeep;
+        newDeep = swap;
+
+        if (sim->error[0] != '\0') {
+            sim->status = SIM_ERROR;
+            break;
         }
+    }
+
+  sim->deep = deep;
+  sim->newDeep = newDeep;
+  return sim->status;
+}
+
+/* The number of stages of the pipeline described by the options */
+int pipelineDepth(optionsType *options)
+{
+  return options->fetchStages + options->decodeStages + options->aluLatency + options->memoryLatency + 1;
+}
+
+/* 1 if the options describe anything but the classic 5-stage pipeline */
+int deepPipeline(optionsType *options)
+{
+  return pipelineDepth(options) != 5 || (options->resolveStage && options->resolveStage != 3);
+}
+
+/******************************************************************/
+/* The simStepCore function is simStep for the out-of-order core. */
+/* Every cycle, in this order:                                    */
+/*   commit    retires up to width finished instructions from the */
+/*             head of the ROB; stores write memory only here     */
+/*   issue     takes up to width reservation stations whose       */
+/*             operands are ready, oldest first; the multiplier   */
+/*             is pipelined, the divider takes one divide at a    */
+/*             time                                               */
+/*   memory    performs loads whose address is known once every   */
+/*             older store's address is, forwarding the data of   */
+/*             the youngest older store to the same word          */
+/*   execute   computes the issued instructions and broadcasts    */
+/*             their results, those of multiplies and divides     */
+/*             once their unit's latency has passed; a            */
+/*             mispredicted branch or a jr squashes everything    */
+/*             younger and rebuilds the rename map from the ROB   */
+/*             entries that survive                               */
+/*   dispatch  renames up to width fetched instructions into the  */
+/*             ROB, the stations and the LSQ, predicting branches */
+/*             and completing jumps                               */
+/*   fetch     refills the fetch buffer                           */
+/* Results broadcast during a cycle wake stations for the next    */
+/* one. Branches train the predictor when they commit, so wrong-  */
+/* path branches are not counted, and a bad data address only     */
+/* stops the simulation if its instruction commits.               */
+/******************************************************************/
+int simStepCore(simulatorType *sim, long long cycles)
+{
+  stateType *state = sim->state;
+  coreType *core = &sim->core;
+  int width = sim->options.width;
+  int memoryPorts = sim->options.memoryPorts ? sim->options.memoryPorts : width;
+  int robSize = sim->options.robSize;
+  int lsqSize = sim->options.lsqSize;
+  stationType issued[MAXWIDTH];      /* Stations taken by issue, oldest first */
+  int count, best, lost, redirected, waiting, ports, target, index, i, j;
+  robEntryType *entry;
+  stationType *station;
+  lsqEntryType *lsq, *store;
+  decodedType *d;
+  IFIDType *fetch;
+
+    for ( ; cycles != 0 && sim->status == SIM_RUNNING; cycles--) {
+
+        entry = &core->rob[core->robHead];
+        if (core->robCount > 0 && (state->decodedMem[entry->uop].flags & OP_HALT))
+            sim->events |= EVENT_HALT;
+
+        if (sim->options.outputMode == VERBOSE ||
+            (sim->options.outputMode == INTERVAL && state->cycles % sim->options.dumpInterval == 0) ||
+            (sim->options.outputMode == EVENTS && (sim->events & sim->options.dumpEvents)))
+            printCoreState(state, core, &sim->options);
+        sim->events = 0;
+
+        /* The HALT reaching the head of the ROB ends the program */
+        if (core->robCount > 0 && (state->decodedMem[entry->uop].flags & OP_HALT)) {
+            sim->status = SIM_HALTED;
+            if (sim->checker != NULL && checkHalt(sim, state, state->cycles + 1) != 0)
+                sim->status = SIM_ERROR;
+            break;
+        }
+
+        if (core->robCount == 0 && core->fetchCount == 0 && fetchFault(state, sim->error)) {
+            sim->status = SIM_ERROR;
+            break;
+        }
+
+        if (sim->memoryStall > 0) {
+            sim->memoryStall--;
+            sim->counters[CTR_MEMORY]++;
+            sim->events |= EVENT_STALL;
+            state->cycles++;
+            continue;
+        }
+        state->cycles++;
+
+        /* --------------------- commit --------------------- */
+        for(i = 0; i < width && core->robCount > 0; i++){
+          entry = &core->rob[core->robHead];
+          d = &state->decodedMem[entry->uop];
+          if(!entry->done || (d->flags & OP_HALT))
+            break;
+          if(entry->fault){
+            dataIndex(state, entry->address, sim->error);
+            break;
+          }
+          if(d->dest != NOREG){
+            state->regFile[d->dest] = entry->value;
+            if(core->map[d->dest] == core->robHead)
+              core->map[d->dest] = -1;
+          }
+          if(d->flags & (OP_LOAD | OP_STORE)){
+            lsq = &core->lsq[core->lsqHead];
+            if(d->flags & OP_STORE){
+              state->dataMem[lsq->address/4] = lsq->data;
+              if(sim->checker != NULL)
+                checkStore(sim, lsq->address, lsq->data);
+              sim->memoryStall += cacheAccess(&sim->dcache, lsq->address, 1);
+            }
+            core->lsqHead = (core->lsqHead + 1) % lsqSize;
+            core->lsqCount--;
+          }
+          if(d->flags & OP_BRANCH){
+            predictorResolve(&sim->predictor, entry->PCPlus4 - 4, d->immed, entry->taken, entry->bpb);
+            sim->counters[CTR_BRANCHES]++;
+            sim->counters[CTR_TAKEN] += entry->taken;
+            if(entry->taken != entry->bpb){
+              sim->counters[CTR_MISPREDICTED]++;
+              sim->counters[CTR_MISSEDTAKEN] += entry->taken;
+            }
+          }
+          if(d->op){
+            sim->counters[CTR_RETIRED]++;
+            sim->counters[CTR_OPCODE + d->op - 1]++;
+            if(sim->checker != NULL)
+              checkRetire(sim, state, state->cycles, entry->uop, entry->value);
+          }
+          core->robHead = (core->robHead + 1) % robSize;
+          core->robCount--;
+        }
+        if (sim->error[0] != '\0') {
+            sim->status = SIM_ERROR;
+            break;
+        }
+
+        /* --------------------- issue --------------------- */
+        waiting = 0;
+        for(count = 0; count < width; count++){
+          best = -1;
+          for(i = 0; i < sim->options.rsSize; i++){
+            station = &core->stations[i];
+            if(station->rob < 0 || station->tag1 >= 0 || station->tag2 >= 0)
+              continue;
+            /* The divider is not pipelined: a divide waits until it is free */
+            if(state->decodedMem[core->rob[station->rob].uop].alu == ALU_DIV && state->cycles < core->divideFree){
+              waiting = 1;
+              continue;
+            }
+            if(best < 0 || robAge(core, robSize, station->rob) < robAge(core, robSize, core->stations[best].rob))
+              best = i;
+          }
+          if(best < 0)
+            break;
+          if(state->decodedMem[core->rob[core->stations[best].rob].uop].alu == ALU_DIV)
+            core->divideFree = state->cycles + sim->options.divLatency;
+          issued[count] = core->stations[best];
+          core->stations[best].rob = -1;
+          core->stationCount--;
+        }
+        sim->counters[CTR_UNITBUSY] += waiting;
+
+        /* --------------------- memory --------------------- */
+        ports = 0;
+        for(i = 0; i < core->lsqCount && ports < memoryPorts; i++){
+          lsq = &core->lsq[(core->lsqHead + i) % lsqSize];
+          entry = &core->rob[lsq->rob];
+          if(lsq->store || !lsq->ready || entry->done)
+            continue;
+
+          /* Search the older stores, youngest first */
+          for(j = i - 1; j >= 0; j--){
+            store = &core->lsq[(core->lsqHead + j) % lsqSize];
+            if(store->store && (!store->ready || store->address/4 == lsq->address/4))
+              break;
+          }
+          if(j >= 0 && !store->ready)
+            continue;
+          ports++;
+          if(j >= 0){
+            entry->value = store->data;
+            sim->counters[CTR_STOREFORWARD]++;
+          }
+          else if(lsq->address < 0 || lsq->address/4 >= state->dataSize){
+            entry->value = 0;
+            entry->fault = 1;
+          }
+          else{
+            entry->value = state->dataMem[lsq->address/4];
+            sim->memoryStall += cacheAccess(&sim->dcache, lsq->address, 0);
+          }
+          coreBroadcast(core, sim->options.rsSize, lsq->rob, entry->value);
+        }
+
+        /* --------------------- execute --------------------- */
+        /* Multiplies and divides broadcast once their unit is done */
+        if(core->pending > 0){
+          core->pending = 0;
+          for(i = 0; i < core->robCount; i++){
+            index = (core->robHead + i) % robSize;
+            entry = &core->rob[index];
+            if(entry->finish && entry->finish <= state->cycles){
+              entry->finish = 0;
+              coreBroadcast(core, sim->options.rsSize, index, entry->value);
+            }
+            else if(entry->finish)
+              core->pending++;
+          }
+        }
+
+        redirected = 0;
+        for(i = 0; i < count; i++){
+          station = &issued[i];
+          if(robAge(core, robSize, station->rob) >= core->robCount)
+            continue;  /* Squashed by an older branch this cycle */
+          entry = &core->rob[station->rob];
+          d = &state->decodedMem[entry->uop];
+          entry->value = aluCompute(d, station->value1, station->value2, entry->PCPlus4);
+
+          if(d->flags & (OP_LOAD | OP_STORE)){
+            /* Address generation; the load itself waits for the memory step */
+            for(j = 0; core->lsq[(core->lsqHead + j) % lsqSize].rob != station->rob; j++)
+              ;
+            lsq = &core->lsq[(core->lsqHead + j) % lsqSize];
+            lsq->address = entry->value;
+            lsq->data = station->value2;
+            lsq->ready = 1;
+            entry->address = entry->value;
+            if(d->flags & OP_STORE){
+              entry->fault = entry->address < 0 || entry->address/4 >= state->dataSize;
+              entry->done = 1;
+            }
+          }
+          else if(d->flags & OP_BRANCH){
+            entry->taken = entry->value != 0;
+            entry->done = 1;
+            if(entry->taken != entry->bpb){
+              sim->events |= EVENT_STALL | EVENT_MISPREDICT;
+              lost = coreSquash(core, state, &sim->options, station->rob);
+              sim->stalls += lost;
+              sim->counters[CTR_FLUSHBUBBLES] += lost;
+              state->PC = entry->taken ? d->immed : entry->PCPlus4;
+              redirected = 1;
+            }
+          }
+          else if(d->flags & OP_INDIRECT){
+            /* Fetch went on sequentially behind jr, which never predicts */
+            entry->done = 1;
+            sim->events |= EVENT_STALL;
+            lost = coreSquash(core, state, &sim->options, station->rob);
+            sim->stalls += lost;
+            sim->counters[CTR_FLUSHBUBBLES] += lost;
+            state->PC = entry->value;
+            redirected = 1;
+          }
+          else if(unitLatency(&sim->options, d) > 1){
+            entry->finish = state->cycles + unitLatency(&sim->options, d) - 1;
+            core->pending++;
+          }
+          else
+            coreBroadcast(core, sim->options.rsSize, station->rob, entry->value);
+        }
+
+        /* --------------------- dispatch --------------------- */
+        lost = -1;
+        for(i = 0; i < core->fetchCount && !redirected; i++){
+          fetch = &core->fetch[i];
+          d = &state->decodedMem[fetch->uop];
+          if(fetch->uop == 0)
+            continue;  /* NOOPs are dropped here */
+          if(core->robCount == robSize){
+            lost = CTR_ROBFULL;
+            break;
+          }
+          if(!(d->flags & (OP_HALT | OP_JUMP)) && core->stationCount == sim->options.rsSize){
+            lost = CTR_RSFULL;
+            break;
+          }
+          if((d->flags & (OP_LOAD | OP_STORE)) && core->lsqCount == lsqSize){
+            lost = CTR_LSQFULL;
+            break;
+          }
+
+          index = (core->robHead + core->robCount++) % robSize;
+          entry = &core->rob[index];
+          memset(entry, 0, sizeof(robEntryType));
+          entry->instr = fetch->instr;
+          entry->uop = fetch->uop;
+          entry->PCPlus4 = fetch->PCPlus4;
+          entry->bpb = fetch->bpb;
+          if(d->flags & (OP_HALT | OP_JUMP)){
+            entry->done = 1;  /* jal links here, without a station */
+            entry->value = aluCompute(d, 0, 0, fetch->PCPlus4);
+          }
+          else{
+            for(j = 0; core->stations[j].rob >= 0; j++)
+              ;
+            station = &core->stations[j];
+            station->rob = index;
+            coreRename(core, state, d->src1, &station->tag1, &station->value1);
+            coreRename(core, state, d->src2, &station->tag2, &station->value2);
+            core->stationCount++;
+          }
+          if(d->flags & (OP_LOAD | OP_STORE)){
+            lsq = &core->lsq[(core->lsqHead + core->lsqCount++) % lsqSize];
+            memset(lsq, 0, sizeof(lsqEntryType));
+            lsq->rob = index;
+            lsq->store = (d->flags & OP_STORE) != 0;
+          }
+          if(d->dest != NOREG)
+            core->map[d->dest] = index;
+
+          /* Without a target buffer, branches are predicted here and a */
+          /* predicted-taken one, like any jump, discards the rest of   */
+          /* the fetch buffer                                           */
+          if((d->flags & OP_BRANCH) && !sim->predictor.hasTarget)
+            entry->bpb = sim->predictor.predict(&sim->predictor, fetch->PCPlus4 - 4, &target);
+          if(((d->flags & OP_BRANCH) && !sim->predictor.hasTarget && entry->bpb) || (d->flags & OP_JUMP)){
+            sim->stalls += width + core->fetchCount - i - 1;
+            sim->counters[CTR_TAKENBUBBLES] += width + core->fetchCount - i - 1;
+            sim->events |= EVENT_STALL;
+            state->PC = d->immed;
+            redirected = 1;
+            i++;
+            break;
+          }
+        }
+        if(lost >= 0){
+          sim->stalls += width - i;
+          sim->counters[lost] += width - i;
+          sim->events |= EVENT_STALL;
+        }
+
+        /* Instructions that were not dispatched wait at the front */
+        if(redirected)
+          core->fetchCount = 0;
+        else{
+          for(j = 0; i < core->fetchCount; i++, j++)
+            core->fetch[j] = core->fetch[i];
+          core->fetchCount = j;
+        }
+
+        /* --------------------- fetch --------------------- */
+        for( ; !redirected && core->fetchCount < width && fetchUop(state, state->PC + 4); core->fetchCount++){
+          fetch = &core->fetch[core->fetchCount];
+          fetch->PCPlus4 = state->PC + 4;
+          fetch->uop = fetchUop(state, state->PC + 4);
+          fetch->instr = state->instrMem[fetch->uop - 1];
+          fetch->bpb = 0;
+          sim->memoryStall += cacheAccess(&sim->icache, state->PC, 0);
+          state->PC += 4;
+          if(sim->predictor.hasTarget && sim->predictor.predict(&sim->predictor, fetch->PCPlus4 - 4, &target)){
+            fetch->bpb = 1;
+            state->PC = target;
+            core->fetchCount++;
+            break;
+          }
+        }
+    }
+
+  return sim->status;
+}
+
+/* Allocates an empty core, or returns -1 if memory runs out */
+int coreInit(coreType *core, optionsType *options)
+{
+  int i;
+
+  memset(core, 0, sizeof(coreType));
+  core->rob = calloc(options->robSize, sizeof(robEntryType));
+  core->stations = calloc(options->rsSize, sizeof(stationType));
+  core->lsq = calloc(options->lsqSize, sizeof(lsqEntryType));
+  if(core->rob == NULL || core->stations == NULL || core->lsq == NULL)
+    return -1;
+  for(i = 0; i < options->rsSize; i++)
+    core->stations[i].rob = -1;
+  for(i = 0; i < NUMREGS; i++)
+    core->map[i] = -1;
+  return 0;
+}
+
+void coreFree(coreType *core)
+{
+  free(core->rob);
+  free(core->stations);
+  free(core->lsq);
+}
+
+/* Age of a ROB entry, 0 for the head */
+int robAge(coreType *core, int robSize, int index)
+{
+  return (index - core->robHead + robSize) % robSize;
+}
+
+/* Reads a source register at dispatch: its value, or the ROB entry that will produce it */
+void coreRename(coreType *core, stateType *state, int reg, int *tag, int *value)
+{
+  *tag = -1;
+  *value = 0;
+  if(reg == NOREG)
+    return;
+  if(core->map[reg] < 0)
+    *value = state->regFile[reg];
+  else if(core->rob[core->map[reg]].done)
+    *value = core->rob[core->map[reg]].value;
+  else
+    *tag = core->map[reg];
+}
+
+/* Completes a ROB entry and wakes the stations waiting for its value */
+void coreBroadcast(coreType *core, int rsSize, int index, int value)
+{
+  int i;
+
+  core->rob[index].done = 1;
+  core->rob[index].value = value;
+  for(i = 0; i < rsSize; i++){
+    if(core->stations[i].rob < 0)
+      continue;
+    if(core->stations[i].tag1 == index){
+      core->stations[i].tag1 = -1;
+      core->stations[i].value1 = value;
+    }
+    if(core->stations[i].tag2 == index){
+      core->stations[i].tag2 = -1;
+      core->stations[i].value2 = value;
+    }
+  }
+}
+
+/******************************************************************/
+/* The coreSquash function recovers from a mispredicted branch:   */
+/* it drops every ROB, station, LSQ and fetch buffer entry        */
+/* younger than the branch and rebuilds the rename map from the   */
+/* ROB entries left. It returns the number of instructions lost.  */
+/******************************************************************/
+int coreSquash(coreType *core, stateType *state, optionsType *options, int branch)
+{
+  int keep = robAge(core, options->robSize, branch) + 1;
+  int lost = core->robCount - keep + core->fetchCount;
+  int i, index;
+  decodedType *d;
+
+  for(i = 0; i < options->rsSize; i++)
+    if(core->stations[i].rob >= 0 && robAge(core, options->robSize, core->stations[i].rob) >= keep){
+      core->stations[i].rob = -1;
+      core->stationCount--;
+    }
+  while(core->lsqCount > 0 &&
+        robAge(core, options->robSize, core->lsq[(core->lsqHead + core->lsqCount - 1) % options->lsqSize].rob) >= keep)
+    core->lsqCount--;
+  core->robCount = keep;
+  core->fetchCount = 0;
+
+  for(i = 0; i < NUMREGS; i++)
+    core->map[i] = -1;
+  for(i = 0; i < keep; i++){
+    index = (core->robHead + i) % options->robSize;
+    d = &state->decodedMem[core->rob[index].uop];
+    if(d->dest != NOREG)
+      core->map[d->dest] = index;
+  }
+  return lost;
+}
+
+/******************************************************************/
+/* The multicore functions run several scalar pipelines on one    */
+/* data memory. multicoreCreate builds a core per the options     */
+/* from the same program, each starting with its number in        */
+/* COREREG, and points them all at the data memory of the         */
+/* simulator driving them. simStepMulti advances the cores in     */
+/* rounds: with one host thread a round is a single cycle of      */
+/* every core in turn, so the run is deterministic; with more,    */
+/* the threads step their cores quantum cycles in parallel and    */
+/* meet at the end of the round, and cores see each other's       */
+/* stores and bus transactions in whatever order the host         */
+/* interleaves them within a round.                               */
+/******************************************************************/
+int multicoreCreate(simulatorType *sim, programType *program)
+{
+  multicoreType *mc = calloc(1, sizeof(multicoreType));
+  optionsType options = sim->options;
+  simulatorType *core;
+  int i;
+
+  if(mc == NULL){
+    snprintf(sim->error, ERRORLENGTH, "cannot allocate %d cores", options.cores);
+    return -1;
+  }
+  sim->multicore = mc;
+  mc->protocol = options.coherence;
+  mc->threadCount = options.coreThreads < options.cores ? options.coreThreads : options.cores;
+  pthread_mutex_init(&mc->bus, NULL);
+  pthread_mutex_init(&mc->lock, NULL);
+  pthread_cond_init(&mc->start, NULL);
+  pthread_cond_init(&mc->finish, NULL);
+  if(initState(sim->state, &sim->arena, program, sim->error) != 0)  /* holds the shared data memory */
+    return -1;
+
+  /* The cores dump nothing; simStepMulti dumps them all together */
+  options.cores = 1;
+  options.outputMode = QUIET;
+  for(i = 0; i < sim->options.cores; i++){
+    core = simCreate(&options, program);
+    if(core == NULL || core->status == SIM_ERROR){
+      snprintf(sim->error, ERRORLENGTH, "core %d: %.200s", i, core != NULL ? core->error : "cannot allocate the simulator");
+      simDestroy(core);
+      mc->threadCount = 1;
+      return -1;
+    }
+    core->bus = mc;
+    core->coreId = i;
+    core->state->dataMem = sim->state->dataMem;
+    core->newState->dataMem = sim->state->dataMem;
+    core->state->regFile[COREREG] = i;
+    mc->cores[mc->count++] = core;
+  }
+  for(i = 1; i < mc->threadCount; i++){
+    if(pthread_create(&mc->threads[i], NULL, multicoreThread, mc) != 0){
+      snprintf(sim->error, ERRORLENGTH, "cannot start host thread %d of %d", i + 1, mc->threadCount);
+      mc->threadCount = i;  /* multicoreFree joins the threads started */
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void multicoreFree(multicoreType *mc)
+{
+  int i;
+
+  if(mc == NULL)
+    return;
+  pthread_mutex_lock(&mc->lock);
+  mc->quit = 1;
+  pthread_cond_broadcast(&mc->start);
+  pthread_mutex_unlock(&mc->lock);
+  for(i = 1; i < mc->threadCount; i++)
+    pthread_join(mc->threads[i], NULL);
+  for(i = 0; i < mc->count; i++)
+    simDestroy(mc->cores[i]);
+  pthread_mutex_destroy(&mc->bus);
+  pthread_mutex_destroy(&mc->lock);
+  pthread_cond_destroy(&mc->start);
+  pthread_cond_destroy(&mc->finish);
+  free(mc);
+}
+
+/* A host thread other than the caller's: steps its share of the cores in every round until the run ends */
+void *multicoreThread(void *arg)
+{
+  multicoreType *mc = arg;
+  long long seen = 0;
+  int id, quantum;
+
+  pthread_mutex_lock(&mc->lock);
+  id = ++mc->started;
+  while(1){
+    while(mc->round == seen && !mc->quit)
+      pthread_cond_wait(&mc->start, &mc->lock);
+    if(mc->quit)
+      break;
+    seen = mc->round;
+    quantum = mc->quantum;
+    pthread_mutex_unlock(&mc->lock);
+    multicoreShare(mc, id, quantum);
+    pthread_mutex_lock(&mc->lock);
+    if(--mc->active == 0)
+      pthread_cond_signal(&mc->finish);
+  }
+  pthread_mutex_unlock(&mc->lock);
+  return NULL;
+}
+
+/* Steps the cores of host thread first by quantum cycles */
+void multicoreShare(multicoreType *mc, int first, int quantum)
+{
+  int i;
+
+  for(i = first; i < mc->count; i += mc->threadCount)
+    simStep(mc->cores[i], quantum);
+}
+
+int simStepMulti(simulatorType *sim, long long cycles)
+{
+  multicoreType *mc = sim->multicore;
+  simulatorType *core;
+  stateType *state = sim->state;
+  int quantum, events, running, i;
+  long long start;           /* Cycles when the round began */
+  char live[MAXCORES];       /* 1 for the cores running when the round began */
+
+  while(cycles != 0 && sim->status == SIM_RUNNING){
+    quantum = mc->threadCount > 1 ? sim->options.quantum : 1;
+    if(cycles > 0 && cycles < quantum)
+      quantum = cycles;
+
+    /* Dump the cores still running between rounds, when a single */
+    /* pipeline would be dumped at some cycle of the round        */
+    events = 0;
+    start = state->cycles;
+    for(i = 0; i < mc->count; i++){
+      core = mc->cores[i];
+      live[i] = core->status == SIM_RUNNING;
+      if(live[i]){
+        events |= core->events;
+        if(core->state->decodedMem[core->state->MEMWB.uop].opcode == HALT)
+          events |= EVENT_HALT;
+      }
+    }
+    if(sim->options.outputMode == VERBOSE ||
+       (sim->options.outputMode == INTERVAL &&
+        (state->cycles + sim->options.dumpInterval - 1) / sim->options.dumpInterval * sim->options.dumpInterval <
+        state->cycles + quantum) ||
+       (sim->options.outputMode == EVENTS && (events & sim->options.dumpEvents))){
+      for(i = 0; i < mc->count; i++){
+        if(mc->cores[i]->status == SIM_RUNNING){
+          printf("\n==================== Core %d ====================", i);
+          printState(mc->cores[i]->state);
+        }
+      }
+    }
+
+    if(mc->threadCount > 1){
+      pthread_mutex_lock(&mc->lock);
+      mc->quantum = quantum;
+      mc->active = mc->threadCount;
+      mc->round++;
+      pthread_cond_broadcast(&mc->start);
+      pthread_mutex_unlock(&mc->lock);
+      multicoreShare(mc, 0, quantum);
+      pthread_mutex_lock(&mc->lock);
+      mc->active--;
+      while(mc->active > 0)
+        pthread_cond_wait(&mc->finish, &mc->lock);
+      pthread_mutex_unlock(&mc->lock);
+    }
+    else
+      multicoreShare(mc, 0, quantum);
+
+    /* The run lasts as long as its slowest core and stops at the first error. */
+    /* A core that halted after the first cycle of a round was not dumped at */
+    /* its HALT, so it is dumped now.                                         */
+    running = 0;
+    for(i = 0; i < mc->count; i++){
+      core = mc->cores[i];
+      if(live[i] && core->status == SIM_HALTED && core->state->cycles > start &&
+         (sim->options.outputMode == VERBOSE ||
+          (sim->options.outputMode == EVENTS && (sim->options.dumpEvents & EVENT_HALT)))){
+        printf("\n==================== Core %d ====================", i);
+        printState(core->state);
+      }
+      if(core->status == SIM_ERROR && sim->status == SIM_RUNNING){
+        snprintf(sim->error, ERRORLENGTH, "core %d: %.200s", i, core->error);
+        sim->status = SIM_ERROR;
+      }
+      running += core->status == SIM_RUNNING;
+      if(core->state->cycles > state->cycles)
+        state->cycles = core->state->cycles;
+    }
+    if(sim->status == SIM_RUNNING && running == 0)
+      sim->status = SIM_HALTED;
+    if(cycles > 0)
+      cycles -= quantum;
+  }
+  return sim->status;
+}
+
+/* Adds up the results of the cores */
+void multicoreResults(multicoreType *mc, resultsType *results)
+{
+  resultsType core;
+  int i, j;
+
+  results->cores = mc->count;
+  results->coherence = mc->protocol;
+  for(i = 0; i < mc->count; i++){
+    simGetResults(mc->cores[i], &core);
+    results->stalls += core.stalls;
+    results->branches += core.branches;
+    results->mispredictions += core.mispredictions;
+    results->predictorKind = core.predictorKind;
+    results->predictorSize = core.predictorSize;
+    results->memoryStalls += core.memoryStalls;
+    for(j = 0; j < NUMCOUNTERS; j++)
+      results->counters[j] += core.counters[j];
+    cacheStatsAdd(&results->icache, &core.icache);
+    cacheStatsAdd(&results->dcache, &core.dcache);
+    results->coreCycles[i] = core.cycles;
+    results->coreRetired[i] = core.counters[CTR_RETIRED];
+  }
+}
+
+/******************************************************************/
+/* The sampling functions estimate a long run from short windows  */
+/* of detailed simulation, SMARTS style. Every sampling period    */
+/* ends with a window of sampleUnit retired instructions; before  */
+/* it, the pipeline simulates sampleWarmup instructions in detail */
+/* to fill its latches, and before that the rest of the period    */
+/* runs functionally, keeping the predictor and the caches warm,  */
+/* through the runFunctional variant sampleStart picks for them.  */
+/* After a window, fetch stops until the pipeline has emptied,    */
+/* which leaves the architectural state precise for the next      */
+/* functional stretch. The detailed counters cover every cycle    */
+/* simulated in detail; the estimates cover the windows alone.    */
+/******************************************************************/
+int sampleStart(simulatorType *sim)
+{
+  sim->sampler = calloc(1, sizeof(samplerType));
+  if(sim->sampler == NULL)
+    return -1;
+  sim->sampler->windowEnd = sim->skipped + sim->options.samplePeriod;
+  sim->sampler->warm = functionalVariant(&sim->predictor, sim->icache.sets ? &sim->icache : NULL,
+                                         sim->dcache.sets ? &sim->dcache : NULL);
+  sampleWarm(sim, sim->state);
+  return 0;
+}
+
+/* Runs functionally up to the warm-up of the next window, or to the HALT */
+void sampleWarm(simulatorType *sim, stateType *state)
+{
+  samplerType *sampler = sim->sampler;
+  cacheStatsType icache = sim->icache.stats;
+  cacheStatsType dcache = sim->dcache.stats;
+  long long limit = sampler->windowEnd - sim->options.sampleUnit - sim->options.sampleWarmup -
+                    sim->skipped - sim->counters[CTR_RETIRED];
+  long long count = 0;
+
+  if(limit > 0){
+    count = sampler->warm(state, &sim->predictor, sim->icache.sets ? &sim->icache : NULL,
+                          sim->dcache.sets ? &sim->dcache : NULL, limit, -1, sim->error);
+    sim->skipped += count;
+    sim->icache.stats = icache;  /* the caches report detailed accesses only */
+    sim->dcache.stats = dcache;
+  }
+  if(sim->error[0] != '\0')
+    sim->status = SIM_ERROR;
+  else if(count < limit)
+    sim->status = SIM_HALTED;
+  sampler->phase = SAMPLE_WARMUP;
+  sampler->next = sim->counters[CTR_RETIRED] + sim->options.sampleWarmup;
+}
+
+/* Called after a cycle that ended a phase, or of draining */
+void sampleAdvance(simulatorType *sim, stateType *state)
+{
+  samplerType *sampler = sim->sampler;
+  double c, s, b, m;
+
+  switch(sampler->phase){
+  case SAMPLE_WARMUP:
+    sampler->phase = SAMPLE_MEASURE;
+    sampler->next = sim->counters[CTR_RETIRED] + sim->options.sampleUnit;
+    sampler->cycles = state->cycles;
+    sampler->stalls = sim->stalls;
+    sampler->branches = sim->predictor.branches;
+    sampler->mispredictions = sim->predictor.mispredictions;
+    break;
+  case SAMPLE_MEASURE:
+    c = state->cycles - sampler->cycles;
+    s = sim->stalls - sampler->stalls;
+    b = sim->predictor.branches - sampler->branches;
+    m = sim->predictor.mispredictions - sampler->mispredictions;
+    sampler->c += c;
+    sampler->c2 += c * c;
+    sampler->s += s;
+    sampler->s2 += s * s;
+    sampler->b += b;
+    sampler->b2 += b * b;
+    sampler->m += m;
+    sampler->m2 += m * m;
+    sampler->mb += m * b;
+    sampler->windows++;
+    sampler->phase = SAMPLE_DRAIN;
+    sampler->next = LLONG_MAX;
+    sampler->windowEnd += sim->options.samplePeriod;
+    sim->draining = 1;
+    break;
+  case SAMPLE_DRAIN:
+    if(state->IFID.uop || state->IDEX.uop || state->EXMEM.uop || state->MEMWB.uop || sim->memoryStall)
+      break;
+    sim->draining = 0;
+    sampleWarm(sim, state);
+    break;
+  }
+}
+
+/* The estimates: means over the windows with their confidence intervals */
+void sampleResults(samplerType *sampler, optionsType *options, samplingType *sampling)
+{
+  double n = sampler->windows;
+  double unit = options->sampleUnit;
+  double rate;
+
+  memset(sampling, 0, sizeof(samplingType));
+  sampling->windows = sampler->windows;
+  sampling->unit = options->sampleUnit;
+  sampling->period = options->samplePeriod;
+  sampling->cpiError = sampling->stallError = sampling->mispredictError = -1;
+  if(n == 0)
+    return;
+  sampling->cpi = sampler->c / n / unit;
+  sampling->stallRate = sampler->s / n / unit;
+  rate = sampler->b ? sampler->m / sampler->b : 0;
+  sampling->mispredictRate = rate;
+  if(n < 2)
+    return;
+
+  /* Sample variances; the misprediction rate is a ratio estimate, */
+  /* whose variance comes from the residuals m - rate * b           */
+  sampling->cpiError = CONFIDENCE * sqrt(fmax(sampler->c2 - sampler->c * sampler->c / n, 0) / (n - 1) / n) / unit;
+  sampling->stallError = CONFIDENCE * sqrt(fmax(sampler->s2 - sampler->s * sampler->s / n, 0) / (n - 1) / n) / unit;
+  sampling->mispredictError = sampler->b == 0 ? 0 :
+    CONFIDENCE * sqrt(fmax(sampler->m2 - 2 * rate * sampler->mb + rate * rate * sampler->b2, 0) / (n - 1) / n) /
+    (sampler->b / n);
+}
+
+/******************************************************************/
+/* The debugging functions let a scalar pipeline run be rewound.  */
+/* Every snapshotInterval cycles the simulator snapshots all of   */
+/* its state except the register file and the data memory, whose  */
+/* writes go to an undo log instead, so the run itself copies no  */
+/* memory. simRewind undoes the writes made since the nearest     */
+/* snapshot at or before the target, restores the snapshot and    */
+/* simulates the cycles up to the target again. debugThin keeps   */
+/* at most SNAPSHOTS snapshots and about UNDOWRITES log entries,  */
+/* so a long run can be rewound less far, not use more memory.    */
+/******************************************************************/
+int debugStart(simulatorType *sim)
+{
+  sim->debug = calloc(1, sizeof(debugType));
+  if(sim->debug == NULL)
+    return -1;
+  sim->debug->tableBytes = debugTables(sim, NULL, 0);
+  sim->debug->next = sim->state->cycles;
+  return debugSnapshot(sim, sim->state);
+}
+
+void debugFree(simulatorType *sim)
+{
+  int i;
+
+  if(sim->debug == NULL)
+    return;
+  for(i = 0; i < sim->debug->count; i++)
+    free(sim->debug->snapshots[i].tables);
+  free(sim->debug->snapshots);
+  free(sim->debug->log);
+  free(sim->debug);
+  sim->debug = NULL;
+}
+
+/* Copies the predictor and cache tables to tables, or from them if   */
+/* save is 0, and returns their size. A NULL tables only sizes them.  */
+size_t debugTables(simulatorType *sim, unsigned char *tables, int save)
+{
+  predictorType *pred = &sim->predictor;
+  size_t entries = pred->mask + 1;
+  size_t ilines = (size_t)sim->icache.sets * sim->icache.ways;
+  size_t dlines = (size_t)sim->dcache.sets * sim->dcache.ways;
+  void *regions[] = {pred->counters, pred->globalCounters, pred->chooser, pred->tags, pred->targets,
+                     sim->icache.lines, sim->icache.age, sim->icache.plru,
+                     sim->dcache.lines, sim->dcache.age, sim->dcache.plru};
+  size_t bytes[] = {entries, entries, entries, entries * sizeof(int), entries * sizeof(int),
+                    ilines * sizeof(unsigned int), ilines, sim->icache.sets * sizeof(unsigned int),
+                    dlines * sizeof(unsigned int), dlines, sim->dcache.sets * sizeof(unsigned int)};
+  size_t size = 0;
+  int i;
+
+  for(i = 0; i < (int)(sizeof(bytes) / sizeof(bytes[0])); i++){
+    if(regions[i] == NULL || bytes[i] == 0)
+      continue;
+    if(tables != NULL && save)
+      memcpy(tables + size, regions[i], bytes[i]);
+    else if(tables != NULL)
+      memcpy(regions[i], tables + size, bytes[i]);
+    size += bytes[i];
+  }
+  return size;
+}
+
+/* Snapshots the simulator, given the state before the next cycle */
+int debugSnapshot(simulatorType *sim, stateType *state)
+{
+  debugType *debug = sim->debug;
+  snapshotType *snapshot;
+
+  debugThin(debug);
+  if(debug->count == debug->capacity){
+    if(growArray((void**)&debug->snapshots, debug->capacity * 2 + 16, sizeof(snapshotType), sim->error) != 0)
+      return -1;
+    debug->capacity = debug->capacity * 2 + 16;
+  }
+  snapshot = &debug->snapshots[debug->count];
+  snapshot->tables = malloc(debug->tableBytes + 1);
+  if(snapshot->tables == NULL){
+    snprintf(sim->error, ERRORLENGTH, "cannot allocate a snapshot of %zu bytes", debug->tableBytes);
+    return -1;
+  }
+  debugTables(sim, snapshot->tables, 1);
+  snapshot->state = *state;
+  snapshot->memoryStall = sim->memoryStall;
+  snapshot->stalls = sim->stalls;
+  snapshot->events = sim->events;
+  snapshot->status = sim->status;
+  memcpy(snapshot->counters, sim->counters, sizeof(sim->counters));
+  snapshot->history = sim->predictor.history;
+  snapshot->branches = sim->predictor.branches;
+  snapshot->mispredictions = sim->predictor.mispredictions;
+  snapshot->icache = sim->icache.stats;
+  snapshot->dcache = sim->dcache.stats;
+  snapshot->writes = debug->writes;
+  debug->count++;
+  debug->next = state->cycles + sim->options.snapshotInterval;
+  return 0;
+}
+
+/* Bounds the history before a snapshot is added. With SNAPSHOTS  */
+/* kept, every second one of the older half goes but the oldest,  */
+/* so the spacing doubles with each step into the past. While the */
+/* log reaches back over UNDOWRITES entries, the oldest go too,   */
+/* keeping at least one. The entries older than the oldest        */
+/* snapshot left are dropped once they make up half the log, so   */
+/* moving them is cheap.                                          */
+void debugThin(debugType *debug)
+{
+  int i, kept = 0, dropped = 0;
+
+  if(debug->count == 0)
+    return;
+  if(debug->count >= SNAPSHOTS){
+    for(i = 0; i < debug->count; i++)
+      if(i < debug->count / 2 && i % 2 == 1)
+        free(debug->snapshots[i].tables);
+      else
+        debug->snapshots[kept++] = debug->snapshots[i];
+    debug->count = kept;
+  }
+  while(debug->count - dropped > 1 && debug->writes - debug->snapshots[dropped].writes > UNDOWRITES)
+    free(debug->snapshots[dropped++].tables);
+  if(dropped > 0){
+    debug->count -= dropped;
+    memmove(debug->snapshots, debug->snapshots + dropped, debug->count * sizeof(snapshotType));
+  }
+
+  dropped = debug->snapshots[0].writes;
+  if(dropped > 0 && 2 * dropped >= debug->writes){
+    memmove(debug->log, debug->log + dropped, (debug->writes - dropped) * sizeof(writeType));
+    debug->writes -= dropped;
+    for(i = 0; i < debug->count; i++)
+      debug->snapshots[i].writes -= dropped;
+  }
+}
+
+/* Logs a write about to be made in the cycle starting from state */
+void debugWrite(simulatorType *sim, stateType *state, int kind, int index, int value)
+{
+  debugType *debug = sim->debug;
+  writeType *write;
+
+  if(debug->writes == debug->logCapacity){
+    if(growArray((void**)&debug->log, debug->logCapacity * 2 + 1024, sizeof(writeType), sim->error) != 0)
+      return;  /* the error stops the run after this cycle */
+    debug->logCapacity = debug->logCapacity * 2 + 1024;
+  }
+  write = &debug->log[debug->writes++];
+  write->cycles = state->cycles;
+  write->kind = kind;
+  write->index = index;
+  write->oldValue = kind == TRACE_REG ? state->regFile[index] : state->dataMem[index];
+  write->value = value;
+}
+
+/* The EVENT_* bits raised by the last cycle */
+int simGetEvents(simulatorType *sim)
+{
+  return sim->events;
+}
+
+/* Points writes at the register and data memory writes of the last */
+/* cycle of a debugged run and returns how many there were.         */
+int simGetWrites(simulatorType *sim, writeType **writes)
+{
+  debugType *debug = sim->debug;
+  int first;
+
+  if(debug == NULL)
+    return 0;
+  for(first = debug->writes; first > 0 && debug->log[first - 1].cycles == sim->state->cycles - 1; first--)
+    ;
+  *writes = &debug->log[first];
+  return debug->writes - first;
+}
+
+/******************************************************************/
+/* The simRewind function takes a debugged run back to the state  */
+/* it had after the given number of cycles, which must lie        */
+/* between its first cycle and the present; going forward again   */
+/* repeats the same run. It returns 0, or -1 with a message in    */
+/* error.                                                         */
+/******************************************************************/
+int simRewind(simulatorType *sim, long long cycles, char *error)
+{
+  debugType *debug = sim->debug;
+  snapshotType *snapshot;
+  writeType *write;
+  int outputMode = sim->options.outputMode;
+  int i;
+
+  if(debug == NULL){
+    snprintf(error, ERRORLENGTH, "the run keeps no snapshots to rewind to");
+    return -1;
+  }
+  if(cycles < debug->snapshots[0].state.cycles || cycles > sim->state->cycles){
+    snprintf(error, ERRORLENGTH, "cycle %lld is outside the cycles kept, %lld to %lld",
+             cycles + 1, debug->snapshots[0].state.cycles + 1, sim->state->cycles + 1);
+    return -1;
+  }
+  for(i = debug->count - 1; debug->snapshots[i].state.cycles > cycles; i--)
+    ;
+  snapshot = &debug->snapshots[i];
+
+  /* Undo the writes made since the snapshot, newest first */
+  while(debug->writes > snapshot->writes){
+    write = &debug->log[--debug->writes];
+    if(write->kind == TRACE_REG)
+      sim->state->regFile[write->index] = write->oldValue;
+    else
+      sim->state->dataMem[write->index] = write->oldValue;
+  }
+
+  debugTables(sim, snapshot->tables, 0);
+  *sim->state = snapshot->state;
+  sim->memoryStall = snapshot->memoryStall;
+  sim->stalls = snapshot->stalls;
+  sim->events = snapshot->events;
+  sim->status = snapshot->status;
+  memcpy(sim->counters, snapshot->counters, sizeof(sim->counters));
+  sim->predictor.history = snapshot->history;
+  sim->predictor.branches = snapshot->branches;
+  sim->predictor.mispredictions = snapshot->mispredictions;
+  sim->icache.stats = snapshot->icache;
+  sim->dcache.stats = snapshot->dcache;
+  sim->error[0] = '\0';
+  while(debug->count > i + 1)
+    free(debug->snapshots[--debug->count].tables);
+  debug->next = snapshot->state.cycles + sim->options.snapshotInterval;
+
+  /* Simulate up to the target without printing the cycles again */
+  sim->options.outputMode = QUIET;
+  simStep(sim, cycles - snapshot->state.cycles);
+  sim->options.outputMode = outputMode;
+  return 0;
+}
+
+/* The earliest cycle count simRewind can go back to */
+long long simRewindStart(simulatorType *sim)
+{
+  if(sim->debug == NULL)
+    return sim->state->cycles;
+  return sim->debug->snapshots[0].state.cycles;
+}
+
+/******************************************************************/
+/* The checker functions run a reference interpreter in lockstep  */
+/* with any of the pipelines (-K). Every retirement steps the     */
+/* reference by one instruction, skipping NOOPs, which do not     */
+/* retire, and compares the instruction, the value written to the */
+/* register file and, for stores, the address and data written to */
+/* memory. Stores write memory before they retire, so each engine */
+/* reports them to checkStore and they wait in a queue until the  */
+/* retirement that matches them. Every CHECKBATCH retirements (or */
+/* dataSize, if larger), and at the HALT, the whole register file */
+/* and data memory are compared too, counting the queued stores,  */
+/* which keeps the cost per retirement constant. The first        */
+/* divergence stops the simulation with the cycle and instruction */
+/* in the error; later ones are not reported.                     */
+/******************************************************************/
+int checkInit(simulatorType *sim)
+{
+  checkerType *check = calloc(1, sizeof(checkerType));
+  stateType *state = sim->state;
+
+  if(check == NULL){
+    snprintf(sim->error, ERRORLENGTH, "out of memory");
+    return -1;
+  }
+  check->state = *state;
+  if(arenaInit(&check->arena, sizeof(int) * NUMREGS + sizeof(int) * state->dataSize + 2 * 8, sim->error) != 0){
+    free(check);
+    return -1;
+  }
+  check->state.regFile = arenaAlloc(&check->arena, sizeof(int) * NUMREGS);
+  check->state.dataMem = arenaAlloc(&check->arena, sizeof(int) * state->dataSize);
+  memcpy(check->state.regFile, state->regFile, sizeof(int) * NUMREGS);
+  memcpy(check->state.dataMem, state->dataMem, sizeof(int) * state->dataSize);
+  check->nextBatch = state->dataSize > CHECKBATCH ? state->dataSize : CHECKBATCH;
+  sim->checker = check;
+  return 0;
+}
+
+void checkFree(simulatorType *sim)
+{
+  if(sim->checker == NULL)
+    return;
+  arenaFree(&sim->checker->arena);
+  free(sim->checker);
+  sim->checker = NULL;
+}
+
+/* The name of an instruction for the divergence report */
+const char *checkName(decodedType *d)
+{
+  return d->op ? opTable[d->op - 1].counter + strlen("retired.") : "noop";
+}
+
+/* Records a store writing memory ahead of its retirement */
+void checkStore(simulatorType *sim, int address, int data)
+{
+  checkerType *check = sim->checker;
+
+  if(check->storeCount == CHECKSTORES){
+    if(sim->error[0] == '\0')
+      snprintf(sim->error, ERRORLENGTH, "checker: more than %d stores wait to retire", CHECKSTORES);
+    return;
+  }
+  check->stores[(check->storeHead + check->storeCount) % CHECKSTORES].address = address;
+  check->stores[(check->storeHead + check->storeCount) % CHECKSTORES].data = data;
+  check->storeCount++;
+}
+
+/* Moves the reference past NOOPs; returns its next instruction, or NULL past the end of instrMem */
+decodedType *checkNext(checkerType *check)
+{
+  stateType *ref = &check->state;
+
+  for( ; ref->PC >= 0 && ref->PC/4 < ref->instrSize; ref->PC += 4)
+    if(ref->decodedMem[ref->PC/4 + 1].op)
+      return &ref->decodedMem[ref->PC/4 + 1];
+  return NULL;
+}
+
+/* Compares the register file and data memory, counting queued stores; returns -1 on a divergence */
+int checkState(simulatorType *sim, stateType *state, long long cycle)
+{
+  checkerType *check = sim->checker;
+  stateType *ref = &check->state;
+  int expected, i, k;
+
+  for(i = 0; i < NUMREGS; i++)
+    if(state->regFile[i] != ref->regFile[i]){
+      snprintf(sim->error, ERRORLENGTH, "cycle %lld: regFile[%d] = %d, the reference has %d",
+               cycle, i, state->regFile[i], ref->regFile[i]);
+      return -1;
+    }
+  if(check->storeCount == 0 && memcmp(state->dataMem, ref->dataMem, sizeof(int) * ref->dataSize) == 0)
+    return 0;
+  for(i = 0; i < ref->dataSize; i++){
+    expected = ref->dataMem[i];
+    for(k = 0; k < check->storeCount; k++)
+      if(check->stores[(check->storeHead + k) % CHECKSTORES].address/4 == i)
+        expected = check->stores[(check->storeHead + k) % CHECKSTORES].data;
+    if(state->dataMem[i] != expected){
+      snprintf(sim->error, ERRORLENGTH, "cycle %lld: dataMem[%d] = %d, the reference has %d",
+               cycle, i, state->dataMem[i], expected);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/******************************************************************/
+/* The checkRetire function steps the reference past the          */
+/* instruction uop retiring in the given cycle, which wrote value */
+/* to its destination register, if it has one.                    */
+/******************************************************************/
+void checkRetire(simulatorType *sim, stateType *state, long long cycle, int uop, int value)
+{
+  checkerType *check = sim->checker;
+  stateType *ref = &check->state;
+  decodedType *d = &ref->decodedMem[uop];
+  decodedType *r;
+  char ignored[ERRORLENGTH] = "";
+  int pc = (uop - 1) * 4;
+  int address, result;
+
+  if(sim->error[0] != '\0')
+    return;
+  r = checkNext(check);
+  if(r == NULL || r->opcode == HALT){
+    snprintf(sim->error, ERRORLENGTH, "cycle %lld: %s at PC %d retired after the reference %s",
+             cycle, checkName(d), pc, r == NULL ? "ran out of instructions" : "halted");
+    return;
+  }
+  if(r != d){
+    snprintf(sim->error, ERRORLENGTH, "cycle %lld: %s at PC %d retired, the reference executes %s at PC %d",
+             cycle, checkName(d), pc, checkName(r), ref->PC);
+    return;
+  }
+
+  result = aluCompute(r, ref->regFile[r->rs], ref->regFile[r->rt], ref->PC + 4);
+  if(r->flags & OP_LOAD)
+    result = ref->dataMem[dataIndex(ref, result, ignored)];
+  else if(r->flags & OP_STORE){
+    address = result;
+    ref->dataMem[dataIndex(ref, address, ignored)] = ref->regFile[r->rt];
+    if(check->storeCount == 0){
+      snprintf(sim->error, ERRORLENGTH, "cycle %lld: sw at PC %d retired without writing memory", cycle, pc);
+      return;
+    }
+    if(check->stores[check->storeHead].address != address ||
+       check->stores[check->storeHead].data != ref->regFile[r->rt]){
+      snprintf(sim->error, ERRORLENGTH, "cycle %lld: sw at PC %d wrote %d to address %d, the reference %d to %d",
+               cycle, pc, check->stores[check->storeHead].data, check->stores[check->storeHead].address,
+               ref->regFile[r->rt], address);
+      return;
+    }
+    check->storeHead = (check->storeHead + 1) % CHECKSTORES;
+    check->storeCount--;
+  }
+  if(r->dest != NOREG)
+    ref->regFile[r->dest] = result;
+  if(r->flags & OP_BRANCH)
+    ref->PC = result ? r->immed : ref->PC + 4;
+  else if(r->flags & OP_JUMP)
+    ref->PC = r->immed;
+  else if(r->flags & OP_INDIRECT)
+    ref->PC = result;
+  else
+    ref->PC += 4;
+  if(r->dest != NOREG && value != ref->regFile[r->dest]){
+    snprintf(sim->error, ERRORLENGTH, "cycle %lld: %s at PC %d wrote regFile[%d] = %d, the reference %d",
+             cycle, checkName(d), pc, r->dest, value, ref->regFile[r->dest]);
+    return;
+  }
+
+  if(++check->retired >= check->nextBatch){
+    check->nextBatch += ref->dataSize > CHECKBATCH ? ref->dataSize : CHECKBATCH;
+    checkState(sim, state, cycle);
+  }
+}
+
+/* Checks that the reference also halts here, with the same registers and memory; returns -1 if not */
+int checkHalt(simulatorType *sim, stateType *state, long long cycle)
+{
+  decodedType *r;
+
+  if(sim->error[0] != '\0')
+    return -1;
+  r = checkNext(sim->checker);
+  if(r == NULL || r->opcode != HALT){
+    if(r == NULL)
+      snprintf(sim->error, ERRORLENGTH, "cycle %lld: the pipeline halted, the reference ran out of instructions", cycle);
+    else
+      snprintf(sim->error, ERRORLENGTH, "cycle %lld: the pipeline halted, the reference executes %s at PC %d",
+               cycle, checkName(r), sim->checker->state.PC);
+    return -1;
+  }
+  return checkState(sim, state, cycle);
+}
+
+/* The name of a performance counter, or NULL for an unused one */
+const char *counterName(int counter)
+{
+  static const char *names[CTR_OPCODE] = {
+    "retired", "stalls.load_use", "bubbles.predicted_taken", "bubbles.mispredict",
+    "cycles.memory", "forward.exmem", "forward.memwb", "forward.writeback",
+    "branches", "branches.taken", "branches.mispredicted", "branches.missed_taken",
+    "slots.dependency", "slots.structural", "slots.rob_full", "slots.rs_full", "slots.lsq_full",
+    "forward.store_to_load", "stalls.unit_busy", "coherence.bus_reads", "coherence.bus_read_exclusives",
+    "coherence.upgrades", "coherence.invalidations", "coherence.interventions", "coherence.sharing_misses"
+  };
+
+  if(counter < 0 || counter >= NUMCOUNTERS)
+    return NULL;
+  if(counter < CTR_OPCODE)
+    return names[counter];
+  if(counter - CTR_OPCODE >= 0 && counter - CTR_OPCODE < OPCOUNT)
+    return opTable[counter - CTR_OPCODE].counter;
+  return NULL;
+}
+
+/* Runs until the simulation stops and returns the status */
+int simRun(simulatorType *sim)
+{
+  return simStep(sim, -1);
+}
+
+/* Fills in the statistics gathered so far */
+void simGetResults(simulatorType *sim, resultsType *results)
+{
+  memset(results, 0, sizeof(resultsType));
+  results->cycles = sim->state->cycles;
+  results->stalls = sim->stalls;
+  results->branches = sim->predictor.branches;
+  results->mispredictions = sim->predictor.mispredictions;
+  results->predictorKind = sim->predictor.kind;
+  results->predictorSize = sim->predictor.mask + 1;
+  results->instructions = sim->skipped;
+  results->functional = sim->functional;
+  results->checkpointed = sim->status == SIM_CHECKPOINTED;
+  results->memoryStalls = sim->counters[CTR_MEMORY];
+  results->width = sim->options.width;
+  results->outOfOrder = sim->options.outOfOrder;
+  results->depth = pipelineDepth(&sim->options);
+  memcpy(results->counters, sim->counters, sizeof(sim->counters));
+  results->icache = sim->icache.stats;
+  results->dcache = sim->dcache.stats;
+  results->cores = 1;
+  if(sim->sampler != NULL)
+    sampleResults(sim->sampler, &sim->options, &results->sampling);
+  if(sim->multicore != NULL)
+    multicoreResults(sim->multicore, results);
+}
+
+/* The state before the next cycle: PC, latches, register file and memories. */
+/* It stays owned by the simulator and changes with every step. Of a         */
+/* multicore run it only holds the shared data memory and the cycles.        */
+stateType *simGetState(simulatorType *sim)
+{
+  return sim->state;
+}
+
+int simGetStatus(simulatorType *sim)
+{
+  return sim->status;
+}
+
+const char *simGetError(simulatorType *sim)
+{
+  return sim->error;
+}
+
+void simDestroy(simulatorType *sim)
+{
+  if(sim == NULL)
+    return;
+  predictorFree(&sim->predictor);
+  cacheFree(&sim->icache);
+  cacheFree(&sim->dcache);
+  coreFree(&sim->core);
+  checkFree(sim);
+  multicoreFree(sim->multicore);
+  free(sim->sampler);
+  debugFree(sim);
+  if(sim->trace != NULL)
+    fclose(sim->trace);
+  arenaFree(&sim->arena);
+  free(sim);
+}
+
+/******************************************************************/
+/* The assembler reads the whole program text in a single pass.   */
+/* Each line holds an instruction, a .fill directive with a comma */
+/* separated list of data words, a # comment or nothing, and may  */
+/* start with a label. Errors name the line and what was expected */
+/* there.                                                         */
+/*   label: ...          the address of the line's instruction,   */
+/*                       or of its first .fill word               */
+/*   add $rd,$rs,$rt     also sub, and, or, xor, nor, slt, mul,   */
+/*                       div                                      */
+/*   sll $rd,$rt,shamt   also srl, sra                            */
+/*   sllv $rd,$rt,$rs    also srlv, srav                          */
+/*   addi $rt,$rs,immed  also slti (signed), andi, ori, xori      */
+/*   lw $rt,immed($rs)   sw $rt,immed($rs)                        */
+/*   bne $rs,$rt,immed   beq $rs,$rt,immed                        */
+/*   j immed   jal immed   jr $rs   halt   noop                   */
+/* An immediate may name a label, resolved once the whole program */
+/* has been read.                                                 */
+/******************************************************************/
+
+/* Operand formats of the mnemonics */
+#define FMT_R 0            /* $rd,$rs,$rt */
+#define FMT_MEM 1          /* $rt,immed($rs) */
+#define FMT_BRANCH 2       /* $rs,$rt,immed */
+#define FMT_NONE 3         /* nothing, or one ignored number */
+#define FMT_SHIFT 4        /* $rd,$rt,shamt */
+#define FMT_SHIFTV 5       /* $rd,$rt,$rs */
+#define FMT_IMMED 6        /* $rt,$rs,immed, 0 to 65535 */
+#define FMT_SIMMED 7       /* $rt,$rs,immed, -32768 to 32767 */
+#define FMT_JUMP 8         /* immed */
+#define FMT_REG 9          /* $rs */
+
+typedef struct mnemonicStruct {
+  char *name;
+  int opcode;
+  int funct;
+  int format;                             /* FMT_* */
+} mnemonicType;
+
+/* Mnemonics sit in the slot given by mnemonicHash, which is a perfect */
+/* hash for this set; a new mnemonic must land in a free slot, or the  */
+/* multiplier must change.                                             */
+#define MNEMONICS 64
+mnemonicType mnemonicTable[MNEMONICS] = {
+  [2] = {"jal", JAL, 0, FMT_JUMP},
+  [3] = {"sub", R, SUB, FMT_R},
+  [4] = {"sw", SW, 0, FMT_MEM},
+  [5] = {"and", R, AND, FMT_R},
+  [12] = {"jr", R, JR, FMT_REG},
+  [13] = {"xor", R, XOR, FMT_R},
+  [14] = {"sll", R, SLL, FMT_SHIFT},
+  [15] = {"srav", R, SRAV, FMT_SHIFTV},
+  [16] = {"slt", R, SLT, FMT_R},
+  [19] = {"xori", XORI, 0, FMT_IMMED},
+  [25] = {"sllv", R, SLLV, FMT_SHIFTV},
+  [26] = {"j", J, 0, FMT_JUMP},
+  [28] = {"slti", SLTI, 0, FMT_SIMMED},
+  [30] = {"add", R, ADD, FMT_R},
+  [31] = {"noop", R, 0, FMT_NONE},
+  [37] = {"addi", ADDI, 0, FMT_SIMMED},
+  [38] = {"halt", HALT, 0, FMT_NONE},
+  [39] = {"srlv", R, SRLV, FMT_SHIFTV},
+  [40] = {"bne", BNE, 0, FMT_BRANCH},
+  [41] = {"ori", ORI, 0, FMT_IMMED},
+  [46] = {"lw", LW, 0, FMT_MEM},
+  [48] = {"sra", R, SRA, FMT_SHIFT},
+  [51] = {"srl", R, SRL, FMT_SHIFT},
+  [52] = {"beq", BEQ, 0, FMT_BRANCH},
+  [55] = {"nor", R, NOR, FMT_R},
+  [56] = {"mul", R, MUL, FMT_R},
+  [59] = {"andi", ANDI, 0, FMT_IMMED},
+  [61] = {"div", R, DIV, FMT_R},
+  [63] = {"or", R, OR, FMT_R},
+};
+
+unsigned int mnemonicHash(const char *name, int length)
+{
+    unsigned int hash = 0;
+    int i;
+
+    for(i = 0; i < length; i++)
+        hash = hash * 195 + name[i];
+    return (hash >> 2) & (MNEMONICS - 1);
+}
+
+/* An immediate that names a label not resolved yet */
+typedef struct fixupStruct {
+  int index;                              /* instrMem index of the instruction */
+  int line;                               /* Where the label was used */
+  const char *name;                       /* The label, in the program text */
+  int length;
+  int high;                               /* Largest address the immediate can hold */
+} fixupType;
+
+typedef struct lexerStruct {
+  const char *p;                          /* Next character */
+  const char *end;                        /* End of the text */
+  int line;                               /* Line number of p, from 1 */
+  char *error;                            /* Message buffer, set on the first error */
+  const char *symbol;                     /* Label named by the last immediate, or NULL */
+  int symbolLength;
+  int symbolHigh;                         /* Largest value that immediate can take */
+} lexerType;
+
+int isIdentifier(char c, int first)
+{
+    return ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_' || (!first && c >= '0' && c <= '9');
+}
+
+void lexSpace(lexerType *lex)
+{
+    while(lex->p < lex->end && (*lex->p == ' ' || *lex->p == '\t' || *lex->p == '\r'))
+        lex->p++;
+}
+
+/* Records an error at the current line and returns -1 */
+int lexError(lexerType *lex, const char *expected)
+{
+    int length = 0;
+
+    while(lex->p + length < lex->end && length < 20 && lex->p[length] != '\n')
+        length++;
+    if(length == 0)
+        snprintf(lex->error, ERRORLENGTH, "line %d: expected %s at end of line", lex->line, expected);
+    else
+        snprintf(lex->error, ERRORLENGTH, "line %d: expected %s at '%.*s'", lex->line, expected, length, lex->p);
+    return -1;
+}
+
+int lexChar(lexerType *lex, char c)
+{
+    char expected[4] = {'\'', c, '\'', '\0'};
+
+    lexSpace(lex);
+    if(lex->p >= lex->end || *lex->p != c)
+        return lexError(lex, expected);
+    lex->p++;
+    return 0;
+}
+
+/* Reads a decimal or 0x hexadecimal number between low and high */
+int lexNumber(lexerType *lex, long long low, long long high, int *value)
+{
+    long long number = 0;
+    int negative = 0, digits = 0, base = 10, digit;
+    const char *start;
+
+    lexSpace(lex);
+    start = lex->p;
+    if(lex->p < lex->end && (*lex->p == '-' || *lex->p == '+'))
+        negative = *lex->p++ == '-';
+    if(lex->end - lex->p > 2 && lex->p[0] == '0' && (lex->p[1] == 'x' || lex->p[1] == 'X')){
+        base = 16;
+        lex->p += 2;
+    }
+    for( ; lex->p < lex->end; lex->p++, digits++){
+        if(*lex->p >= '0' && *lex->p <= '9')
+            digit = *lex->p - '0';
+        else if(base == 16 && (*lex->p | 0x20) >= 'a' && (*lex->p | 0x20) <= 'f')
+            digit = (*lex->p | 0x20) - 'a' + 10;
+        else
+            break;
+        if(number <= high - low)
+            number = number * base + digit;  /* stops growing once out of range */
+    }
+    if(digits == 0)
+        return lexError(lex, "a number");
+    if(negative)
+        number = -number;
+    if(number < low || number > high){
+        snprintf(lex->error, ERRORLENGTH, "line %d: %.*s is outside %lld to %lld",
+                 lex->line, (int)(lex->p - start), start, low, high);
+        return -1;
+    }
+    *value = number;
+    return 0;
+}
+
+int lexRegister(lexerType *lex, int *reg)
+{
+    lexSpace(lex);
+    if(lex->p < lex->end && *lex->p == '$')
+        lex->p++;  /* optional, as the baseline loader took bare numbers */
+    else if(lex->p >= lex->end || *lex->p < '0' || *lex->p > '9')
+        return lexError(lex, "a register");
+    return lexNumber(lex, 0, NUMREGS - 1, reg);
+}
+
+/* Reads a number between low and high or a label, left for a fixup */
+int lexImmediate(lexerType *lex, long long low, long long high, int *value)
+{
+    lexSpace(lex);
+    lex->symbol = NULL;
+    if(lex->p < lex->end && isIdentifier(*lex->p, 1)){
+        lex->symbol = lex->p;
+        while(lex->p < lex->end && isIdentifier(*lex->p, 0))
+            lex->p++;
+        lex->symbolLength = lex->p - lex->symbol;
+        lex->symbolHigh = high;
+        *value = 0;
+        return 0;
+    }
+    return lexNumber(lex, low, high, value);
+}
+
+/* Parses the operands of one instruction and encodes it */
+int lexInstruction(lexerType *lex, mnemonicType *mnemonic, unsigned int *instruction)
+{
+    int rs = 0, rt = 0, rd = 0, shamt = 0, immed = 0;
+    long long low;
+
+    lex->symbol = NULL;
+    switch(mnemonic->format){
+    case FMT_R:
+        if(lexRegister(lex, &rd) || lexChar(lex, ',') || lexRegister(lex, &rs) ||
+           lexChar(lex, ',') || lexRegister(lex, &rt))
+            return -1;
+        break;
+    case FMT_MEM:
+        if(lexRegister(lex, &rt) || lexChar(lex, ',') || lexImmediate(lex, 0, 0xffff, &immed) ||
+           lexChar(lex, '(') || lexRegister(lex, &rs) || lexChar(lex, ')'))
+            return -1;
+        break;
+    case FMT_BRANCH:
+        if(lexRegister(lex, &rs) || lexChar(lex, ',') || lexRegister(lex, &rt) ||
+           lexChar(lex, ',') || lexImmediate(lex, 0, 0xffff, &immed))
+            return -1;
+        break;
+    case FMT_SHIFT:
+        if(lexRegister(lex, &rd) || lexChar(lex, ',') || lexRegister(lex, &rt) ||
+           lexChar(lex, ',') || lexNumber(lex, 0, 31, &shamt))
+            return -1;
+        break;
+    case FMT_SHIFTV:
+        if(lexRegister(lex, &rd) || lexChar(lex, ',') || lexRegister(lex, &rt) ||
+           lexChar(lex, ',') || lexRegister(lex, &rs))
+            return -1;
+        break;
+    case FMT_IMMED:
+    case FMT_SIMMED:
+        low = mnemonic->format == FMT_SIMMED ? -0x8000 : 0;
+        if(lexRegister(lex, &rt) || lexChar(lex, ',') || lexRegister(lex, &rs) ||
+           lexChar(lex, ',') || lexImmediate(lex, low, low + 0xffff, &immed))
+            return -1;
+        immed &= 0xffff;
+        break;
+    case FMT_JUMP:
+        if(lexImmediate(lex, 0, 0xffff, &immed))
+            return -1;
+        break;
+    case FMT_REG:
+        if(lexRegister(lex, &rs))
+            return -1;
+        break;
+    case FMT_NONE:
+        lexSpace(lex);
+        if(lex->p < lex->end && *lex->p != '\n' && *lex->p != '#' && lexNumber(lex, -0x7fffffffLL - 1, 0x7fffffff, &immed))
+            return -1;
+        if(mnemonic->opcode == R){
+            *instruction = 0;
+            return 0;
+        }
+        immed = 0;
+        break;
+    }
+    *instruction = ((unsigned int)mnemonic->opcode << 26) | (rs << 21) | (rt << 16) | (rd << 11) |
+                   (shamt << 6) | mnemonic->funct | immed;
+    return 0;
+}
+
+/* Labels are found through an open-addressed table of slots, each */
+/* holding an index into program->symbols plus one, or 0 if free.  */
+/* It is kept at most half full, so probes stay short.             */
+unsigned int symbolHash(const char *name, int length)
+{
+    unsigned int hash = 2166136261u;
+    int i;
+
+    for(i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    return hash;
+}
+
+/* Returns the slot holding the label, or the free slot it would take */
+int *symbolSlot(programType *program, int *slots, int size, const char *name, int length)
+{
+    unsigned int i = symbolHash(name, length) & (size - 1);
+    symbolType *symbol;
+
+    while(slots[i] != 0){
+        symbol = &program->symbols[slots[i] - 1];
+        if(strncmp(symbol->name, name, length) == 0 && symbol->name[length] == '\0')
+            break;
+        i = (i + 1) & (size - 1);
+    }
+    return &slots[i];
+}
+
+/* Doubles the table and inserts every symbol again */
+int symbolGrow(programType *program, int **slots, int *size, char *error)
+{
+    int grown = *size ? 2 * *size : 64;
+    int *table = calloc(grown, sizeof(int));
+    int i;
+
+    if(table == NULL){
+        snprintf(error, ERRORLENGTH, "cannot allocate a table of %d labels", grown);
+        return -1;
+    }
+    for(i = 0; i < program->symbolCount; i++)
+        *symbolSlot(program, table, grown, program->symbols[i].name, strlen(program->symbols[i].name)) = i + 1;
+    free(*slots);
+    *slots = table;
+    *size = grown;
+    return 0;
+}
+
+/******************************************************************/
+/* The assemble function parses program text of the given size    */
+/* into the instruction memory, its decoded form and the initial  */
+/* data memory, with the sizes given in the options. It returns   */
+/* 0, or -1 with a message in error.                              */
+/******************************************************************/
+int assemble(programType *program, optionsType *options, const char *text, size_t size, char *error)
+{
+    lexerType lex;
+    mnemonicType *mnemonic;
+    fixupType *fixups = NULL, *fixup;
+    const char *word, *label;
+    unsigned int instruction;
+    int *slots = NULL, *slot;
+    int data_index = 0;
+    int inst_index = 0;
+    int fixupCount = 0, capacity = 0, symbolCapacity = 0, slotCount = 0;
+    int length, labelLength, value, i;
+
+    program->instrSize = options->instrSize;
+    program->dataSize = options->dataSize;
+    program->instrMem = calloc(program->instrSize, sizeof(unsigned int));
+    program->decodedMem = calloc(program->instrSize + 1, sizeof(decodedType));
+    program->dataMem = calloc(program->dataSize, sizeof(int));
+    if(program->instrMem == NULL || program->decodedMem == NULL || program->dataMem == NULL){
+        free(program->instrMem);
+        free(program->decodedMem);
+        free(program->dataMem);
+        snprintf(error, ERRORLENGTH, "cannot allocate program memory");
+        return -1;
+    }
+    for(inst_index = 0; inst_index <= program->instrSize; inst_index++)
+        decodeInstr(0, &program->decodedMem[inst_index]);  /* NOOPs */
+    inst_index = 0;
+    program->symbols = NULL;
+    program->symbolCount = 0;
+    program->image = NULL;
+
+    lex.p = text;
+    lex.end = text + size;
+    lex.line = 1;
+    lex.error = error;
+    while(lex.p < lex.end){
+        lexSpace(&lex);
+        word = lex.p;
+        while(lex.p < lex.end && isIdentifier(*lex.p, lex.p == word))
+            lex.p++;
+        length = lex.p - word;
+
+        label = NULL;
+        labelLength = 0;
+        if(length > 0 && lex.p < lex.end && *lex.p == ':'){
+            label = word;
+            labelLength = length;
+            if(labelLength >= SYMBOLLENGTH){
+                snprintf(error, ERRORLENGTH, "line %d: label '%.*s' is longer than %d characters",
+                         lex.line, labelLength, label, SYMBOLLENGTH - 1);
+                goto fail;
+            }
+            lex.p++;
+            lexSpace(&lex);
+            word = lex.p;
+            while(lex.p < lex.end && isIdentifier(*lex.p, lex.p == word))
+                lex.p++;
+            length = lex.p - word;
+        }
+        if(label != NULL){
+            if(2 * (program->symbolCount + 1) > slotCount && symbolGrow(program, &slots, &slotCount, error) != 0)
+                goto fail;
+            slot = symbolSlot(program, slots, slotCount, label, labelLength);
+            if(*slot != 0){
+                snprintf(error, ERRORLENGTH, "line %d: label '%.*s' is already defined",
+                         lex.line, labelLength, label);
+                goto fail;
+            }
+            if(program->symbolCount == symbolCapacity){
+                symbolCapacity = symbolCapacity ? 2 * symbolCapacity : 16;
+                if(growArray((void**)&program->symbols, symbolCapacity, sizeof(symbolType), error) != 0)
+                    goto fail;
+            }
+            memset(program->symbols[program->symbolCount].name, 0, SYMBOLLENGTH);  /* Images hold no stale bytes */
+            memcpy(program->symbols[program->symbolCount].name, label, labelLength);
+            program->symbols[program->symbolCount].address =
+                4 * (length == 0 && lex.p < lex.end && *lex.p == '.' ? data_index : inst_index);
+            *slot = ++program->symbolCount;
+        }
+
+        if(length == 0 && lex.p < lex.end && *lex.p == '.'){
+            /* Data directive */
+            lex.p++;
+            if(lex.end - lex.p < 4 || memcmp(lex.p, "fill", 4) != 0){
+                lexError(&lex, ".fill");
+                goto fail;
+            }
+            lex.p += 4;
+            do{
+                if(lexNumber(&lex, -0x7fffffffLL - 1, 0xffffffffLL, &value) != 0)
+                    goto fail;
+                if(data_index >= program->dataSize){
+                    snprintf(error, ERRORLENGTH, "line %d: data does not fit in %d words of data memory (use -d)",
+                             lex.line, program->dataSize);
+                    goto fail;
+                }
+                program->dataMem[data_index++] = value;
+                lexSpace(&lex);
+            } while(lex.p < lex.end && *lex.p == ',' && lex.p++);
+        }
+        else if(length > 0){
+            mnemonic = &mnemonicTable[mnemonicHash(word, length)];
+            if(mnemonic->name == NULL || strlen(mnemonic->name) != (size_t)length ||
+               memcmp(mnemonic->name, word, length) != 0){
+                snprintf(error, ERRORLENGTH, "line %d: unknown instruction '%.*s'", lex.line, length, word);
+                goto fail;
+            }
+            if(inst_index >= program->instrSize){
+                snprintf(error, ERRORLENGTH, "line %d: program does not fit in %d words of instruction memory (use -i)",
+                         lex.line, program->instrSize);
+                goto fail;
+            }
+            if(lexInstruction(&lex, mnemonic, &instruction) != 0)
+                goto fail;
+            if(lex.symbol != NULL){
+                if(fixupCount == capacity){
+                    capacity = capacity ? 2 * capacity : 16;
+                    if(growArray((void**)&fixups, capacity, sizeof(fixupType), error) != 0)
+                        goto fail;
+                }
+                fixups[fixupCount].index = inst_index;
+                fixups[fixupCount].line = lex.line;
+                fixups[fixupCount].name = lex.symbol;
+                fixups[fixupCount].length = lex.symbolLength;
+                fixups[fixupCount].high = lex.symbolHigh;
+                fixupCount++;
+            }
+            program->instrMem[inst_index] = instruction;
+            decodeInstr(instruction, &program->decodedMem[inst_index + 1]);
+            inst_index++;
+        }
+
+        /* Only a comment may follow */
+        lexSpace(&lex);
+        if(lex.p < lex.end && *lex.p == '#')
+            while(lex.p < lex.end && *lex.p != '\n')
+                lex.p++;
+        if(lex.p < lex.end && *lex.p != '\n'){
+            lexError(&lex, length > 0 ? "the end of the instruction" : "an instruction");
+            goto fail;
+        }
+        lex.p++;
+        lex.line++;
+    }
+
+    /* Resolve labels used before they were defined */
+    for(fixup = fixups; fixup < fixups + fixupCount; fixup++){
+        slot = slotCount ? symbolSlot(program, slots, slotCount, fixup->name, fixup->length) : NULL;
+        if(slot == NULL || *slot == 0){
+            snprintf(error, ERRORLENGTH, "line %d: undefined label '%.*s'", fixup->line, fixup->length, fixup->name);
+            goto fail;
+        }
+        i = *slot - 1;
+        if(program->symbols[i].address > fixup->high){
+            snprintf(error, ERRORLENGTH, "line %d: label '%.*s' is at address %d, beyond an immediate",
+                     fixup->line, fixup->length, fixup->name, program->symbols[i].address);
+            goto fail;
+        }
+        program->instrMem[fixup->index] |= program->symbols[i].address;
+        decodeInstr(program->instrMem[fixup->index], &program->decodedMem[fixup->index + 1]);
+    }
+    free(fixups);
+    free(slots);
+    return 0;
+
+fail:
+    free(fixups);
+    free(slots);
+    freeProgram(program);
+    return -1;
+}
+
+/* Resizes a growing array, or returns -1 with a message in error */
+int growArray(void **array, int count, size_t size, char *error)
+{
+    void *grown = realloc(*array, count * size);
+
+    if(grown == NULL){
+        snprintf(error, ERRORLENGTH, "cannot allocate %d entries of %zu bytes", count, size);
+        return -1;
+    }
+    *array = grown;
+    return 0;
+}
+
+/******************************************************************/
+/* The loadProgram function assembles a program from a file. A    */
+/* regular file is memory-mapped, anything else is read in large  */
+/* blocks. A program image written by writeImage is used as it    */
+/* is, without assembling. It returns 0, or -1 with a message in  */
+/* error.                                                         */
+/******************************************************************/
+int loadProgram(programType *program, optionsType *options, FILE *input, char *error)
+{
+    struct stat info;
+    char *text = NULL, *grown;
+    size_t size = 0, capacity = 0, got;
+    int fd = fileno(input);
+    int status;
+
+    if(fd >= 0 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+       lseek(fd, 0, SEEK_CUR) == 0){
+        text = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if(text != MAP_FAILED){
+            if((size_t)info.st_size >= sizeof(imageType) && memcmp(text, IMAGEMAGIC, 8) == 0)
+                return loadImage(program, text, info.st_size, 1, 0, error);
+            status = loadSource(program, options, text, info.st_size, error);
+            munmap(text, info.st_size);
+            return status;
+        }
+        text = NULL;
+    }
+
+    do{
+        if(size == capacity){
+            capacity = capacity ? 2 * capacity : 1 << 16;
+            grown = realloc(text, capacity);
+            if(grown == NULL){
+                free(text);
+                snprintf(error, ERRORLENGTH, "program text does not fit in memory");
+                return -1;
+            }
+            text = grown;
+        }
+        got = fread(text + size, 1, capacity - size, input);
+        size += got;
+    } while(got > 0);
+    if(ferror(input)){
+        free(text);
+        snprintf(error, ERRORLENGTH, "cannot read the program text");
+        return -1;
+    }
+    if(size >= sizeof(imageType) && memcmp(text, IMAGEMAGIC, 8) == 0)
+        return loadImage(program, text, size, 0, 0, error);
+    status = loadSource(program, options, text, size, error);
+    free(text);
+    return status;
+}
+
+/******************************************************************/
+/* The loadSource function assembles program text, going through  */
+/* the image cache when options->imageCache names a directory.    */
+/* Images there are named by a hash of the text and the memory    */
+/* sizes, so an unchanged program skips the assembler. A missing  */
+/* or stale image is rebuilt; failing to store it is not an error. */
+/******************************************************************/
+int loadSource(programType *program, optionsType *options, const char *text, size_t size, char *error)
+{
+    char name[4096], ignored[ERRORLENGTH];
+    unsigned long long hash;
+    struct stat info;
+    char *image;
+    int fd;
+
+    if(options->imageCache == NULL)
+        return assemble(program, options, text, size, error);
+
+    hash = sourceHash(options, text, size);
+    snprintf(name, sizeof(name), "%s/%016llx.img", options->imageCache, hash);
+    fd = open(name, O_RDONLY);
+    if(fd >= 0){
+        if(fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(imageType)){
+            image = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if(image != MAP_FAILED && loadImage(program, image, info.st_size, 1, hash, error) == 0){
+                close(fd);
+                return 0;
+            }
+        }
+        close(fd);
+    }
+
+    if(assemble(program, options, text, size, error) != 0)
+        return -1;
+    writeImage(program, name, hash, ignored);  /* The cache is best effort */
+    return 0;
+}
+
+/* FNV-1a over the program text and the memory sizes it was assembled for */
+unsigned long long sourceHash(optionsType *options, const char *text, size_t size)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    int sizes[2] = {options->instrSize, options->dataSize};
+    size_t i;
+
+    for(i = 0; i < size; i++)
+        hash = (hash ^ (unsigned char)text[i]) * 0x100000001b3ULL;
+    for(i = 0; i < sizeof(sizes); i++)
+        hash = (hash ^ ((unsigned char*)sizes)[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+/******************************************************************/
+/* The loadImage function points program at the sections of an    */
+/* image held in memory, which the program then owns: mapped is 1 */
+/* for a mapping and 0 for a malloc'ed buffer. A nonzero hash     */
+/* must match the one the image was written with. decodedMem is   */
+/* decoded again from instrMem rather than trusted, so a mapping  */
+/* must be private and writable. On failure the image is released */
+/* and -1 returned with a message in error.                       */
+/******************************************************************/
+int loadImage(programType *program, char *image, size_t size, int mapped, unsigned long long hash, char *error)
+{
+    imageType *header = (imageType*)image;
+    size_t instrBytes, decodedBytes, dataBytes;
+
+    if(memcmp(header->magic, IMAGEMAGIC, 8) != 0 || header->version != IMAGEVERSION ||
+       header->decodedBytes != sizeof(decodedType)){
+        snprintf(error, ERRORLENGTH, "program image was written by a different build of the simulator");
+        goto fail;
+    }
+    if(hash != 0 && header->sourceHash != hash){
+        snprintf(error, ERRORLENGTH, "program image is stale");
+        goto fail;
+    }
+    if(header->instrSize <= 0 || header->dataSize <= 0 || header->symbolCount < 0){
+        snprintf(error, ERRORLENGTH, "program image is corrupt");
+        goto fail;
+    }
+    instrBytes = checkpointSection(sizeof(unsigned int) * header->instrSize);
+    decodedBytes = checkpointSection(sizeof(decodedType) * (header->instrSize + 1));
+    dataBytes = checkpointSection(sizeof(int) * header->dataSize);
+    if(size != sizeof(imageType) + instrBytes + decodedBytes + dataBytes +
+               checkpointSection(sizeof(symbolType) * header->symbolCount)){
+        snprintf(error, ERRORLENGTH, "program image is truncated");
+        goto fail;
+    }
+    if(decodeProgram((unsigned int*)(image + sizeof(imageType)),
+                     (decodedType*)(image + sizeof(imageType) + instrBytes), header->instrSize) != 0){
+        snprintf(error, ERRORLENGTH, "program image is corrupt");
+        goto fail;
+    }
+
+    program->instrSize = header->instrSize;
+    program->dataSize = header->dataSize;
+    program->symbolCount = header->symbolCount;
+    program->instrMem = (unsigned int*)(image + sizeof(imageType));
+    program->decodedMem = (decodedType*)((char*)program->instrMem + instrBytes);
+    program->dataMem = (int*)((char*)program->decodedMem + decodedBytes);
+    program->symbols = (symbolType*)((char*)program->dataMem + dataBytes);
+    program->image = image;
+    program->imageSize = size;
+    program->imageMapped = mapped;
+    return 0;
+
+fail:
+    if(mapped)
+        munmap(image, size);
+    else
+        free(image);
+    return -1;
+}
+
+/******************************************************************/
+/* The writeImage function saves an assembled program as an image */
+/* that loadProgram maps and runs without assembling. hash is     */
+/* stored for the image cache and may be 0. The image is written  */
+/* under a temporary name and renamed, so readers never see part  */
+/* of one. It returns 0, or -1 with a message in error.           */
+/******************************************************************/
+int writeImage(programType *program, char *name, unsigned long long hash, char *error)
+{
+    imageType header;
+    char temp[4096];
+    int failed = 0;
+    int fd;
+    FILE *file;
+
+    snprintf(temp, sizeof(temp), "%s.XXXXXX", name);
+    fd = mkstemp(temp);
+    if(fd < 0 || (file = fdopen(fd, "wb")) == NULL){
+        if(fd >= 0)
+            close(fd);
+        snprintf(error, ERRORLENGTH, "cannot create program image %s", name);
+        return -1;
+    }
+    fchmod(fd, 0644);
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGEMAGIC, 8);
+    header.version = IMAGEVERSION;
+    header.decodedBytes = sizeof(decodedType);
+    header.instrSize = program->instrSize;
+    header.dataSize = program->dataSize;
+    header.symbolCount = program->symbolCount;
+    header.sourceHash = hash;
+
+    failed |= checkpointWrite(file, &header, sizeof(header));
+    failed |= checkpointWrite(file, program->instrMem, sizeof(unsigned int) * program->instrSize);
+    failed |= checkpointWrite(file, program->decodedMem, sizeof(decodedType) * (program->instrSize + 1));
+    failed |= checkpointWrite(file, program->dataMem, sizeof(int) * program->dataSize);
+    failed |= checkpointWrite(file, program->symbols, sizeof(symbolType) * program->symbolCount);
+    failed |= fclose(file) != 0;
+    if(failed || rename(temp, name) != 0){
+        unlink(temp);
+        snprintf(error, ERRORLENGTH, "cannot write program image %s", name);
+        return -1;
+    }
+    return 0;
+}
+
+/* Loads a program held in a string, for callers that embed the simulator */
+int loadProgramString(programType *program, optionsType *options, const char *text, char *error)
+{
+    return loadSource(program, options, text, strlen(text), error);
+}
+
+void freeProgram(programType *program)
+{
+    if(program->image == NULL){
+        free(program->instrMem);
+        free(program->decodedMem);
+        free(program->dataMem);
+        free(program->symbols);
+    }
+    else if(program->imageMapped)
+        munmap(program->image, program->imageSize);
+    else
+        free(program->image);
+    memset(program, 0, sizeof(programType));
+}
+
+/******************************************************************/
+/* The initState function accepts a pointer to the current        */
+/* state as an argument, initializing the state to pre-execution  */
+/* state. In particular, all registers are zero'd out. All        */
+/* instructions in the pipeline are NOOPS. The instruction memory */
+/* is shared with the program; the register file and a private    */
+/* copy of the initial data memory are carved out of the arena.   */
+/* It returns -1 if they cannot be allocated.                     */
+/*****************************************************************/
+int initState(stateType *statePtr, arenaType *arena, programType *program, char *error)
+{
+    statePtr->PC = 0;
+    statePtr->cycles = 0;
+    statePtr->instrSize = program->instrSize;
+    statePtr->dataSize = program->dataSize;
+    statePtr->instrMem = program->instrMem;
+    statePtr->decodedMem = program->decodedMem;
+
+    if(arenaInit(arena, sizeof(int) * NUMREGS + sizeof(int) * program->dataSize + 2 * 8, error) != 0)
+        return -1;
+    statePtr->regFile = arenaAlloc(arena, sizeof(int) * NUMREGS);
+    statePtr->dataMem = arenaAlloc(arena, sizeof(int) * program->dataSize);
+
+    memset(statePtr->regFile, 0, 4*NUMREGS);
+    memcpy(statePtr->dataMem, program->dataMem, sizeof(int) * program->dataSize);
+
+    /* Zero-out all registers in pipeline to start */
+    statePtr->IFID.instr = 0;
+    statePtr->IFID.uop = 0;
+    statePtr->IFID.PCPlus4 = 0;
+    statePtr->IFID.bpb = 0;
+    statePtr->IDEX.instr = 0;
+    statePtr->IDEX.uop = 0;
+    statePtr->IDEX.PCPlus4 = 0;
+    statePtr->IDEX.branchTarget = 0;
+    statePtr->IDEX.readData1 = 0;
+    statePtr->IDEX.readData2 = 0;
+    statePtr->IDEX.immed = 0;
+    statePtr->IDEX.rsReg = 0;
+    statePtr->IDEX.rtReg = 0;
+    statePtr->IDEX.rdReg = 0;
+    statePtr->IDEX.bpb = 0;
+    statePtr->IDEX.busy = 0;
+
+    statePtr->EXMEM.instr = 0;
+    statePtr->EXMEM.uop = 0;
+    statePtr->EXMEM.aluResult = 0;
+    statePtr->EXMEM.writeDataReg = 0;
+    statePtr->EXMEM.writeReg = 0;
+    statePtr->EXMEM.bpb = 0;
+
+    statePtr->MEMWB.instr = 0;
+    statePtr->MEMWB.uop = 0;
+    statePtr->MEMWB.writeDataMem = 0;
+    statePtr->MEMWB.writeDataALU = 0;
+    statePtr->MEMWB.writeReg = 0;
+    statePtr->MEMWB.bpb = 0;
+    return 0;
+ }
+
+void defaultOptions(optionsType *options)
+{
+    options->outputMode = VERBOSE;
+    options->dumpInterval = 1;
+    options->dumpEvents = 0;
+    options->instrSize = NUMMEMORY;
+    options->dataSize = NUMMEMORY;
+    options->predictorKind = PRED_GLOBAL;
+    options->predictorSize = PREDTABLESIZE;
+    options->historyBits = HISTORYBITS;
+    options->functional = 0;
+    options->fastForward = -1;
+    options->marker = -1;
+    options->checkpointFile = NULL;
+    options->checkpointCycle = 0;
+    options->restoreFile = NULL;
+    options->sweepFile = NULL;
+    options->threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(options->threads < 1)
+        options->threads = 1;
+    options->icacheSize = 0;
+    options->icacheWays = 1;
+    options->icacheLine = 16;
+    options->dcacheSize = 0;
+    options->dcacheWays = 1;
+    options->dcacheLine = 16;
+    options->missLatency = MISSLATENCY;
+    options->replacement = CACHE_LRU;
+    options->writePolicy = WRITEBACK;
+    options->countersFile = NULL;
+    options->traceFile = NULL;
+    options->imageCache = NULL;
+    options->imageFile = NULL;
+    options->width = 1;
+    options->readPorts = 0;
+    options->writePorts = 0;
+    options->memoryPorts = 0;
+    options->outOfOrder = 0;
+    options->robSize = ROBSIZE;
+    options->rsSize = RSSIZE;
+    options->lsqSize = LSQSIZE;
+    options->fetchStages = 1;
+    options->decodeStages = 1;
+    options->aluLatency = 1;
+    options->memoryLatency = 1;
+    options->resolveStage = 0;
+    options->mulLatency = MULLATENCY;
+    options->divLatency = DIVLATENCY;
+    options->check = 0;
+    options->cores = 1;
+    options->coreThreads = 1;
+    options->quantum = QUANTUM;
+    options->coherence = COHERENCE_MESI;
+    options->sampleUnit = 0;
+    options->samplePeriod = 0;
+    options->sampleWarmup = SAMPLEWARMUP;
+    options->snapshotInterval = 0;
+    options->debugFile = NULL;
+}
+
+/******************************************************************/
+/* The arena functions manage the single block that holds the     */
+/* memories. arenaInit returns -1 if the block cannot be         */
+/* allocated, and arenaAlloc hands out 8-byte aligned pieces or   */
+/* NULL once it is exhausted; everything is released at once by   */
+/* arenaFree.                                                     */
+/******************************************************************/
+int arenaInit(arenaType *arena, size_t size, char *error)
+{
+    arena->base = malloc(size);
+    arena->size = arena->base != NULL ? size : 0;
+    arena->used = 0;
+    arena->mapped = NULL;
+    arena->mappedSize = 0;
+    if(arena->base == NULL){
+        snprintf(error, ERRORLENGTH, "cannot allocate %lu bytes of simulator memory", (unsigned long)size);
+        return -1;
+    }
+    return 0;
+}
+
+void *arenaAlloc(arenaType *arena, size_t size)
+{
+    void *ptr;
+    size_t start = (arena->used + 7) & ~(size_t)7;
+
+    if(start + size > arena->size)
+        return NULL;
+    ptr = arena->base + start;
+    arena->used = start + size;
+    return ptr;
+}
+
+void arenaFree(arenaType *arena)
+{
+    free(arena->base);
+    if(arena->mapped != NULL)
+        munmap(arena->mapped, arena->mappedSize);
+    arena->mapped = NULL;
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+/******************************************************************/
+/* The fetchUop function returns the decodedMem index of the      */
+/* instruction before pcPlus4. Fetches outside instruction memory */
+/* return 0, and the engines then fetch nothing and keep the PC.  */
+/******************************************************************/
+int fetchUop(stateType *statePtr, int pcPlus4)
+{
+    int uop = pcPlus4/4;
+
+    if(pcPlus4 < 4 || uop > statePtr->instrSize)
+        return 0;
+    return uop;
+}
+
+/******************************************************************/
+/* The fetchFault function is called when a pipeline is empty.    */
+/* Fetch stops at a PC outside instruction memory, which an older */
+/* branch may still redirect; with nothing left in flight, the    */
+/* program has run off its instructions. fetchFault then records  */
+/* the error, as the functional simulator does, and returns 1.    */
+/******************************************************************/
+int fetchFault(stateType *statePtr, char *error)
+{
+    if(fetchUop(statePtr, statePtr->PC + 4) != 0)
+        return 0;
+    snprintf(error, ERRORLENGTH, "PC %d is outside instruction memory", statePtr->PC);
+    return 1;
+}
+
+/******************************************************************/
+/* The dataIndex function converts a byte address into a dataMem  */
+/* index. An address out of range records an error, unless one is */
+/* already recorded, and returns index 0 so the caller can finish */
+/* the cycle before stopping.                                     */
+/******************************************************************/
+int dataIndex(stateType *statePtr, int address, char *error)
+{
+    int index = address/4;
+
+    if(address < 0 || index >= statePtr->dataSize){
+        if(error[0] == '\0')
+            snprintf(error, ERRORLENGTH, "cycle %lld: data address %d is outside data memory",
+                     statePtr->cycles + 1, address);
+        return 0;
+    }
+    return index;
+}
+
+/******************************************************************/
+/* The aluCompute function performs the ALU operation of d on the */
+/* operands read from rs and rt, for an instruction at pcPlus4 -  */
+/* 4. Arithmetic wraps around; dividing by 0 gives 0 and the one  */
+/* overflowing division gives INT_MIN. Every engine, the          */
+/* functional simulator and the checker compute through it.       */
+/******************************************************************/
+int aluCompute(decodedType *d, int a, int b, int pcPlus4)
+{
+    unsigned int x = a, y = b;
 
+    switch(d->alu){
+    case ALU_ADD:  return x + y;
+    case ALU_SUB:  return x - y;
+    case ALU_ADDI: return x + d->immed;
+    case ALU_ADDS: return x + (short)d->immed;
+    case ALU_AND:  return x & y;
+    case ALU_OR:   return x | y;
+    case ALU_XOR:  return x ^ y;
+    case ALU_NOR:  return ~(x | y);
+    case ALU_SLT:  return a < b;
+    case ALU_SLTI: return a < (short)d->immed;
+    case ALU_ANDI: return x & d->immed;
+    case ALU_ORI:  return x | d->immed;
+    case ALU_XORI: return x ^ d->immed;
+    case ALU_SLL:  return y << d->shamt;
+    case ALU_SRL:  return y >> d->shamt;
+    case ALU_SRA:  return b >> d->shamt;
+    case ALU_SLLV: return y << (x & 31);
+    case ALU_SRLV: return y >> (x & 31);
+    case ALU_SRAV: return b >> (x & 31);
+    case ALU_EQ:   return a == b;
+    case ALU_LINK: return pcPlus4;
+    case ALU_PASS: return a;
+    case ALU_MUL:  return x * y;
+    case ALU_DIV:  return b == 0 ? 0 : a == INT_MIN && b == -1 ? a : a / b;
+    }
+    return 0;
+}
 
-        /* --------------------- EX stage --------------------- */
-        if(newState.cycles > 2){
-          newState.EXMEM.instr = state.IDEX.instr;
-          newState.EXMEM.writeDataReg = state.IDEX.readData2;
-          newState.EXMEM.bpb = state.IDEX.bpb;
+/* Cycles d spends in EX: the latency of its unit for a multiply or divide, 1 otherwise */
+int unitLatency(optionsType *options, decodedType *d)
+{
+    if(!(d->flags & OP_LONG))
+        return 1;
+    return d->alu == ALU_MUL ? options->mulLatency : options->divLatency;
+}
 
+/******************************************************************/
+/* The runFunctional function executes instructions directly on   */
+/* the register file and data memory, without the pipeline. It    */
+/* stops before a HALT, after limit instructions (-1 for no       */
+/* limit) or when the PC reaches marker (-1 for none), leaves the */
+/* next PC in the state and returns the number executed. Branch   */
+/* outcomes train the predictor, if one is given, without being   */
+/* counted in its statistics, and every fetch and data access     */
+/* goes through the caches, if given. It also stops on a bad      */
+/* address, recording the error. Like the scalar pipeline, the    */
+/* loop is compiled into variants for each predictor kind, with   */
+/* and without caches, plus one that only executes; a cache with  */
+/* no sets counts as not given.                                   */
+/******************************************************************/
+SPECIALIZE long long functionalLoop(stateType *statePtr, predictorType *pred, cacheType *icache, cacheType *dcache,
+                                    long long limit, int marker, char *error, int kind, int caches)
+{
+    long long count = 0;
+    int pc = statePtr->PC;
+    int *reg = statePtr->regFile;
+    int value;
+    decodedType *d;
 
-          if(stalled == 1 && (get_opcode(newState.IDEX.instr) == R || get_opcode(newState.IDEX.instr) == LW)){
-            newState.IDEX.readData1 = state.MEMWB.writeReg; // get content of rt reg
-            stalled = 0;
-          }
+    while(count != limit && pc != marker && error[0] == '\0'){
+        if(pc < 0 || pc/4 >= statePtr->instrSize){
+            snprintf(error, ERRORLENGTH, "PC %d is outside instruction memory", pc);
+            break;
+        }
+        d = &statePtr->decodedMem[pc/4 + 1];
+        if(caches && icache != NULL)
+            cacheAccess(icache, pc, 0);
+        if(d->flags & OP_HALT)
+            break;
+        value = aluCompute(d, reg[d->rs], reg[d->rt], pc + 4);
+        if(d->flags & OP_LOAD){
+            if(caches && dcache != NULL)
+                cacheAccess(dcache, value, 0);
+            value = statePtr->dataMem[dataIndex(statePtr, value, error)];
+        }
+        else if(d->flags & OP_STORE){
+            if(caches && dcache != NULL)
+                cacheAccess(dcache, value, 1);
+            statePtr->dataMem[dataIndex(statePtr, value, error)] = reg[d->rt];
+        }
+        if(d->dest != NOREG)
+            reg[d->dest] = value;
+        count++;
 
-          if(newState.EXMEM.instr == 0){ //if instruction is noop
-            newState.EXMEM.aluResult = 0;
-            newState.EXMEM.writeReg = 0;
-            newState.EXMEM.writeDataReg = 0;
-          }
-          if(get_opcode(state.IDEX.instr) == R){
+        if(d->flags & OP_BRANCH){
+            updateAs(pred, kind, pc, d->immed, value != 0);
+            pc = value ? d->immed : pc + 4;
+        }
+        else if(d->flags & OP_JUMP)
+            pc = d->immed;
+        else if(d->flags & OP_INDIRECT)
+            pc = value;
+        else
+            pc += 4;
+    }
+    statePtr->PC = pc;
+    return count;
+}
 
-            if(get_funct(state.IDEX.instr) == ADD){
+#define FUNCTIONALVARIANT(name, kind, caches) \
+static long long name(stateType *statePtr, predictorType *pred, cacheType *icache, cacheType *dcache, \
+                      long long limit, int marker, char *error) \
+{ \
+    return functionalLoop(statePtr, pred, icache, dcache, limit, marker, error, kind, caches); \
+}
 
-              if((get_rs(state.IDEX.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW ){
+FUNCTIONALVARIANT(functionalBare, PRED_NONE, 0)
+FUNCTIONALVARIANT(functionalCached, PRED_NONE, 1)
+FUNCTIONALVARIANT(functionalGlobal, PRED_GLOBAL, 0)
+FUNCTIONALVARIANT(functionalGlobalCached, PRED_GLOBAL, 1)
+FUNCTIONALVARIANT(functionalLocal, PRED_LOCAL, 0)
+FUNCTIONALVARIANT(functionalLocalCached, PRED_LOCAL, 1)
+FUNCTIONALVARIANT(functionalBtb, PRED_BTB, 0)
+FUNCTIONALVARIANT(functionalBtbCached, PRED_BTB, 1)
+FUNCTIONALVARIANT(functionalGshare, PRED_GSHARE, 0)
+FUNCTIONALVARIANT(functionalGshareCached, PRED_GSHARE, 1)
+FUNCTIONALVARIANT(functionalTournament, PRED_TOURNAMENT, 0)
+FUNCTIONALVARIANT(functionalTournamentCached, PRED_TOURNAMENT, 1)
 
-                state.IDEX.readData1 = state.MEMWB.writeDataMem;
+/* Variants by PRED_* kind, without and with caches */
+static const functionalType functionalVariants[][2] = {
+  {functionalGlobal, functionalGlobalCached},
+  {functionalLocal, functionalLocalCached},
+  {functionalBtb, functionalBtbCached},
+  {functionalGshare, functionalGshareCached},
+  {functionalTournament, functionalTournamentCached}
+};
 
-              }
-              if((get_rt(state.IDEX.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
+/* The variant for the predictor and the caches, which must be NULL if they have no sets */
+functionalType functionalVariant(predictorType *pred, cacheType *icache, cacheType *dcache)
+{
+    int caches = icache != NULL || dcache != NULL;
 
-                state.IDEX.readData2 = state.MEMWB.writeDataMem;
+    if(pred == NULL)
+        return caches ? functionalCached : functionalBare;
+    return functionalVariants[pred->kind][caches];
+}
 
-              }
-              if((get_rs(state.IDEX.instr) == get_rd(newState.EXMEM.instr)) && get_opcode(newState.EXMEM.instr) == R){
-                state.IDEX.readData1 = newState.EXMEM.aluResult;
+long long runFunctional(stateType *statePtr, predictorType *pred, cacheType *icache, cacheType *dcache,
+                        long long limit, int marker, char *error)
+{
+    if(icache != NULL && icache->sets == 0)
+        icache = NULL;
+    if(dcache != NULL && dcache->sets == 0)
+        dcache = NULL;
+    return functionalVariant(pred, icache, dcache)(statePtr, pred, icache, dcache, limit, marker, error);
+}
 
-              }
-              if((get_rt(state.IDEX.instr) == get_rd(newState.EXMEM.instr)) && get_opcode(newState.EXMEM.instr) == R){
-                state.IDEX.readData2 = newState.EXMEM.aluResult;
+/******************************************************************/
+/* The checkpoint functions save and restore everything needed to */
+/* continue a run: the PC, latches, register file, memories, the  */
+/* stall counters and the branch predictor. They return 0, or -1 */
+/* with a message in error.                                       */
+/******************************************************************/
+int checkpointWrite(FILE *file, void *data, size_t size)
+{
+    static const char padding[8] = {0};
 
-              }
+    if((size > 0 && fwrite(data, 1, size, file) != size) ||
+       fwrite(padding, 1, (8 - size % 8) % 8, file) != (8 - size % 8) % 8)
+        return -1;
+    return 0;
+}
 
-                newState.EXMEM.aluResult = state.IDEX.readData1 + state.IDEX.readData2;
-                newState.EXMEM.writeDataReg = state.MEMWB.writeDataMem;
-                newState.EXMEM.writeReg = state.IDEX.rdReg;
-            }
+size_t checkpointSection(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
 
+int writeCheckpoint(char *name, stateType *statePtr, predictorType *pred, long long stalls, long long *counters,
+                    char *error)
+{
+    checkpointType header;
+    int size = pred->mask + 1;
+    int failed = 0;
+    FILE *file = fopen(name, "wb");
 
+    if(file == NULL){
+        snprintf(error, ERRORLENGTH, "cannot create checkpoint %s", name);
+        return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINTMAGIC, 8);
+    header.version = CHECKPOINTVERSION;
+    header.stateBytes = sizeof(stateType);
+    header.numRegs = NUMREGS;
+    header.instrSize = statePtr->instrSize;
+    header.dataSize = statePtr->dataSize;
+    header.PC = statePtr->PC;
+    header.cycles = statePtr->cycles;
+    header.stalls = stalls;
+    header.predictorKind = pred->kind;
+    header.predictorSize = size;
+    header.historyBits = 0;
+    while((pred->historyMask >> header.historyBits) != 0)
+        header.historyBits++;
+    header.history = pred->history;
+    header.branches = pred->branches;
+    header.mispredictions = pred->mispredictions;
+    memcpy(header.counters, counters, sizeof(header.counters));
+    header.IFID = statePtr->IFID;
+    header.IDEX = statePtr->IDEX;
+    header.EXMEM = statePtr->EXMEM;
+    header.MEMWB = statePtr->MEMWB;
 
-            else if(get_funct(state.IDEX.instr) == SUB){
+    failed |= checkpointWrite(file, &header, sizeof(header));
+    failed |= checkpointWrite(file, statePtr->regFile, sizeof(int) * NUMREGS);
+    failed |= checkpointWrite(file, statePtr->instrMem, sizeof(unsigned int) * statePtr->instrSize);
+    failed |= checkpointWrite(file, statePtr->dataMem, sizeof(int) * statePtr->dataSize);
+    failed |= checkpointWrite(file, statePtr->decodedMem, sizeof(decodedType) * (statePtr->instrSize + 1));
+    failed |= checkpointWrite(file, pred->counters, size);
+    if(pred->kind == PRED_TOURNAMENT){
+        failed |= checkpointWrite(file, pred->globalCounters, size);
+        failed |= checkpointWrite(file, pred->chooser, size);
+    }
+    if(pred->kind == PRED_BTB){
+        failed |= checkpointWrite(file, pred->tags, sizeof(int) * size);
+        failed |= checkpointWrite(file, pred->targets, sizeof(int) * size);
+    }
+    if(fclose(file) != 0 || failed){
+        snprintf(error, ERRORLENGTH, "cannot write checkpoint %s", name);
+        return -1;
+    }
+    return 0;
+}
 
-              if((get_rs(state.IDEX.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
+/* The memories point straight into a private mapping of the file, so */
+/* restoring costs no copying and pages are only read when touched.    */
+/* The header is checked before any field sizes or indexes anything,  */
+/* latches may only hold instructions of instruction memory, and the   */
+/* memories take the sizes the checkpoint was written with. decodedMem */
+/* is decoded again from instrMem rather than trusted.                 */
+int readCheckpoint(char *name, stateType *statePtr, arenaType *arena,
+                   predictorType *pred, long long *stalls, long long *counters, char *error)
+{
+    checkpointType *header;
+    optionsType options;
+    struct stat info;
+    char *base, *section;
+    size_t expected;
+    int size;
+    int fd = open(name, O_RDONLY);
 
-                state.IDEX.readData1 = state.MEMWB.writeDataMem;
+    if(fd < 0 || fstat(fd, &info) != 0){
+        if(fd >= 0)
+            close(fd);
+        snprintf(error, ERRORLENGTH, "cannot open checkpoint %s", name);
+        return -1;
+    }
+    base = (size_t)info.st_size >= sizeof(checkpointType) ?
+        mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    header = (checkpointType*)base;
+    if(base == MAP_FAILED || memcmp(header->magic, CHECKPOINTMAGIC, 8) != 0 ||
+       header->version != CHECKPOINTVERSION || header->stateBytes != sizeof(stateType) ||
+       header->numRegs != NUMREGS){
+        if(base != MAP_FAILED)
+            munmap(base, info.st_size);
+        snprintf(error, ERRORLENGTH, "%s is not a checkpoint written by this simulator", name);
+        return -1;
+    }
 
-              }
-              if((get_rt(state.IDEX.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
+    size = header->predictorSize;
+    if(header->instrSize < 1 || header->dataSize < 1 ||
+       header->predictorKind < PRED_GLOBAL || header->predictorKind > PRED_TOURNAMENT ||
+       size < 1 || (size & (size - 1)) || header->historyBits < 0 || header->historyBits > 30 ||
+       header->cycles < 0 || header->stalls < 0 || header->branches < 0 || header->mispredictions < 0 ||
+       header->IFID.uop < 0 || header->IFID.uop > header->instrSize ||
+       header->IDEX.uop < 0 || header->IDEX.uop > header->instrSize ||
+       header->EXMEM.uop < 0 || header->EXMEM.uop > header->instrSize ||
+       header->MEMWB.uop < 0 || header->MEMWB.uop > header->instrSize){
+        munmap(base, info.st_size);
+        snprintf(error, ERRORLENGTH, "checkpoint %s is corrupt", name);
+        return -1;
+    }
+    expected = checkpointSection(sizeof(checkpointType))
+             + checkpointSection(sizeof(int) * NUMREGS)
+             + checkpointSection(sizeof(unsigned int) * header->instrSize)
+             + checkpointSection(sizeof(int) * header->dataSize)
+             + checkpointSection(sizeof(decodedType) * (header->instrSize + 1))
+             + checkpointSection(size);
+    if(header->predictorKind == PRED_TOURNAMENT)
+        expected += 2 * checkpointSection(size);
+    if(header->predictorKind == PRED_BTB)
+        expected += 2 * checkpointSection(sizeof(int) * size);
+    if((size_t)info.st_size < expected){
+        munmap(base, info.st_size);
+        snprintf(error, ERRORLENGTH, "checkpoint %s is truncated", name);
+        return -1;
+    }
 
-                state.IDEX.readData2 = state.MEMWB.writeDataMem;
+    /* The register file is copied, the memories stay in the mapping */
+    if(arenaInit(arena, sizeof(int) * NUMREGS, error) != 0){
+        munmap(base, info.st_size);
+        return -1;
+    }
+    arena->mapped = base;
+    arena->mappedSize = info.st_size;
+    section = base + checkpointSection(sizeof(checkpointType));
+    statePtr->regFile = arenaAlloc(arena, sizeof(int) * NUMREGS);
+    memcpy(statePtr->regFile, section, sizeof(int) * NUMREGS);
+    section += checkpointSection(sizeof(int) * NUMREGS);
+    statePtr->instrMem = (unsigned int*)section;
+    section += checkpointSection(sizeof(unsigned int) * header->instrSize);
+    statePtr->dataMem = (int*)section;
+    section += checkpointSection(sizeof(int) * header->dataSize);
+    statePtr->decodedMem = (decodedType*)section;
+    section += checkpointSection(sizeof(decodedType) * (header->instrSize + 1));
+    if(decodeProgram(statePtr->instrMem, statePtr->decodedMem, header->instrSize) != 0){
+        snprintf(error, ERRORLENGTH, "checkpoint %s is corrupt", name);
+        return -1;
+    }
 
-              }
-              if((get_rs(state.IDEX.instr) == get_rd(state.EXMEM.instr)) && get_opcode(state.EXMEM.instr) == R){
-                state.IDEX.readData1 = state.EXMEM.aluResult;
-              }
-              if((get_rt(state.IDEX.instr) == get_rd(state.EXMEM.instr)) && get_opcode(state.EXMEM.instr) == R){
-                state.IDEX.readData2 = state.EXMEM.aluResult;
+    statePtr->instrSize = header->instrSize;
+    statePtr->dataSize = header->dataSize;
+    statePtr->PC = header->PC;
+    statePtr->cycles = header->cycles;
+    statePtr->IFID = header->IFID;
+    statePtr->IDEX = header->IDEX;
+    statePtr->EXMEM = header->EXMEM;
+    statePtr->MEMWB = header->MEMWB;
+    *stalls = header->stalls;
+    memcpy(counters, header->counters, sizeof(header->counters));
 
-              }
+    /* Rebuild the predictor, then fill its tables */
+    options.predictorKind = header->predictorKind;
+    options.predictorSize = size;
+    options.historyBits = header->historyBits;
+    if(predictorInit(pred, &options, error) != 0)
+        return -1;
+    pred->history = header->history;
+    pred->branches = header->branches;
+    pred->mispredictions = header->mispredictions;
+    memcpy(pred->counters, section, size);
+    section += checkpointSection(size);
+    if(pred->kind == PRED_TOURNAMENT){
+        memcpy(pred->globalCounters, section, size);
+        section += checkpointSection(size);
+        memcpy(pred->chooser, section, size);
+        section += checkpointSection(size);
+    }
+    if(pred->kind == PRED_BTB){
+        memcpy(pred->tags, section, sizeof(int) * size);
+        section += checkpointSection(sizeof(int) * size);
+        memcpy(pred->targets, section, sizeof(int) * size);
+    }
+    return 0;
+}
 
-                newState.EXMEM.aluResult = state.IDEX.readData1 - state.IDEX.readData2;
-                newState.EXMEM.writeDataReg = state.MEMWB.writeDataMem;
-                newState.EXMEM.writeReg = state.IDEX.rdReg;
+/******************************************************************/
+/* Branch predictors. Every table holds 2-bit saturating counters */
+/* using the STRONGLYTAKEN..STRONGLYNOTTAKEN values and predicts  */
+/* taken from WEAKLYTAKEN up. Tables are indexed by the word      */
+/* address of the branch.                                         */
+/******************************************************************/
+void counterUpdate(unsigned char *counter, int taken)
+{
+    if(taken && *counter < STRONGLYTAKEN)
+        (*counter)++;
+    else if(!taken && *counter > STRONGLYNOTTAKEN)
+        (*counter)--;
+}
 
+int globalPredict(predictorType *pred, int pc, int *target)
+{
+    (void)pc;
+    (void)target;
+    return pred->counters[0] >= WEAKLYTAKEN;
+}
 
-            }
-          }
-          else if(get_opcode(state.IDEX.instr) == LW){
+void globalUpdate(predictorType *pred, int pc, int target, int taken)
+{
+    (void)pc;
+    (void)target;
+    counterUpdate(&pred->counters[0], taken);
+}
 
-            newState.EXMEM.aluResult = state.IDEX.immed + state.IDEX.readData2;
-            newState.EXMEM.writeReg = state.IDEX.rtReg;
-          }
-          else if(get_opcode(state.IDEX.instr) == SW){
-            newState.EXMEM.aluResult = state.IDEX.immed + state.IDEX.readData1;
-            newState.EXMEM.writeReg = state.IDEX.rtReg;
+int localPredict(predictorType *pred, int pc, int *target)
+{
+    (void)target;
+    return pred->counters[(pc >> 2) & pred->mask] >= WEAKLYTAKEN;
+}
 
-            if((get_rt(state.IDEX.instr) == get_rd(state.EXMEM.instr)) && get_opcode(state.EXMEM.instr) == R){
-              newState.EXMEM.writeDataReg = state.EXMEM.aluResult;
-            }
-            else if((get_rt(state.IDEX.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
-              newState.EXMEM.writeDataReg = state.MEMWB.writeDataMem;
-            }
+void localUpdate(predictorType *pred, int pc, int target, int taken)
+{
+    (void)target;
+    counterUpdate(&pred->counters[(pc >> 2) & pred->mask], taken);
+}
 
+/* A BTB miss predicts not taken. Entries are allocated on the first taken outcome. */
+int btbPredict(predictorType *pred, int pc, int *target)
+{
+    unsigned int index = (pc >> 2) & pred->mask;
 
-          }
-          else if(get_opcode(state.IDEX.instr) == BNE){
+    if(pred->tags[index] != pc || pred->counters[index] < WEAKLYTAKEN)
+        return 0;
+    *target = pred->targets[index];
+    return 1;
+}
 
+void btbUpdate(predictorType *pred, int pc, int target, int taken)
+{
+    unsigned int index = (pc >> 2) & pred->mask;
 
-            if((get_rs(state.IDEX.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
+    if(pred->tags[index] != pc){
+        if(!taken)
+            return;
+        pred->tags[index] = pc;
+        pred->counters[index] = WEAKLYTAKEN;
+    }
+    else
+        counterUpdate(&pred->counters[index], taken);
+    pred->targets[index] = target;
+}
 
-              state.IDEX.readData1 = state.MEMWB.writeDataMem;
-              newState.EXMEM.writeDataReg = state.MEMWB.writeDataMem;
-            }
-            if((get_rt(state.IDEX.instr) == get_rt(state.MEMWB.instr)) && get_opcode(state.MEMWB.instr) == LW){
+unsigned int gshareIndex(predictorType *pred, int pc)
+{
+    return ((pc >> 2) ^ (pred->history & pred->historyMask)) & pred->mask;
+}
 
-              state.IDEX.readData2 = state.MEMWB.writeDataMem;
-              newState.EXMEM.writeDataReg = state.MEMWB.writeDataMem;
-            }
-            if((get_rs(state.IDEX.instr) == get_rd(state.EXMEM.instr)) && get_opcode(state.EXMEM.instr) == R){
-              state.IDEX.readData1 = state.EXMEM.aluResult;
-            }
-            if((get_rt(state.IDEX.instr) == get_rd(state.EXMEM.instr)) && get_opcode(state.EXMEM.instr) == R){
-              state.IDEX.readData2 = state.EXMEM.aluResult;
-            }
+int gsharePredict(predictorType *pred, int pc, int *target)
+{
+    (void)target;
+    return pred->counters[gshareIndex(pred, pc)] >= WEAKLYTAKEN;
+}
 
+void gshareUpdate(predictorType *pred, int pc, int target, int taken)
+{
+    (void)target;
+    counterUpdate(&pred->counters[gshareIndex(pred, pc)], taken);
+    pred->history = (pred->history << 1) | (taken != 0);
+}
 
-            newState.EXMEM.writeReg = state.IDEX.rtReg;
-            newState.EXMEM.writeDataReg = state.IDEX.readData2;
-            newState.EXMEM.aluResult = state.IDEX.readData1 - state.IDEX.readData2;
+int tournamentPredict(predictorType *pred, int pc, int *target)
+{
+    unsigned int index = (pc >> 2) & pred->mask;
 
-            if((state.IDEX.readData1 - state.IDEX.readData2) != 0){
+    (void)target;
 
-              if(bpb < 3 & newState.EXMEM.aluResult != 0){
-                mispredictions++;
-                stalls++;
-                stalled = 1;
-                bpb++;
-                newState.IDEX.instr = 0; //NOOP instr
-                newState.PC = state.IDEX.immed;
-                newState.IFID.PCPlus4 = 0;
-                newState.IFID.instr = 0;
-                newState.IDEX.PCPlus4 = 0;
-                newState.IDEX.immed = 0;
-                newState.IDEX.branchTarget = 0;
-                newState.IDEX.rsReg = 0;
-                newState.IDEX.rtReg = 0;
-                newState.IDEX.rdReg = 0;
-                newState.IDEX.readData1 = 0;
-                newState.IDEX.readData2 = 0;
-              }
-              else{
-                stalls++;
-                  bpb++;
+    if(pred->chooser[index] >= WEAKLYTAKEN)
+        return pred->globalCounters[gshareIndex(pred, pc)] >= WEAKLYTAKEN;
+    return pred->counters[index] >= WEAKLYTAKEN;
+}
 
-              }
+/* The chooser moves towards whichever component was right when they disagree */
+void tournamentUpdate(predictorType *pred, int pc, int target, int taken)
+{
+    unsigned int index = (pc >> 2) & pred->mask;
+    unsigned int gindex = gshareIndex(pred, pc);
+    int localRight = (pred->counters[index] >= WEAKLYTAKEN) == (taken != 0);
+    int globalRight = (pred->globalCounters[gindex] >= WEAKLYTAKEN) == (taken != 0);
 
-            }
-            else if((state.IDEX.readData1 - state.IDEX.readData2) == 0){
+    (void)target;
+    if(localRight != globalRight)
+        counterUpdate(&pred->chooser[index], globalRight);
+    counterUpdate(&pred->counters[index], taken);
+    counterUpdate(&pred->globalCounters[gindex], taken);
+    pred->history = (pred->history << 1) | (taken != 0);
+}
 
-              if(bpb > 2){
-                bpb--;
-                mispredictions++;
-              }
+/* Allocates a table of counters, or returns NULL if memory runs out */
+unsigned char *counterTable(int size)
+{
+    unsigned char *table = malloc(size);
+    if(table != NULL)
+        memset(table, WEAKLYTAKEN, size);
+    return table;
+}
 
+/******************************************************************/
+/* The predictorInit function builds the predictor selected in    */
+/* the options. All counters start WEAKLYTAKEN and the global     */
+/* history starts empty. It returns -1 if the tables cannot be    */
+/* allocated.                                                     */
+/******************************************************************/
+int predictorInit(predictorType *pred, optionsType *options, char *error)
+{
+    int size = options->predictorSize;
+    int i;
 
-              stalled = 0;
-              if(branches < 1){
-                newState.PC = newState.IDEX.PCPlus4 + 4;
-                newState.IFID.PCPlus4 =  0;
+    memset(pred, 0, sizeof(predictorType));
+    pred->kind = options->predictorKind;
+    pred->mask = size - 1;
+    pred->historyMask = (1u << options->historyBits) - 1;
 
-              }
-              else
-                newState.PC = state.IDEX.PCPlus4;
-              branches++;
-              newState.IFID.PCPlus4 =newState.IDEX.PCPlus4 + 4;
-              newState.IFID.instr = 0;
+    switch(pred->kind){
+    case PRED_GLOBAL:
+        pred->mask = 0;
+        pred->counters = counterTable(1);
+        pred->predict = globalPredict;
+        pred->update = globalUpdate;
+        break;
+    case PRED_LOCAL:
+        pred->counters = counterTable(size);
+        pred->predict = localPredict;
+        pred->update = localUpdate;
+        break;
+    case PRED_BTB:
+        pred->hasTarget = 1;
+        pred->counters = counterTable(size);
+        pred->tags = malloc(sizeof(int) * size);
+        pred->targets = malloc(sizeof(int) * size);
+        for(i = 0; pred->tags != NULL && pred->targets != NULL && i < size; i++){
+            pred->tags[i] = -1;
+            pred->targets[i] = 0;
+        }
+        pred->predict = btbPredict;
+        pred->update = btbUpdate;
+        break;
+    case PRED_GSHARE:
+        pred->counters = counterTable(size);
+        pred->predict = gsharePredict;
+        pred->update = gshareUpdate;
+        break;
+    case PRED_TOURNAMENT:
+        pred->counters = counterTable(size);
+        pred->globalCounters = counterTable(size);
+        pred->chooser = counterTable(size);
+        pred->predict = tournamentPredict;
+        pred->update = tournamentUpdate;
+        break;
+    }
+    if(pred->counters == NULL || (pred->kind == PRED_BTB && (pred->tags == NULL || pred->targets == NULL)) ||
+       (pred->kind == PRED_TOURNAMENT && (pred->globalCounters == NULL || pred->chooser == NULL))){
+        predictorFree(pred);
+        snprintf(error, ERRORLENGTH, "cannot allocate predictor tables");
+        return -1;
+    }
+    return 0;
+}
 
+void predictorFree(predictorType *pred)
+{
+    free(pred->counters);
+    free(pred->globalCounters);
+    free(pred->chooser);
+    free(pred->tags);
+    free(pred->targets);
+    pred->counters = pred->globalCounters = pred->chooser = NULL;
+    pred->tags = pred->targets = NULL;
+}
 
-            }
+/******************************************************************/
+/* The predictorResolve function is called when a branch resolves */
+/* in EX. It counts the outcome against the prediction carried in */
+/* the pipeline registers and trains the predictor.               */
+/******************************************************************/
+void predictorResolve(predictorType *pred, int pc, int target, int taken, int predicted)
+{
+    pred->branches++;
+    if(taken != predicted)
+        pred->mispredictions++;
+    pred->update(pred, pc, target, taken);
+}
 
-          }
-          else if(get_opcode(state.IDEX.instr) == HALT){
-            newState.EXMEM.aluResult = 0;
-            newState.EXMEM.writeReg = 0;
-            newState.EXMEM.writeDataReg = 0;
-          }
+/******************************************************************/
+/* The cache functions model the timing of a set-associative      */
+/* cache. cacheInit builds a cache of size bytes, or a disabled   */
+/* one if size is 0, and returns -1 with a message in error if    */
+/* the geometry is not usable.                                    */
+/******************************************************************/
+int cacheInit(cacheType *cache, int size, int ways, int line, optionsType *options, char *error)
+{
+    int i;
 
-        }
+    memset(cache, 0, sizeof(cacheType));
+    if(size == 0)
+        return 0;
+    if(line < 4 || (line & (line - 1)) || ways < 1 || size % (line * ways) != 0 ||
+       ((size / (line * ways)) & (size / (line * ways) - 1))){
+        snprintf(error, ERRORLENGTH, "a %d byte cache cannot have %d ways of %d byte lines", size, ways, line);
+        return -1;
+    }
+    if(ways > 255 || (options->replacement == CACHE_PLRU && (ways > 32 || (ways & (ways - 1))))){
+        snprintf(error, ERRORLENGTH, "%d ways are not supported by this replacement policy", ways);
+        return -1;
+    }
+    cache->sets = size / (line * ways);
+    cache->ways = ways;
+    while((1 << cache->lineShift) < line)
+        cache->lineShift++;
+    while((1 << cache->setShift) < cache->sets)
+        cache->setShift++;
+    cache->replacement = options->replacement;
+    cache->writePolicy = options->writePolicy;
+    cache->latency = options->missLatency;
+    cache->lines = calloc(cache->sets * ways, sizeof(unsigned int));
+    cache->age = malloc(cache->sets * ways);
+    cache->plru = calloc(cache->sets, sizeof(unsigned int));
+    if(cache->lines == NULL || cache->age == NULL || cache->plru == NULL){
+        snprintf(error, ERRORLENGTH, "cannot allocate cache tags");
+        return -1;
+    }
+    for(i = 0; i < cache->sets * ways; i++)
+        cache->age[i] = i % ways;
+    return 0;
+}
 
-        /* --------------------- MEM stage --------------------- */
-        if(newState.cycles > 3){
+/* Marks a line as the most recently used of its set */
+void cacheTouch(cacheType *cache, int set, int way)
+{
+    unsigned char *age = &cache->age[set * cache->ways];
+    unsigned char old = age[way];
+    int node, i;
 
-          newState.MEMWB.instr = state.EXMEM.instr;
-          newState.MEMWB.writeDataALU = state.EXMEM.aluResult;
-          newState.MEMWB.writeReg = state.EXMEM.writeReg;
+    if(cache->replacement == CACHE_LRU){
+        for(i = 0; i < cache->ways; i++)
+            if(age[i] < old)
+                age[i]++;
+        age[way] = 0;
+        return;
+    }
+    /* Point every tree node on the path away from the line just used */
+    for(node = way + cache->ways; node > 1; node >>= 1){
+        if(node & 1)
+            cache->plru[set] &= ~(1u << (node >> 1));
+        else
+            cache->plru[set] |= 1u << (node >> 1);
+    }
+}
 
-          if(get_opcode(state.EXMEM.instr) == R){
-            if(get_funct(state.EXMEM.instr) == ADD){
+/* Chooses the line of a set to replace, preferring an invalid one */
+int cacheVictim(cacheType *cache, int set)
+{
+    unsigned int *lines = &cache->lines[set * cache->ways];
+    unsigned char *age = &cache->age[set * cache->ways];
+    int node, i;
 
-          }
-          if(get_funct(state.EXMEM.instr) == SUB){
+    for(i = 0; i < cache->ways; i++)
+        if(!(lines[i] & LINEVALID))
+            return i;
+    if(cache->replacement == CACHE_LRU){
+        for(i = 0; age[i] != cache->ways - 1; i++)
+            ;
+        return i;
+    }
+    for(node = 1; node < cache->ways; )
+        node = 2 * node + ((cache->plru[set] >> node) & 1);
+    return node - cache->ways;
+}
 
-          }
-        }
-          else if(get_opcode(state.EXMEM.instr) == LW){
-            newState.MEMWB.writeDataMem = state.dataMem[state.EXMEM.aluResult/4];
-          }
-          else if(get_opcode(state.EXMEM.instr) == SW){
-            newState.dataMem[(state.EXMEM.aluResult/4)] = state.EXMEM.writeDataReg;
-          }
-          else if(get_opcode(state.EXMEM.instr) == HALT){
-            newState.MEMWB.writeDataALU = 0;
-            newState.MEMWB.writeReg = 0;
-          }
-          else if(state.EXMEM.instr == 0){
-            newState.MEMWB.writeDataALU = 0;
-            newState.MEMWB.writeReg = 0;
+/******************************************************************/
+/* The cacheAccess function looks up the byte address, updates    */
+/* the tags and statistics, and returns the cycles the access     */
+/* stalls the pipeline: 0 on a hit, the latency on a miss, plus   */
+/* another latency to write back a dirty victim. A disabled cache */
+/* always returns 0.                                              */
+/******************************************************************/
+int cacheAccess(cacheType *cache, int address, int write)
+{
+    unsigned int block, tag, *lines;
+    int set, way, stall = 0;
 
-          }
+    if(cache->sets == 0)
+        return 0;
+    block = (unsigned int)address >> cache->lineShift;
+    set = block & (cache->sets - 1);
+    tag = block >> cache->setShift;
+    lines = &cache->lines[set * cache->ways];
 
+    cache->stats.accesses++;
+    if(write && cache->writePolicy == WRITETHROUGH)
+        cache->stats.writebacks++;
+    for(way = 0; way < cache->ways; way++){
+        if((lines[way] & LINEVALID) && (lines[way] >> LINETAGSHIFT) == tag){
+            cache->stats.hits++;
+            if(write && cache->writePolicy == WRITEBACK)
+                lines[way] |= LINEDIRTY;
+            cacheTouch(cache, set, way);
+            return 0;
         }
+    }
+    cache->stats.misses++;
 
-        /* --------------------- WB stage --------------------- */
-        if(newState.cycles > 4){
-          if(get_opcode(state.MEMWB.instr) == LW){
-            newState.regFile[state.MEMWB.writeReg] = state.MEMWB.writeDataMem;
-          }
-          else if(get_opcode(state.MEMWB.instr) == R){
-            if(get_funct(state.MEMWB.instr) == ADD ||get_funct(state.MEMWB.instr) == SUB )
-              newState.regFile[state.MEMWB.writeReg] = state.MEMWB.writeDataALU;
-          }
+    /* A write-through store miss goes around the cache without stalling */
+    if(write && cache->writePolicy == WRITETHROUGH)
+        return 0;
+    way = cacheVictim(cache, set);
+    if(lines[way] & LINEVALID){
+        cache->stats.evictions++;
+        if(lines[way] & LINEDIRTY){
+            cache->stats.writebacks++;
+            stall += cache->latency;
         }
-
-        state = newState;    /* The newState now becomes the old state before we execute the next cycle */
-
     }
+    lines[way] = (tag << LINETAGSHIFT) | LINEVALID | (write ? LINEDIRTY : 0);
+    cacheTouch(cache, set, way);
+    return stall + cache->latency;
+}
+
+void cacheFree(cacheType *cache)
+{
+    free(cache->lines);
+    free(cache->age);
+    free(cache->plru);
+    memset(cache, 0, sizeof(cacheType));
 }
 
+void cacheStatsAdd(cacheStatsType *sum, cacheStatsType *stats)
+{
+    sum->accesses += stats->accesses;
+    sum->hits += stats->hits;
+    sum->misses += stats->misses;
+    sum->evictions += stats->evictions;
+    sum->writebacks += stats->writebacks;
+}
 
 /******************************************************************/
-/* The initState function accepts a pointer to the current        */
-/* state as an argument, initializing the state to pre-execution  */
-/* state. In particular, all registers are zero'd out. All        */
-/* instructions in the pipeline are NOOPS. Data and instruction   */
-/* memory are initialized with the contents of the assembly       */
-/* input file.                                                    */
-/*****************************************************************/
-void initState(stateType *statePtr)
+/* The bus functions keep the data caches of a multicore run      */
+/* coherent. busAccess takes the place of cacheAccess for a core: */
+/* a miss, or a write to a shared line, becomes a bus request,    */
+/* and busSnoop finds the other caches' copies of the line. A     */
+/* modified copy is written back first; then the copies become    */
+/* shared for a read and invalid for a write. Under MSI a line    */
+/* read by a single core is still shared, so its first write      */
+/* costs an upgrade; MESI makes it exclusive and writes it        */
+/* silently. Every bus request takes the miss latency, and so     */
+/* does writing back a modified copy. The bus lock serializes the */
+/* requests of cores running in parallel, and with them the load  */
+/* or store of the shared dataMem word, which busAccess makes     */
+/* through data: it stores *data, or loads into it.               */
+/******************************************************************/
+int busAccess(simulatorType *sim, int address, int word, int write, int *data)
 {
-    unsigned int dec_inst;
-    int data_index = 0;
-    int inst_index = 0;
-    char line[130];
-    char instr[5];
-    char args[130];
-    char* arg;
+    multicoreType *bus = sim->bus;
+    cacheType *cache = &sim->dcache;
+    unsigned int block, tag, *lines;
+    int set, way, shared, stall = 0;
 
-    statePtr->PC = 0;
-    statePtr->cycles = 0;
+    pthread_mutex_lock(&bus->bus);
+    if(write)
+        sim->state->dataMem[word] = *data;
+    else
+        *data = sim->state->dataMem[word];
+    if(cache->sets == 0){
+        pthread_mutex_unlock(&bus->bus);
+        return 0;
+    }
+    block = (unsigned int)address >> cache->lineShift;
+    set = block & (cache->sets - 1);
+    tag = block >> cache->setShift;
+    lines = &cache->lines[set * cache->ways];
 
-    /* Zero out data, instructions, and registers */
-    memset(statePtr->dataMem, 0, 4*NUMMEMORY);
-    memset(statePtr->instrMem, 0, 4*NUMMEMORY);
-    memset(statePtr->regFile, 0, 4*NUMREGS);
+    cache->stats.accesses++;
+    for(way = 0; way < cache->ways; way++)
+        if((lines[way] & LINEVALID) && (lines[way] >> LINETAGSHIFT) == tag)
+            break;
+    if(way < cache->ways){
+        cache->stats.hits++;
+        cacheTouch(cache, set, way);
+        if(write && !(lines[way] & LINEEXCLUSIVE)){
+            sim->counters[CTR_UPGRADES]++;
+            busSnoop(sim, block, 1, &stall);
+            stall += cache->latency;
+        }
+        if(write)
+            lines[way] |= LINEDIRTY | LINEEXCLUSIVE;
+        pthread_mutex_unlock(&bus->bus);
+        return stall;
+    }
 
-    /* Parse assembly file and initialize data/instruction memory */
-    while(fgets(line, 130, stdin)){
-        if(sscanf(line, "\t.%s %s", instr, args) == 2){
-            arg = strtok(args, ",");
-            while(arg != NULL){
-                statePtr->dataMem[data_index] = atoi(arg);
-                data_index += 1;
-                arg = strtok(NULL, ",");
-            }
+    cache->stats.misses++;
+    for(way = 0; way < cache->ways; way++){
+        if((lines[way] & LINESTOLEN) && (lines[way] >> LINETAGSHIFT) == tag){
+            sim->counters[CTR_SHARINGMISSES]++;
+            lines[way] = 0;
         }
-        else if(sscanf(line, "\t%s %s", instr, args) == 2){
-            dec_inst = instrToInt(instr, args);
-            statePtr->instrMem[inst_index] = dec_inst;
-            inst_index += 1;
+    }
+    way = cacheVictim(cache, set);
+    if(lines[way] & LINEVALID){
+        cache->stats.evictions++;
+        if(lines[way] & LINEDIRTY){
+            cache->stats.writebacks++;
+            stall += cache->latency;
         }
     }
+    sim->counters[write ? CTR_BUSREADX : CTR_BUSREAD]++;
+    shared = busSnoop(sim, block, write, &stall);
+    lines[way] = (tag << LINETAGSHIFT) | LINEVALID;
+    if(write)
+        lines[way] |= LINEDIRTY | LINEEXCLUSIVE;
+    else if(!shared && bus->protocol == COHERENCE_MESI)
+        lines[way] |= LINEEXCLUSIVE;
+    cacheTouch(cache, set, way);
+    pthread_mutex_unlock(&bus->bus);
+    return stall + cache->latency;
+}
 
-    /* Zero-out all registers in pipeline to start */
-    statePtr->IFID.instr = 0;
-    statePtr->IFID.PCPlus4 = 0;
-    statePtr->IDEX.instr = 0;
-    statePtr->IDEX.PCPlus4 = 0;
-    statePtr->IDEX.branchTarget = 0;
-    statePtr->IDEX.readData1 = 0;
-    statePtr->IDEX.readData2 = 0;
-    statePtr->IDEX.immed = 0;
-    statePtr->IDEX.rsReg = 0;
-    statePtr->IDEX.rtReg = 0;
-    statePtr->IDEX.rdReg = 0;
-
-    statePtr->EXMEM.instr = 0;
-    statePtr->EXMEM.aluResult = 0;
-    statePtr->EXMEM.writeDataReg = 0;
-    statePtr->EXMEM.writeReg = 0;
+/* Snoops the other cores' caches for the block, adding the cycles of writebacks to stall; returns 1 if any held it */
+int busSnoop(simulatorType *sim, unsigned int block, int invalidate, int *stall)
+{
+    multicoreType *bus = sim->bus;
+    cacheType *cache;
+    unsigned int tag, *lines;
+    int i, way, found = 0;
 
-    statePtr->MEMWB.instr = 0;
-    statePtr->MEMWB.writeDataMem = 0;
-    statePtr->MEMWB.writeDataALU = 0;
-    statePtr->MEMWB.writeReg = 0;
- }
+    for(i = 0; i < bus->count; i++){
+        if(i == sim->coreId)
+            continue;
+        cache = &bus->cores[i]->dcache;
+        lines = &cache->lines[(block & (cache->sets - 1)) * cache->ways];
+        tag = block >> cache->setShift;
+        for(way = 0; way < cache->ways; way++){
+            if(!(lines[way] & LINEVALID) || (lines[way] >> LINETAGSHIFT) != tag)
+                continue;
+            found = 1;
+            if(lines[way] & LINEDIRTY){
+                sim->counters[CTR_INTERVENTIONS]++;
+                cache->stats.writebacks++;
+                *stall += cache->latency;
+            }
+            if(invalidate){
+                sim->counters[CTR_INVALIDATIONS]++;
+                lines[way] = (tag << LINETAGSHIFT) | LINESTOLEN;
+            }
+            else
+                lines[way] &= ~(LINEDIRTY | LINEEXCLUSIVE);
+        }
+    }
+    return found;
+}
 
 
  /***************************************************************************************/
@@ -551,27 +4968,41 @@ void initState(stateType *statePtr)
  /***************************************************************************************/
 
 
+
 /*************************************************************/
-/* The printState function accepts a pointer to a state as   */
-/* an argument and prints the formatted contents of          */
-/* pipeline register.                                        */
-/* You should not modify this function.                      */
+/* The printMemories function prints the data memory and     */
+/* register file in the printState format.                   */
 /*************************************************************/
-void printState(stateType *statePtr)
+void printMemories(stateType *statePtr)
 {
-    int i;
-    printf("\n********************\nState at the beginning of cycle %d:\n", statePtr->cycles+1);
-    printf("\tPC = %d\n", statePtr->PC);
+    int i, half;
     printf("\tData Memory:\n");
-    for (i=0; i<(NUMMEMORY/2); i++) {
-        printf("\t\tdataMem[%d] = %d\t\tdataMem[%d] = %d\n",
-            i, statePtr->dataMem[i], i+(NUMMEMORY/2), statePtr->dataMem[i+(NUMMEMORY/2)]);
+    half = (statePtr->dataSize + 1)/2;
+    for (i=0; i<half; i++) {
+        if (i+half < statePtr->dataSize)
+            printf("\t\tdataMem[%d] = %d\t\tdataMem[%d] = %d\n",
+                i, statePtr->dataMem[i], i+half, statePtr->dataMem[i+half]);
+        else
+            printf("\t\tdataMem[%d] = %d\n", i, statePtr->dataMem[i]);
     }
     printf("\tRegisters:\n");
     for (i=0; i<(NUMREGS/2); i++) {
         printf("\t\tregFile[%d] = %d\t\tregFile[%d] = %d\n",
             i, statePtr->regFile[i], i+(NUMREGS/2), statePtr->regFile[i+(NUMREGS/2)]);
     }
+}
+
+/*************************************************************/
+/* The printState function accepts a pointer to a state as   */
+/* an argument and prints the formatted contents of          */
+/* pipeline register.                                        */
+/* You should not modify this function.                      */
+/*************************************************************/
+void printState(stateType *statePtr)
+{
+    printf("\n********************\nState at the beginning of cycle %lld:\n", statePtr->cycles+1);
+    printf("\tPC = %d\n", statePtr->PC);
+    printMemories(statePtr);
     printf("\tIF/ID:\n");
     printf("\t\tInstruction: ");
     printInstruction(statePtr->IFID.instr);
@@ -601,53 +5032,195 @@ void printState(stateType *statePtr)
     printf("\t\twriteReg: %d\n", statePtr->MEMWB.writeReg);
 }
 
-/*************************************************************/
-/*  The instrToInt function converts an instruction from the */
-/*  assembly file into an unsigned integer representation.   */
-/*  For example, consider the add $0,$1,$2 instruction.      */
-/*  In binary, this instruction is:                          */
-/*   000000 00001 00010 00000 00000 100000                   */
-/*  The unsigned representation in decimal is therefore:     */
-/*   2228256                                                 */
-/*************************************************************/
-unsigned int instrToInt(char* inst, char* args){
+/* Prints a superscalar pipeline like printState, one block per slot */
+void printWideState(stateType *statePtr, wideType *wide, int width)
+{
+    int i;
+
+    printf("\n********************\nState at the beginning of cycle %lld:\n", statePtr->cycles+1);
+    printf("\tPC = %d\n", statePtr->PC);
+    printMemories(statePtr);
+    for (i=0; i<width; i++) {
+        printf("\tIF/ID[%d]:\n", i);
+        printf("\t\tInstruction: ");
+        printInstruction(wide->IFID[i].instr);
+        printf("\t\tPCPlus4: %d\n", wide->IFID[i].PCPlus4);
+    }
+    for (i=0; i<width; i++) {
+        printf("\tID/EX[%d]:\n", i);
+        printf("\t\tInstruction: ");
+        printInstruction(wide->IDEX[i].instr);
+        printf("\t\tPCPlus4: %d\n", wide->IDEX[i].PCPlus4);
+        printf("\t\tbranchTarget: %d\n", wide->IDEX[i].branchTarget);
+        printf("\t\treadData1: %d\n", wide->IDEX[i].readData1);
+        printf("\t\treadData2: %d\n", wide->IDEX[i].readData2);
+        printf("\t\timmed: %d\n", wide->IDEX[i].immed);
+        printf("\t\trs: %d\n", wide->IDEX[i].rsReg);
+        printf("\t\trt: %d\n", wide->IDEX[i].rtReg);
+        printf("\t\trd: %d\n", wide->IDEX[i].rdReg);
+    }
+    for (i=0; i<width; i++) {
+        printf("\tEX/MEM[%d]:\n", i);
+        printf("\t\tInstruction: ");
+        printInstruction(wide->EXMEM[i].instr);
+        printf("\t\taluResult: %d\n", wide->EXMEM[i].aluResult);
+        printf("\t\twriteDataReg: %d\n", wide->EXMEM[i].writeDataReg);
+        printf("\t\twriteReg:%d\n", wide->EXMEM[i].writeReg);
+    }
+    for (i=0; i<width; i++) {
+        printf("\tMEM/WB[%d]:\n", i);
+        printf("\t\tInstruction: ");
+        printInstruction(wide->MEMWB[i].instr);
+        printf("\t\twriteDataMem: %d\n", wide->MEMWB[i].writeDataMem);
+        printf("\t\twriteDataALU: %d\n", wide->MEMWB[i].writeDataALU);
+        printf("\t\twriteReg: %d\n", wide->MEMWB[i].writeReg);
+    }
+}
+
+/* Prints a configurable-depth pipeline, one block per stage after the first IF */
+void printDeepState(stateType *statePtr, deepType *deep, optionsType *options)
+{
+    static const char *kinds[] = {"IF", "ID", "EX", "MEM", "WB"};
+    int counts[5];
+    int kind = 0, index = 0, s;
+
+    counts[0] = options->fetchStages;
+    counts[1] = options->decodeStages;
+    counts[2] = options->aluLatency;
+    counts[3] = options->memoryLatency;
+    counts[4] = 1;
+
+    printf("\n********************\nState at the beginning of cycle %lld:\n", statePtr->cycles+1);
+    printf("\tPC = %d\n", statePtr->PC);
+    printMemories(statePtr);
+    for (s=1; s<pipelineDepth(options); s++) {
+        if (++index == counts[kind]) {
+            kind++;
+            index = 0;
+        }
+        if (counts[kind] > 1)
+            printf("\t%s%d:\n", kinds[kind], index + 1);
+        else
+            printf("\t%s:\n", kinds[kind]);
+        printf("\t\tInstruction: ");
+        printInstruction(deep->stage[s].instr);
+        printf("\t\tPCPlus4: %d\n", deep->stage[s].PCPlus4);
+        printf("\t\tresult: %d\n", deep->stage[s].result);
+        printf("\t\tstoreData: %d\n", deep->stage[s].storeData);
+    }
+}
 
-    int opcode, rs, rt, rd, shamt, funct, immed;
-    unsigned int dec_inst;
+/* Prints the out-of-order core: the fetch buffer, the ROB from */
+/* its head, the busy reservation stations and the LSQ          */
+void printCoreState(stateType *statePtr, coreType *core, optionsType *options)
+{
+    robEntryType *entry;
+    stationType *station;
+    lsqEntryType *lsq;
+    int i, index;
 
-    if((strcmp(inst, "add") == 0) || (strcmp(inst, "sub") == 0)){
-        opcode = 0;
-        if(strcmp(inst, "add") == 0)
-            funct = ADD;
+    printf("\n********************\nState at the beginning of cycle %lld:\n", statePtr->cycles+1);
+    printf("\tPC = %d\n", statePtr->PC);
+    printMemories(statePtr);
+    printf("\tRename map:");
+    for (i=0; i<NUMREGS; i++)
+        if (core->map[i] >= 0)
+            printf(" $%d=rob%d", i, core->map[i]);
+    printf("\n\tFetch buffer:\n");
+    for (i=0; i<core->fetchCount; i++) {
+        printf("\t\tPCPlus4 %d: ", core->fetch[i].PCPlus4);
+        printInstruction(core->fetch[i].instr);
+    }
+    printf("\tReorder buffer:\n");
+    for (i=0; i<core->robCount; i++) {
+        index = (core->robHead + i) % options->robSize;
+        entry = &core->rob[index];
+        printf("\t\trob%d %s value %d: ", index, entry->done ? "done" : "busy", entry->value);
+        printInstruction(entry->instr);
+    }
+    printf("\tReservation stations:\n");
+    for (i=0; i<options->rsSize; i++) {
+        station = &core->stations[i];
+        if (station->rob < 0)
+            continue;
+        printf("\t\trob%d:", station->rob);
+        if (station->tag1 >= 0)
+            printf(" rob%d", station->tag1);
         else
-            funct = SUB;
-        shamt = 0;
-        rd = atoi(strtok(args, ",$"));
-        rs = atoi(strtok(NULL, ",$"));
-        rt = atoi(strtok(NULL, ",$"));
-        dec_inst = (opcode << 26) + (rs << 21) + (rt << 16) + (rd << 11) + (shamt << 6) + funct;
-    } else if((strcmp(inst, "lw") == 0) || (strcmp(inst, "sw") == 0)){
-        if(strcmp(inst, "lw") == 0)
-            opcode = LW;
+            printf(" %d", station->value1);
+        if (station->tag2 >= 0)
+            printf(" rob%d\n", station->tag2);
         else
-            opcode = SW;
-        rt = atoi(strtok(args, ",$"));
-        immed = atoi(strtok(NULL, ",("));
-        rs = atoi(strtok(NULL, "($)"));
-        dec_inst = (opcode << 26) + (rs << 21) + (rt << 16) + immed;
-    } else if(strcmp(inst, "bne") == 0){
-        opcode = 4;
-        rs = atoi(strtok(args, ",$"));
-        rt = atoi(strtok(NULL, ",$"));
-        immed = atoi(strtok(NULL, ","));
-        dec_inst = (opcode << 26) + (rs << 21) + (rt << 16) + immed;
-    } else if(strcmp(inst, "halt") == 0){
-        opcode = 63;
-        dec_inst = (opcode << 26);
-    } else if(strcmp(inst, "noop") == 0){
-        dec_inst = 0;
-    }
-    return dec_inst;
+            printf(" %d\n", station->value2);
+    }
+    printf("\tLoad/store queue:\n");
+    for (i=0; i<core->lsqCount; i++) {
+        lsq = &core->lsq[(core->lsqHead + i) % options->lsqSize];
+        printf("\t\trob%d %s", lsq->rob, lsq->store ? "store" : "load");
+        if (lsq->ready)
+            printf(" address %d", lsq->address);
+        if (lsq->ready && lsq->store)
+            printf(" data %d", lsq->data);
+        printf("\n");
+    }
+}
+
+/*************************************************************/
+/*  The decodeInstr function splits an instruction into its  */
+/*  fields once, so the pipeline stages can read them from   */
+/*  decodedMem instead of shifting and masking every cycle.  */
+/*  Its operands, ALU operation and flags come from opTable. */
+/*************************************************************/
+void decodeInstr(unsigned int instruction, decodedType *decoded){
+    int fields[5];
+    int i;
+
+    decoded->opcode = get_opcode(instruction);
+    decoded->rs = get_rs(instruction);
+    decoded->rt = get_rt(instruction);
+    decoded->rd = get_rd(instruction);
+    decoded->funct = get_funct(instruction);
+    decoded->shamt = get_shamt(instruction);
+    decoded->immed = get_immed(instruction);
+
+    fields[FIELD_NONE] = NOREG;
+    fields[FIELD_RS] = decoded->rs;
+    fields[FIELD_RT] = decoded->rt;
+    fields[FIELD_RD] = decoded->rd;
+    fields[FIELD_LINK] = LINKREG;
+    decoded->src1 = decoded->src2 = decoded->dest = NOREG;
+    decoded->alu = ALU_NONE;
+    decoded->flags = 0;
+    decoded->op = 0;
+    for(i = 0; instruction != 0 && i < OPCOUNT; i++){
+        if(opTable[i].opcode == decoded->opcode && (opTable[i].funct < 0 || opTable[i].funct == decoded->funct)){
+            decoded->src1 = fields[opTable[i].src1];
+            decoded->src2 = fields[opTable[i].src2];
+            decoded->dest = fields[opTable[i].dest];
+            decoded->alu = opTable[i].alu;
+            decoded->flags = opTable[i].flags;
+            decoded->op = i + 1;
+            break;
+        }
+    }
+}
+
+/* Decodes the instrSize words of instrMem into decodedMem, after its */
+/* leading NOOP. It returns -1 if an instruction names a register    */
+/* outside the register file, which the assembler would reject.      */
+int decodeProgram(unsigned int *instrMem, decodedType *decodedMem, int instrSize)
+{
+    decodedType *decoded;
+    int i;
+
+    decodeInstr(0, &decodedMem[0]);
+    for(i = 0; i < instrSize; i++){
+        decoded = &decodedMem[i + 1];
+        decodeInstr(instrMem[i], decoded);
+        if(decoded->src1 > NOREG || decoded->src2 > NOREG || decoded->dest > NOREG)
+            return -1;
+    }
+    return 0;
 }
 
 int get_rs(unsigned int instruction){
@@ -666,6 +5239,10 @@ int get_funct(unsigned int instruction){
     return(instruction & 0x3F);
 }
 
+int get_shamt(unsigned int instruction){
+    return( (instruction>>6) & 0x1F);
+}
+
 int get_immed(unsigned int instruction){
     return(instruction & 0xFFFF);
 }
@@ -678,31 +5255,53 @@ int get_opcode(unsigned int instruction){
 /*  The printInstruction decodes an unsigned     */
 /*  integer representation of an instruction     */
 /*  into its string representation and prints    */
-/*  the result to stdout.                        */
+/*  the result to stdout, in the syntax of the   */
+/*  assembler's mnemonic table.                  */
 /*************************************************/
 void printInstruction(unsigned int instr)
 {
-    char opcodeString[10];
-    if (instr == 0){
-      printf("NOOP\n");
-    } else if (get_opcode(instr) == R) {
-        if(get_funct(instr)!=0){
-            if(get_funct(instr) == ADD)
-                strcpy(opcodeString, "add");
-            else
-                strcpy(opcodeString, "sub");
-            printf("%s $%d,$%d,$%d\n", opcodeString, get_rd(instr), get_rs(instr), get_rt(instr));
-        }
-        else{
-            printf("NOOP\n");
-        }
-    } else if (get_opcode(instr) == LW) {
-        printf("%s $%d,%d($%d)\n", "lw", get_rt(instr), get_immed(instr), get_rs(instr));
-    } else if (get_opcode(instr) == SW) {
-        printf("%s $%d,%d($%d)\n", "sw", get_rt(instr), get_immed(instr), get_rs(instr));
-    } else if (get_opcode(instr) == BNE) {
-        printf("%s $%d,$%d,%d\n", "bne", get_rs(instr), get_rt(instr), get_immed(instr));
-    } else if (get_opcode(instr) == HALT) {
-        printf("%s\n", "halt");
+    mnemonicType *m;
+    int rs = get_rs(instr), rt = get_rt(instr), rd = get_rd(instr), immed = get_immed(instr);
+
+    /* The noop row would claim every R-type funct 0, which is sll */
+    for (m = mnemonicTable; m < mnemonicTable + MNEMONICS; m++)
+        if (m->name != NULL && m->opcode == get_opcode(instr) && !(m->opcode == R && m->format == FMT_NONE) &&
+            (m->opcode != R || m->funct == get_funct(instr)))
+            break;
+    if (instr == 0 || m == mnemonicTable + MNEMONICS) {
+        printf("NOOP\n");
+        return;
+    }
+    switch (m->format) {
+    case FMT_R:
+        printf("%s $%d,$%d,$%d\n", m->name, rd, rs, rt);
+        break;
+    case FMT_SHIFTV:
+        printf("%s $%d,$%d,$%d\n", m->name, rd, rt, rs);
+        break;
+    case FMT_SHIFT:
+        printf("%s $%d,$%d,%d\n", m->name, rd, rt, get_shamt(instr));
+        break;
+    case FMT_MEM:
+        printf("%s $%d,%d($%d)\n", m->name, rt, immed, rs);
+        break;
+    case FMT_BRANCH:
+        printf("%s $%d,$%d,%d\n", m->name, rs, rt, immed);
+        break;
+    case FMT_IMMED:
+        printf("%s $%d,$%d,%d\n", m->name, rt, rs, immed);
+        break;
+    case FMT_SIMMED:
+        printf("%s $%d,$%d,%d\n", m->name, rt, rs, (short)immed);
+        break;
+    case FMT_JUMP:
+        printf("%s %d\n", m->name, immed);
+        break;
+    case FMT_REG:
+        printf("%s $%d\n", m->name, rs);
+        break;
+    default:
+        printf("%s\n", m->name);
+        break;
     }
 }
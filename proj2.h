@@ -0,0 +1,477 @@
+/******************************************************************/
+/* proj2.h is the interface to the pipeline simulator library. A  */
+/* program is loaded once with loadProgram and may then be run by */
+/* any number of simulators, each created by simCreate, advanced  */
+/* by simStep or simRun and released by simDestroy. No library    */
+/* function exits the process; errors are reported through return */
+/* values and message buffers of ERRORLENGTH bytes.               */
+/******************************************************************/
+#ifndef PROJ2_H
+#define PROJ2_H
+
+#include <stdio.h>
+
+#define NUMMEMORY 16 /* Default number of words in each memory */
+#define NUMREGS 8    /* Number of registers */
+
+/* Opcode values for instructions */
+#define R 0
+#define LW 35
+#define SW 43
+#define BNE 4
+#define BEQ 5
+#define ADDI 8
+#define SLTI 10
+#define ANDI 12
+#define ORI 13
+#define XORI 14
+#define J 2
+#define JAL 3
+#define HALT 63
+
+/* Funct values for R-type instructions */
+#define ADD 32
+#define SUB 34
+#define AND 36
+#define OR 37
+#define XOR 38
+#define NOR 39
+#define SLT 42
+#define SLL 0
+#define SRL 2
+#define SRA 3
+#define SLLV 4
+#define SRLV 6
+#define SRAV 7
+#define JR 8
+#define MUL 24
+#define DIV 26
+
+#define LINKREG 7    /* Register jal writes the return address to */
+#define COREREG 6    /* Register holding each core's number when a multicore run starts */
+
+/* Register number of an operand an instruction does not have */
+#define NOREG NUMREGS
+
+/* ALU operations performed in EX */
+#define ALU_NONE 0
+#define ALU_ADD 1    /* src1 + src2 */
+#define ALU_SUB 2    /* src1 - src2 */
+#define ALU_ADDI 3   /* src1 + immed */
+#define ALU_ADDS 4   /* src1 + sign-extended immed */
+#define ALU_AND 5    /* src1 & src2 */
+#define ALU_OR 6     /* src1 | src2 */
+#define ALU_XOR 7    /* src1 ^ src2 */
+#define ALU_NOR 8    /* ~(src1 | src2) */
+#define ALU_SLT 9    /* 1 if src1 < src2, signed */
+#define ALU_SLTI 10  /* 1 if src1 < sign-extended immed */
+#define ALU_ANDI 11  /* src1 & immed */
+#define ALU_ORI 12   /* src1 | immed */
+#define ALU_XORI 13  /* src1 ^ immed */
+#define ALU_SLL 14   /* src2 << shamt */
+#define ALU_SRL 15   /* src2 >> shamt, logical */
+#define ALU_SRA 16   /* src2 >> shamt, arithmetic */
+#define ALU_SLLV 17  /* src2 << src1, by the low 5 bits of src1 */
+#define ALU_SRLV 18  /* src2 >> src1, logical */
+#define ALU_SRAV 19  /* src2 >> src1, arithmetic */
+#define ALU_EQ 20    /* 1 if src1 == src2 */
+#define ALU_LINK 21  /* PC + 4 */
+#define ALU_PASS 22  /* src1 */
+#define ALU_MUL 23   /* src1 * src2, low 32 bits */
+#define ALU_DIV 24   /* src1 / src2, 0 when dividing by 0 */
+
+/* How an instruction uses the datapath beyond the ALU */
+#define OP_LOAD 1      /* Reads data memory; the result is ready only after MEM */
+#define OP_STORE 2     /* Writes src2 to data memory */
+#define OP_BRANCH 4    /* Resolved in EX, taken if the ALU result is not zero */
+#define OP_HALT 8
+#define OP_JUMP 16     /* Redirects fetch to immed when decoded, so it never mispredicts */
+#define OP_INDIRECT 32 /* Jumps to the ALU result once EX computes it, flushing what follows */
+#define OP_LONG 64     /* Occupies a multiply or divide unit for several cycles */
+
+#define MULLATENCY 3   /* Default cycles of the multiply unit */
+#define DIVLATENCY 10  /* Default cycles of the divide unit, which is not pipelined */
+
+/* Trace file identification */
+#define TRACEMAGIC "PIPETRCE"
+#define TRACEVERSION 3
+
+/* Events recorded for a cycle in a trace */
+#define TRACE_LOADUSE 1    /* ID inserted a load-use bubble */
+#define TRACE_SQUASH 2     /* ID squashed the fetch behind a predicted-taken branch */
+#define TRACE_FLUSH 4      /* EX flushed IF/ID and ID/EX after a misprediction */
+#define TRACE_MEMORY 8     /* The pipeline was frozen by a cache miss */
+#define TRACE_HALT 16      /* The HALT reached MEM/WB and the simulation stopped */
+#define TRACE_UNITBUSY 32  /* EX held a multiply or divide for another cycle */
+
+/* What a traced write changed */
+#define TRACE_REG 0        /* regFile[index] = value */
+#define TRACE_MEM 1        /* dataMem[index] = value */
+
+/* Performance counters, indexes into the counters of resultsType. */
+/* Every counter has a name, given by counterName.                 */
+#define CTR_RETIRED 0          /* Instructions that completed WB, NOOPs and HALT excluded */
+#define CTR_LOADUSE 1          /* Bubbles inserted by load-use stalls */
+#define CTR_TAKENBUBBLES 2     /* Fetches squashed behind a branch predicted taken in ID */
+#define CTR_FLUSHBUBBLES 3     /* Instructions squashed by mispredictions */
+#define CTR_MEMORY 4           /* Cycles frozen by cache misses */
+#define CTR_FWDEXMEM 5         /* EX operands forwarded from EX/MEM */
+#define CTR_FWDMEMWB 6         /* EX operands forwarded from MEM/WB */
+#define CTR_FWDWB 7            /* ID operands bypassed from the write-back */
+#define CTR_BRANCHES 8         /* Branches resolved in EX */
+#define CTR_TAKEN 9            /* Of which taken */
+#define CTR_MISPREDICTED 10    /* Of which mispredicted */
+#define CTR_MISSEDTAKEN 11     /* Taken branches that were predicted not taken */
+#define CTR_DEPENDENCY 12      /* Superscalar issue slots lost to a dependency inside the bundle, */
+                               /* or stalls for a multi-cycle ALU result in a deeper pipeline     */
+#define CTR_STRUCTURAL 13      /* Superscalar issue slots lost to register file and memory ports */
+#define CTR_ROBFULL 14         /* Out-of-order dispatch slots lost to a full reorder buffer */
+#define CTR_RSFULL 15          /* ... to full reservation stations */
+#define CTR_LSQFULL 16         /* ... to a full load/store queue */
+#define CTR_STOREFORWARD 17    /* Loads given their data by an older store in the LSQ */
+#define CTR_UNITBUSY 18        /* Stalls, or for a superscalar pipeline issue slots, lost while EX */
+                               /* holds a multiply or divide; cycles a ready divide waited for    */
+                               /* the divider in the out-of-order core                            */
+#define CTR_BUSREAD 19         /* Data cache read misses put on the bus of a multicore run */
+#define CTR_BUSREADX 20        /* Write misses, which invalidate every other copy of the line */
+#define CTR_UPGRADES 21        /* Writes hitting a shared line, which invalidate the other copies */
+#define CTR_INVALIDATIONS 22   /* Copies invalidated in other cores' caches */
+#define CTR_INTERVENTIONS 23   /* Modified lines another cache had to write back for a request */
+#define CTR_SHARINGMISSES 24   /* Misses on a line lost to another core's write */
+#define CTR_OPCODE 25          /* First of MAXOPCODES counters of retired instructions, */
+                               /* one per instruction of the instruction table         */
+#define MAXOPCODES 32
+#define NUMCOUNTERS (CTR_OPCODE + MAXOPCODES)
+
+/* Branch Prediction Buffer Values */
+#define STRONGLYTAKEN 3
+#define WEAKLYTAKEN 2
+#define WEAKLYNOTTAKEN 1
+#define STRONGLYNOTTAKEN 0
+
+/* Branch predictor kinds */
+#define PRED_GLOBAL 0      /* One 2-bit counter shared by every branch */
+#define PRED_LOCAL 1       /* Pattern history table of 2-bit counters indexed by PC */
+#define PRED_BTB 2         /* Tagged branch target buffer, predicts at fetch */
+#define PRED_GSHARE 3      /* 2-bit counters indexed by PC xor global history */
+#define PRED_TOURNAMENT 4  /* Chooser between the local and gshare predictors */
+
+#define PREDTABLESIZE 1024 /* Default number of entries in each predictor table */
+#define HISTORYBITS 10     /* Default global history length */
+
+/* Cache replacement and write policies */
+#define CACHE_LRU 0        /* Least recently used */
+#define CACHE_PLRU 1       /* Tree pseudo-LRU */
+#define WRITEBACK 0        /* Stores dirty the line, evictions write it back */
+#define WRITETHROUGH 1     /* Stores go straight to memory, no allocation on a store miss */
+
+#define MISSLATENCY 10     /* Default cycles the pipeline freezes on a cache miss */
+
+/* Coherence protocols of the data caches of a multicore run */
+#define COHERENCE_MSI 0    /* Modified, shared, invalid */
+#define COHERENCE_MESI 1   /* Adds exclusive, so a private line is written without a bus transaction */
+
+#define MAXCORES 64        /* Most cores of a multicore run */
+#define QUANTUM 100        /* Default cycles cores run in parallel between synchronizations */
+
+#define MAXWIDTH 4         /* Widest superscalar pipeline */
+#define MAXDEPTH 16        /* Most stages of a configurable-depth pipeline */
+
+/* Default sizes of the out-of-order core */
+#define ROBSIZE 32         /* Reorder buffer entries */
+#define RSSIZE 16          /* Reservation stations */
+#define LSQSIZE 16         /* Load/store queue entries */
+
+#define SAMPLEWARMUP 2000  /* Default instructions simulated in detail before each sampled window */
+#define CONFIDENCE 3.0     /* Standard deviations of a sampling confidence interval, 99.7% */
+#define SNAPSHOTINTERVAL 1000  /* Cycles between the snapshots of a debugged run */
+#define SNAPSHOTS 64       /* Snapshots a debugged run keeps, the older ones ever further apart */
+#define UNDOWRITES (1 << 20)  /* Undo log entries past which a debugged run drops its oldest snapshots */
+
+/* Output modes */
+#define VERBOSE 0    /* Print the state at the beginning of every cycle */
+#define QUIET 1      /* Print only the final statistics */
+#define INTERVAL 2   /* Print the state every N cycles */
+#define EVENTS 3     /* Print the state only after selected events */
+
+/* Events that trigger a state dump in EVENTS mode */
+#define EVENT_STALL 1
+#define EVENT_MISPREDICT 2
+#define EVENT_HALT 4
+
+/* Simulator status, returned by simStep and simRun */
+#define SIM_RUNNING 0       /* More cycles remain */
+#define SIM_HALTED 1        /* The HALT reached MEM/WB, or a functional run finished */
+#define SIM_CHECKPOINTED 2  /* Stopped after writing the requested checkpoint */
+#define SIM_ERROR -1        /* Stopped on an error, see simGetError */
+
+#define ERRORLENGTH 256     /* Size of an error message buffer */
+#define SYMBOLLENGTH 32     /* Longest label, plus one */
+
+typedef struct decodedStruct {
+  unsigned char opcode;            /* Opcode field */
+  unsigned char rs;                /* rs register field */
+  unsigned char rt;                /* rt register field */
+  unsigned char rd;                /* rd register field */
+  unsigned char funct;             /* Funct field of R-type instructions */
+  unsigned short immed;            /* Immediate field */
+  unsigned char shamt;             /* Shift amount field of R-type instructions */
+  unsigned char src1;              /* First register read, NOREG if none */
+  unsigned char src2;              /* Second register read, NOREG if none */
+  unsigned char dest;              /* Register written, NOREG if none */
+  unsigned char alu;               /* ALU_* operation performed in EX */
+  unsigned char flags;             /* OP_* uses of the rest of the datapath */
+  unsigned char op;                /* Instruction table row + 1, 0 for NOOP */
+} decodedType;
+
+typedef struct IFIDStruct {
+  unsigned int instr;              /* Integer representation of instruction */
+  int uop;                         /* Index into decodedMem, 0 for NOOP */
+  int PCPlus4;                     /* PC + 4 */
+  int bpb;                         /* 1 if the branch predictor predicted taken */
+} IFIDType;
+
+typedef struct IDEXStruct {
+  unsigned int instr;              /* Integer representation of instruction */
+  int uop;                         /* Index into decodedMem, 0 for NOOP */
+  int PCPlus4;                     /* PC + 4 */
+  int readData1;                   /* Contents of rs register */
+  int readData2;                   /* Contents of rt register */
+  int immed;                       /* Immediate field */
+  int rsReg;                       /* Number of rs register */
+  int rtReg;                       /* Number of rt register */
+  int rdReg;                       /* Number of rd register */
+  int branchTarget;                /* Branch target, obtained from immediate field */
+  int bpb;                         /* Branch prediction carried from IF/ID */
+  int busy;                        /* Cycles a multiply or divide has spent in EX so far */
+} IDEXType;
+
+typedef struct EXMEMStruct {
+  unsigned int instr;              /* Integer representation of instruction */
+  int uop;                         /* Index into decodedMem, 0 for NOOP */
+  int aluResult;                   /* Result of ALU operation */
+  int writeDataReg;                /* Contents of the rt register, used for store word */
+  int writeReg;                    /* The destination register */
+  int bpb;                         /* Branch prediction carried from ID/EX */
+} EXMEMType;
+
+typedef struct MEMWBStruct {
+  unsigned int instr;              /* Integer representation of instruction */
+  int uop;                         /* Index into decodedMem, 0 for NOOP */
+  int writeDataMem;                /* Data read from memory */
+  int writeDataALU;                /* Result from ALU operation */
+  int writeReg;                    /* The destination register */
+  int bpb;                         /* Branch prediction carried from EX/MEM */
+} MEMWBType;
+
+/* The state of a scalar pipeline. A superscalar or deeper pipeline */
+/* or the out-of-order core keeps its own latches privately and     */
+/* leaves IFID to MEMWB empty.                                      */
+typedef struct stateStruct {
+  int PC;                                 /* Program Counter */
+  unsigned int *instrMem;                 /* Instruction memory, instrSize words */
+  int *dataMem;                           /* Data memory, dataSize words */
+  decodedType *decodedMem;                /* Pre-decoded instrMem, shifted by one so entry 0 is a NOOP */
+  int instrSize;                          /* Number of words in instruction memory */
+  int dataSize;                           /* Number of words in data memory */
+  int *regFile;                           /* Register file, NUMREGS words */
+  IFIDType IFID;                          /* Current IFID pipeline register */
+  IDEXType IDEX;                          /* Current IDEX pipeline register */
+  EXMEMType EXMEM;                        /* Current EXMEM pipeline register */
+  MEMWBType MEMWB;                        /* Current MEMWB pipeline register */
+  long long cycles;                       /* Number of cycles executed so far */
+  //unsigned int bpb;
+} stateType;
+
+typedef struct optionsStruct {
+  int outputMode;                         /* VERBOSE, QUIET, INTERVAL or EVENTS */
+  int dumpInterval;                       /* Cycles between dumps in INTERVAL mode */
+  int dumpEvents;                         /* EVENT_* bits that trigger a dump in EVENTS mode */
+  int instrSize;                          /* Words of instruction memory */
+  int dataSize;                           /* Words of data memory */
+  int predictorKind;                      /* PRED_* branch predictor */
+  int predictorSize;                      /* Entries per predictor table, a power of two */
+  int historyBits;                        /* Global history length for gshare and tournament */
+  int functional;                         /* 1 to execute the whole program functionally */
+  long long fastForward;                  /* Instructions to execute functionally first, -1 for none */
+  int marker;                             /* Switch to the pipeline at this PC, -1 for none */
+  char *checkpointFile;                   /* Write a checkpoint here and stop, or NULL */
+  long long checkpointCycle;              /* Cycle at whose beginning the checkpoint is written */
+  char *restoreFile;                      /* Resume from this checkpoint instead of stdin, or NULL */
+  char *sweepFile;                        /* Run every configuration listed here, or NULL */
+  int threads;                            /* Simulations run in parallel by a sweep */
+  int icacheSize;                         /* Bytes of instruction cache, 0 for none */
+  int icacheWays;                         /* Instruction cache associativity */
+  int icacheLine;                         /* Instruction cache line size in bytes */
+  int dcacheSize;                         /* Bytes of data cache, 0 for none */
+  int dcacheWays;                         /* Data cache associativity */
+  int dcacheLine;                         /* Data cache line size in bytes */
+  int missLatency;                        /* Cycles the pipeline freezes on a miss */
+  int replacement;                        /* CACHE_LRU or CACHE_PLRU */
+  int writePolicy;                        /* WRITEBACK or WRITETHROUGH */
+  char *countersFile;                     /* Export the counters here, "-" for stdout, or NULL */
+  char *traceFile;                        /* Record a binary trace here, or NULL */
+  char *imageCache;                       /* Directory caching program images by source hash, or NULL */
+  char *imageFile;                        /* Write the program image here and stop, or NULL */
+  int width;                              /* Instructions per pipeline stage, 1 to MAXWIDTH */
+  int readPorts;                          /* Register file reads per cycle, 0 for 2 * width */
+  int writePorts;                         /* Register file writes per cycle, 0 for width */
+  int memoryPorts;                        /* Loads and stores per cycle, 0 for width */
+  int outOfOrder;                         /* 1 for the out-of-order core, width wide */
+  int robSize;                            /* Reorder buffer entries */
+  int rsSize;                             /* Reservation stations */
+  int lsqSize;                            /* Load/store queue entries */
+  int fetchStages;                        /* Pipeline stages of each kind, 1 each for the */
+  int decodeStages;                       /* classic 5-stage pipeline */
+  int aluLatency;                         /* EX stages, so cycles an ALU result takes (default 1) */
+  int memoryLatency;                      /* MEM stages, so cycles a data access takes (default 1) */
+  int resolveStage;                       /* Stage resolving branches, from 1 for the first IF; 0 for the first EX */
+  int mulLatency;                         /* Cycles of the multiply unit, pipelined */
+  int divLatency;                         /* Cycles of the divide unit, not pipelined */
+  int check;                              /* 1 to check every retirement against a reference interpreter */
+  int cores;                              /* Scalar pipelines sharing the data memory, 1 to MAXCORES */
+  int coreThreads;                        /* Host threads stepping the cores, 1 to interleave them cycle by cycle */
+  int quantum;                            /* Cycles cores run in parallel between synchronizations */
+  int coherence;                          /* COHERENCE_MSI or COHERENCE_MESI */
+  long long sampleUnit;                   /* Instructions measured in each sampled window, 0 to simulate everything */
+  long long samplePeriod;                 /* Instructions from one window to the next */
+  long long sampleWarmup;                 /* Instructions simulated in detail before each window */
+  int snapshotInterval;                   /* Cycles between snapshots of a run that can be rewound, 0 for none */
+  char *debugFile;                        /* Debug the program in this file interactively, or NULL */
+} optionsType;
+
+/* A label and the byte address it stands for */
+typedef struct symbolStruct {
+  char name[SYMBOLLENGTH];                /* NUL terminated */
+  int address;
+} symbolType;
+
+/* The assembled program. It is read once and shared, read-only, by */
+/* every simulation that runs it.                                   */
+typedef struct programStruct {
+  unsigned int *instrMem;                 /* Instruction memory, instrSize words */
+  decodedType *decodedMem;                /* Pre-decoded instrMem, entry 0 is a NOOP */
+  int *dataMem;                           /* Initial data memory, dataSize words */
+  int instrSize;                          /* Words of instruction memory */
+  int dataSize;                           /* Words of data memory */
+  symbolType *symbols;                    /* Labels defined by the program */
+  int symbolCount;
+  char *image;                            /* Program image the pointers above point into, or NULL */
+  size_t imageSize;
+  int imageMapped;                        /* 1 if image is a mapping rather than malloc'ed */
+} programType;
+
+/* A trace file holds a traceHeaderType, the register file and data */
+/* memory when tracing started (numRegs and dataSize ints), and then */
+/* for every cycle a traceCycleType followed by its writes. A cycle   */
+/* record holds the state at the beginning of the cycle; its writes   */
+/* are applied during the cycle.                                      */
+typedef struct traceHeaderStruct {
+  char magic[8];                          /* TRACEMAGIC */
+  int version;                            /* TRACEVERSION */
+  int cycleBytes;                         /* sizeof(traceCycleType) of the writer */
+  int numRegs;                            /* NUMREGS */
+  int dataSize;                           /* Words of data memory */
+} traceHeaderType;
+
+typedef struct traceCycleStruct {
+  long long cycles;                       /* Cycles executed before this one */
+  int PC;
+  unsigned char events;                   /* TRACE_* events of the cycle */
+  unsigned char writes;                   /* Number of traceWriteType that follow */
+  unsigned short unused;
+  IFIDType IFID;
+  IDEXType IDEX;
+  EXMEMType EXMEM;
+  MEMWBType MEMWB;
+} traceCycleType;
+
+typedef struct traceWriteStruct {
+  int kind;                               /* TRACE_REG or TRACE_MEM */
+  int index;
+  int value;
+} traceWriteType;
+
+/* A register or data memory write of a debugged run */
+typedef struct writeStruct {
+  long long cycles;                       /* Cycles executed before the one that wrote */
+  int kind;                               /* TRACE_REG or TRACE_MEM */
+  int index;
+  int oldValue;                           /* Value overwritten */
+  int value;                              /* Value written */
+} writeType;
+
+/* Activity of one cache */
+typedef struct cacheStatsStruct {
+  long long accesses;                     /* Lookups, 0 if the cache is disabled */
+  long long hits;
+  long long misses;
+  long long evictions;                    /* Valid lines replaced */
+  long long writebacks;                   /* Dirty lines written back, or stores written through */
+} cacheStatsType;
+
+/* Estimates of a sampled run. Each is the mean over the measured  */
+/* windows, with the half-width of its CONFIDENCE interval; an     */
+/* error is -1 when fewer than two windows were measured.          */
+typedef struct samplingStruct {
+  int windows;                            /* Windows measured */
+  long long unit;                         /* Instructions per window */
+  long long period;                       /* Instructions from one window to the next */
+  double cpi, cpiError;                   /* Cycles per instruction */
+  double stallRate, stallError;           /* Stalls per instruction */
+  double mispredictRate, mispredictError; /* Mispredictions per branch, a ratio of the window totals */
+} samplingType;
+
+/* What a simulation reports when it finishes */
+typedef struct resultsStruct {
+  long long cycles;                       /* Cycles executed by the pipeline, by the slowest core of a multicore run */
+  long long stalls;                       /* Bubbles inserted by the pipeline */
+  long long branches;                     /* Branches resolved by the pipeline */
+  long long mispredictions;               /* Of which mispredicted */
+  int predictorKind;                      /* PRED_* */
+  int predictorSize;                      /* Entries per predictor table */
+  long long instructions;                 /* Instructions executed functionally */
+  int functional;                         /* 1 if the run never entered the pipeline */
+  int checkpointed;                       /* 1 if the run stopped to write a checkpoint */
+  long long memoryStalls;                 /* Cycles the pipeline was frozen by cache misses */
+  int width;                              /* Instructions per pipeline stage */
+  int outOfOrder;                         /* 1 if the out-of-order core ran */
+  int depth;                              /* Pipeline stages */
+  long long counters[NUMCOUNTERS];        /* Performance counters, CTR_* */
+  cacheStatsType icache;                  /* Instruction cache activity */
+  cacheStatsType dcache;                  /* Data cache activity */
+  int cores;                              /* Cores of a multicore run, 1 otherwise */
+  int coherence;                          /* COHERENCE_* of a multicore run */
+  long long coreCycles[MAXCORES];         /* Cycles each core ran, up to its HALT */
+  long long coreRetired[MAXCORES];        /* Instructions each core retired */
+  samplingType sampling;                  /* Estimates of a sampled run, no windows otherwise */
+} resultsType;
+
+/* A running simulation. Its contents are private to proj2.c. */
+typedef struct simulatorStruct simulatorType;
+
+simulatorType *simCreate(optionsType*, programType*);
+int simStep(simulatorType*, long long);
+int simRun(simulatorType*);
+void simGetResults(simulatorType*, resultsType*);
+stateType *simGetState(simulatorType*);
+int simGetStatus(simulatorType*);
+const char *simGetError(simulatorType*);
+void simDestroy(simulatorType*);
+int simGetEvents(simulatorType*);
+int simGetWrites(simulatorType*, writeType**);
+int simRewind(simulatorType*, long long, char*);
+long long simRewindStart(simulatorType*);
+const char *counterName(int);
+int loadProgram(programType*, optionsType*, FILE*, char*);
+int loadProgramString(programType*, optionsType*, const char*, char*);
+void freeProgram(programType*);
+int writeImage(programType*, char*, unsigned long long, char*);
+void defaultOptions(optionsType*);
+int pipelineDepth(optionsType*);
+int deepPipeline(optionsType*);
+void printState(stateType*);
+void printMemories(stateType*);
+void printInstruction(unsigned int);
+
+#endif
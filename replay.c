@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "proj2.h"
+
+/******************************************************************/
+/* replay reads a binary trace recorded with -T and renders a     */
+/* range of cycles in the printState format, or with -s as one    */
+/* summary line per cycle. Cycles are numbered as in printState,  */
+/* from 1. The register file and data memory are rebuilt by       */
+/* applying the traced writes, so earlier cycles are only read,   */
+/* never printed.                                                 */
+/*   replay [-s] trace [first [last]]                             */
+/******************************************************************/
+
+void printSummary(traceCycleType *record)
+{
+    static const char *names[] = {"load-use", "squash", "flush", "memory", "halt", "unit-busy"};
+    unsigned int uops[4];
+    int i;
+
+    uops[0] = record->IFID.instr;
+    uops[1] = record->IDEX.instr;
+    uops[2] = record->EXMEM.instr;
+    uops[3] = record->MEMWB.instr;
+    printf("%8lld  PC %-6d", record->cycles + 1, record->PC);
+    for(i = 0; i < 4; i++)
+        printf("  %08x", uops[i]);
+    for(i = 0; i < 6; i++)
+        if(record->events & (1 << i))
+            printf("  %s", names[i]);
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    traceHeaderType header;
+    traceCycleType record;
+    traceWriteType writes[256];
+    stateType state;
+    FILE *file;
+    int summary = 0;
+    int first = 1, last = -1;
+    int arg = 1;
+    int i;
+
+    if(arg < argc && strcmp(argv[arg], "-s") == 0){
+        summary = 1;
+        arg++;
+    }
+    if(arg >= argc || argc - arg > 3){
+        fprintf(stderr, "usage: %s [-s] trace [first [last]]\n", argv[0]);
+        exit(1);
+    }
+    if(arg + 1 < argc)
+        first = atoi(argv[arg + 1]);
+    if(arg + 2 < argc)
+        last = atoi(argv[arg + 2]);
+
+    file = fopen(argv[arg], "rb");
+    if(file == NULL){
+        fprintf(stderr, "error: cannot open trace %s\n", argv[arg]);
+        exit(1);
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, TRACEMAGIC, 8) != 0 ||
+       header.version != TRACEVERSION || header.cycleBytes != sizeof(traceCycleType) ||
+       header.numRegs != NUMREGS || header.dataSize < 1){
+        fprintf(stderr, "error: %s is not a trace written by this simulator\n", argv[arg]);
+        exit(1);
+    }
+
+    memset(&state, 0, sizeof(state));
+    state.dataSize = header.dataSize;
+    state.regFile = malloc(sizeof(int) * NUMREGS);
+    state.dataMem = malloc(sizeof(int) * header.dataSize);
+    if(state.regFile == NULL || state.dataMem == NULL){
+        fprintf(stderr, "error: cannot allocate %d words of data memory\n", header.dataSize);
+        exit(1);
+    }
+    if(fread(state.regFile, sizeof(int), NUMREGS, file) != NUMREGS ||
+       fread(state.dataMem, sizeof(int), header.dataSize, file) != (size_t)header.dataSize){
+        fprintf(stderr, "error: trace %s is truncated\n", argv[arg]);
+        exit(1);
+    }
+
+    while(fread(&record, sizeof(record), 1, file) == 1){
+        if(fread(writes, sizeof(traceWriteType), record.writes, file) != record.writes){
+            fprintf(stderr, "error: trace %s is truncated\n", argv[arg]);
+            exit(1);
+        }
+        if(last >= 0 && record.cycles + 1 > last)
+            break;
+        if(record.cycles + 1 >= first){
+            if(summary)
+                printSummary(&record);
+            else{
+                state.PC = record.PC;
+                state.cycles = record.cycles;
+                state.IFID = record.IFID;
+                state.IDEX = record.IDEX;
+                state.EXMEM = record.EXMEM;
+                state.MEMWB = record.MEMWB;
+                printState(&state);
+            }
+        }
+        for(i = 0; i < record.writes; i++){
+            if(writes[i].kind == TRACE_REG && writes[i].index >= 0 && writes[i].index < NUMREGS)
+                state.regFile[writes[i].index] = writes[i].value;
+            else if(writes[i].kind == TRACE_MEM && writes[i].index >= 0 && writes[i].index < header.dataSize)
+                state.dataMem[writes[i].index] = writes[i].value;
+        }
+    }
+    fclose(file);
+    free(state.regFile);
+    free(state.dataMem);
+    return(0);
+}